@@ -0,0 +1,117 @@
+#pragma warning(push, 0)
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Button.H>
+#include <FL/Fl_Box.H>
+#include <FL/Fl_Widget.H>
+#pragma warning(pop)
+
+#include "themes.h"
+#include "widgets.h"
+#include "advisor-window.h"
+
+Advisor_Window::Advisor_Window(int x, int y, int w, int h, const char *t) : _dx(x), _dy(y), _width(w), _height(h),
+	_title(t), _window(NULL), _body(NULL), _ok_button(NULL), _spacer(NULL), _advisor(), _subjects(), _content() {}
+
+Advisor_Window::~Advisor_Window() {
+	delete _window;
+	delete _body;
+	delete _ok_button;
+	delete _spacer;
+}
+
+static bool same_subject(const Compression_Subject &a, const Compression_Subject &b) {
+	return a.name == b.name && a.plain == b.plain && a.rle == b.rle;
+}
+
+void Advisor_Window::update(const std::vector<Compression_Subject> &subjects) {
+	bool changed = subjects.size() != _subjects.size();
+	// Forget subjects that are gone
+	for (const Compression_Subject &old : _subjects) {
+		if (std::none_of(RANGE(subjects), [&](const Compression_Subject &s) { return s.name == old.name; })) {
+			_advisor.forget(old.name);
+			changed = true;
+		}
+	}
+	// Only re-encode subjects whose bytes changed since the last update
+	for (const Compression_Subject &s : subjects) {
+		auto old = std::find_if(RANGE(_subjects), [&](const Compression_Subject &o) { return o.name == s.name; });
+		if (old == _subjects.end() || !same_subject(*old, s)) {
+			_advisor.start(s);
+			changed = true;
+		}
+	}
+	if (changed) {
+		_subjects = subjects;
+	}
+	if (_advisor.poll() || changed) {
+		refresh();
+	}
+}
+
+void Advisor_Window::poll() {
+	if (_advisor.poll()) {
+		refresh();
+	}
+}
+
+void Advisor_Window::initialize() {
+	if (_window) { return; }
+	Fl_Group *prev_current = Fl_Group::current();
+	Fl_Group::current(NULL);
+	// Populate window
+	_window = new Fl_Double_Window(_dx, _dy, _width, _height, _title);
+	_body = new HTML_View(10, 10, _width-20, _height-52);
+	_ok_button = new Default_Button(_width-90, _height-32, 80, 22, "OK");
+	_spacer = new Fl_Box(10, 10, _width-110, _height-52);
+	_window->end();
+	// Initialize window
+	_window->box(OS_BG_BOX);
+	_window->resizable(_spacer);
+	_window->callback((Fl_Callback *)close_cb, this);
+	// Initialize window's children
+	_ok_button->tooltip("OK (Enter)");
+	_ok_button->callback((Fl_Callback *)close_cb, this);
+	Fl_Group::current(prev_current);
+}
+
+void Advisor_Window::refresh() {
+	if (!_window) { return; }
+	_window->label(_title ? _title : "Compression Advisor");
+	if (_subjects.empty()) {
+		_content = "<p>Open a tilemap or load a tileset to compare encodings.</p>";
+	}
+	else {
+		_content = compression_report(_advisor.estimates(), true);
+		_content += "<p><small>Sizes are exact. Cycle counts are rough estimates for the reference decoders, "
+			"only meant for ranking encodings of the same data.";
+		if (_advisor.busy()) {
+			_content += " Still compressing\xe2\x80\xa6";
+		}
+		_content += "</small></p>";
+	}
+	int top = _body->topline();
+	_body->value(_content.c_str());
+	_body->topline(top);
+}
+
+void Advisor_Window::show(const Fl_Widget *p) {
+	initialize();
+	refresh();
+	Fl_Window *prev_grab = Fl::grab();
+	_window->position(p->x() + _dx, p->y() + _dy);
+	Fl::grab(NULL);
+	_window->show();
+	Fl::grab(prev_grab);
+}
+
+void Advisor_Window::redraw() {
+	if (!_window) { return; }
+	_body->textsize(_body->textsize()); // roundabout way of calling private function format()
+	_window->redraw();
+}
+
+void Advisor_Window::close_cb(Fl_Widget *, Advisor_Window *aw) {
+	aw->_window->hide();
+}
@@ -0,0 +1,42 @@
+#ifndef ADVISOR_WINDOW_H
+#define ADVISOR_WINDOW_H
+
+#include <string>
+#include <vector>
+
+#pragma warning(push, 0)
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Box.H>
+#pragma warning(pop)
+
+#include "widgets.h"
+#include "compression-advisor.h"
+
+class Advisor_Window {
+private:
+	int _dx, _dy, _width, _height;
+	const char *_title;
+	Fl_Double_Window *_window;
+	HTML_View *_body;
+	Default_Button *_ok_button;
+	Fl_Box *_spacer;
+	Compression_Advisor _advisor;
+	std::vector<Compression_Subject> _subjects;
+	std::string _content;
+public:
+	Advisor_Window(int x, int y, int w, int h, const char *t = NULL);
+	~Advisor_Window();
+	inline bool visible(void) const { return _window && _window->visible(); }
+	void update(const std::vector<Compression_Subject> &subjects);
+	void poll(void);
+private:
+	void initialize(void);
+	void refresh(void);
+public:
+	void show(const Fl_Widget *p);
+	void redraw(void);
+private:
+	static void close_cb(Fl_Widget *w, Advisor_Window *aw);
+};
+
+#endif
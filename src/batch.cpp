@@ -0,0 +1,153 @@
+#include <cctype>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "utils.h"
+#include "batch.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsed_seconds(Clock::time_point start) {
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static bool split_manifest_line(const std::string &line, std::vector<std::string> &args) {
+	size_t i = 0, n = line.size();
+	for (;;) {
+		while (i < n && isspace((uchar)line[i])) { i++; }
+		if (i == n || line[i] == '#') { return true; }
+		std::string arg;
+		bool quoted = false;
+		for (; i < n && (quoted || !isspace((uchar)line[i])); i++) {
+			char c = line[i];
+			if (c == '"') { quoted = !quoted; continue; }
+			if (quoted && c == '\\' && i + 1 < n && (line[i+1] == '"' || line[i+1] == '\\')) { c = line[++i]; }
+			arg += c;
+		}
+		if (quoted) { return false; }
+		args.push_back(arg);
+	}
+}
+
+bool read_batch_manifest(const char *f, std::vector<Batch_Job> &jobs, std::string &error) {
+	std::ifstream ifs;
+	open_ifstream(ifs, f);
+	if (!ifs.good()) {
+		error = std::string("Cannot open ") + f;
+		return false;
+	}
+	std::string line;
+	for (size_t ln = 1; std::getline(ifs, line); ln++) {
+		if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+		Batch_Job job;
+		job.line = ln;
+		if (!split_manifest_line(line, job.args)) {
+			error = std::string(f) + ":" + std::to_string(ln) + ": Unterminated quote";
+			return false;
+		}
+		if (!job.args.empty()) {
+			jobs.push_back(job);
+		}
+	}
+	return true;
+}
+
+// Each worker starts with its own share of the jobs, then steals from the back of the others' queues
+class Job_Queue {
+private:
+	std::mutex _mutex;
+	std::deque<size_t> _jobs;
+public:
+	inline void push(size_t j) { _jobs.push_back(j); }
+	bool pop(size_t &j) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_jobs.empty()) { return false; }
+		j = _jobs.front();
+		_jobs.pop_front();
+		return true;
+	}
+	bool steal(size_t &j) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_jobs.empty()) { return false; }
+		j = _jobs.back();
+		_jobs.pop_back();
+		return true;
+	}
+};
+
+static void run_worker(size_t w, std::vector<Job_Queue> &queues, std::vector<Batch_Job> &jobs, Batch_Job_Cb cb,
+	void *data) {
+	size_t nq = queues.size();
+	for (;;) {
+		size_t j;
+		bool found = queues[w].pop(j);
+		// Jobs never add more jobs, so once every queue is empty the worker is done
+		for (size_t k = 1; !found && k < nq; k++) {
+			found = queues[(w + k) % nq].steal(j);
+		}
+		if (!found) { return; }
+		Clock::time_point start = Clock::now();
+		cb(jobs[j], data);
+		jobs[j].seconds = elapsed_seconds(start);
+	}
+}
+
+void run_batch_jobs(std::vector<Batch_Job> &jobs, int threads, Batch_Job_Cb cb, void *data) {
+	if (jobs.empty()) { return; }
+	size_t nw = std::clamp((size_t)std::max(threads, 1), (size_t)1, jobs.size());
+	std::vector<Job_Queue> queues(nw);
+	for (size_t j = 0; j < jobs.size(); j++) {
+		queues[j % nw].push(j);
+	}
+	std::vector<std::thread> workers;
+	for (size_t w = 1; w < nw; w++) {
+		workers.emplace_back(run_worker, w, std::ref(queues), std::ref(jobs), cb, data);
+	}
+	run_worker(0, queues, jobs, cb, data);
+	for (std::thread &t : workers) {
+		t.join();
+	}
+}
+
+static void write_json_string(FILE *file, const std::string &s) {
+	fputc('"', file);
+	for (char c : s) {
+		switch (c) {
+		case '"': fputs("\\\"", file); break;
+		case '\\': fputs("\\\\", file); break;
+		case '\n': fputs("\\n", file); break;
+		case '\r': fputs("\\r", file); break;
+		case '\t': fputs("\\t", file); break;
+		default:
+			if ((uchar)c < 0x20) { fprintf(file, "\\u%04x", (uchar)c); }
+			else { fputc(c, file); }
+		}
+	}
+	fputc('"', file);
+}
+
+void write_batch_summary(FILE *file, const char *manifest, const std::vector<Batch_Job> &jobs, int threads,
+	double seconds) {
+	size_t failed = std::count_if(RANGE(jobs), [](const Batch_Job &job) { return job.status != 0; });
+	fputs("{\n\t\"manifest\": ", file);
+	write_json_string(file, manifest);
+	fprintf(file, ",\n\t\"threads\": %d,\n\t\"seconds\": %.6f,\n", threads, seconds);
+	fprintf(file, "\t\"succeeded\": %zu,\n\t\"failed\": %zu,\n\t\"jobs\": [", jobs.size() - failed, failed);
+	for (size_t j = 0; j < jobs.size(); j++) {
+		const Batch_Job &job = jobs[j];
+		fprintf(file, "%s\n\t\t{\"line\": %zu, \"status\": %d, \"seconds\": %.6f, \"args\": [",
+			j ? "," : "", job.line, job.status, job.seconds);
+		for (size_t i = 0; i < job.args.size(); i++) {
+			if (i) { fputs(", ", file); }
+			write_json_string(file, job.args[i]);
+		}
+		fputs("], \"output\": ", file);
+		write_json_string(file, job.output);
+		fputs(", \"errors\": ", file);
+		write_json_string(file, job.errors);
+		fputc('}', file);
+	}
+	fputs(jobs.empty() ? "]\n}\n" : "\n\t]\n}\n", file);
+}
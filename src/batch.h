@@ -0,0 +1,30 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// One line of a batch manifest: a subcommand and its arguments
+struct Batch_Job {
+	size_t line = 0;
+	std::vector<std::string> args;
+	int status = 0;
+	double seconds = 0.0;
+	std::string output, errors;
+};
+
+typedef void (*Batch_Job_Cb)(Batch_Job &job, void *data);
+
+// Reads one job per line, skipping blank lines and "#" comments. Arguments are separated by
+// whitespace, and may be double-quoted to include spaces (with \" and \\ escapes).
+bool read_batch_manifest(const char *f, std::vector<Batch_Job> &jobs, std::string &error);
+
+// Runs every job on a pool of threads that take work from each other once their own runs out
+void run_batch_jobs(std::vector<Batch_Job> &jobs, int threads, Batch_Job_Cb cb, void *data);
+
+// Writes a JSON object with each job's status, timing, and messages
+void write_batch_summary(FILE *file, const char *manifest, const std::vector<Batch_Job> &jobs, int threads,
+	double seconds);
+
+#endif
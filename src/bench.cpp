@@ -0,0 +1,378 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "version.h"
+#include "config.h"
+#include "lz.h"
+#include "tilemap.h"
+#include "tileset.h"
+#include "image-to-tiles.h"
+#include "block-search.h"
+
+// tilemapstudio-bench times the editor's file handling on synthetic tilemaps, from a Game Boy screen
+// up to 4096x4096 tiles, and writes the results as JSON so runs from two commits can be compared.
+
+#define BENCH_MIN_SECONDS 0.25 // keep repeating a stage until it has run this long...
+#define BENCH_MAX_RUNS 20 // ...or this many times, and report the fastest run
+
+// Every loaded tile is a widget, so larger sizes take gigabytes and only run when asked for with -m
+#define BENCH_DEFAULT_MAX 1024
+// An image of a larger tilemap would be 8192x8192 pixels or more, so render and image-to-tiles stop there
+#define BENCH_MAX_IMAGE_SIZE 1024
+
+#define BENCH_FORMAT Tilemap_Format::GBA_4BPP
+
+typedef std::chrono::steady_clock Clock;
+
+struct Bench_Size {
+	size_t width, height;
+	inline size_t tiles(void) const { return width * height; }
+};
+
+static const Bench_Size bench_sizes[] = {
+	{GAME_BOY_WIDTH, GAME_BOY_HEIGHT}, {GAME_BOY_VRAM_SIZE, GAME_BOY_VRAM_SIZE}, {64, 64}, {128, 128}, {256, 256},
+	{512, 512}, {1024, 1024}, {2048, 2048}, {4096, 4096},
+};
+
+static const char *stage_names[] = {
+	"save", "load", "export", "import", "find-blocks", "tileset-decode", "lz-decode-gba", "lz-decode-crystal",
+	"render", "image-to-tiles",
+};
+
+enum class Stage {
+	SAVE, LOAD, EXPORT, IMPORT, FIND_BLOCKS, TILESET_DECODE, LZ_DECODE_GBA, LZ_DECODE_CRYSTAL, RENDER, IMAGE_TO_TILES
+};
+
+struct Bench_Result {
+	std::string stage;
+	size_t width = 0, height = 0;
+	double seconds = 0.0;
+	int runs = 0;
+};
+
+static double elapsed_seconds(Clock::time_point start) {
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Runs a stage until it has taken long enough to measure, undoing each run untimed, and returns the fastest run
+template<typename Run, typename Undo>
+static double time_stage(int &runs, Run run, Undo undo) {
+	double best = 0.0, total = 0.0;
+	for (runs = 0; runs < BENCH_MAX_RUNS && (runs == 0 || total < BENCH_MIN_SECONDS); runs++) {
+		Clock::time_point start = Clock::now();
+		bool ok = run();
+		double seconds = elapsed_seconds(start);
+		undo();
+		if (!ok) { return -1.0; }
+		best = runs ? std::min(best, seconds) : seconds;
+		total += seconds;
+	}
+	return best;
+}
+
+// Deterministic noise, so every run and commit benchmarks the same data
+static uint32_t noise(uint32_t x, uint32_t y, uint32_t seed) {
+	uint32_t h = x * 0x9E3779B1u ^ y * 0x85EBCA77u ^ seed * 0xC2B2AE3Du;
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 12;
+	return h;
+}
+
+static std::vector<Tilemap_Entry> synthetic_entries(const Bench_Size &size, size_t num_tiles) {
+	// Blocks of neighboring tiles repeat like a real map's, so the compressors have matches to find
+	std::vector<Tilemap_Entry> entries;
+	entries.reserve(size.tiles());
+	for (size_t y = 0; y < size.height; y++) {
+		for (size_t x = 0; x < size.width; x++) {
+			uint32_t block = noise((uint32_t)(x / 4), (uint32_t)(y / 4), 1);
+			uint16_t id = (uint16_t)((block + x % 4 + y % 4 * 4) % num_tiles);
+			entries.emplace_back(id, !!(block & 0x100), !!(block & 0x200), false, false, (int)(block >> 12 & 0xF));
+		}
+	}
+	return entries;
+}
+
+static std::vector<uchar> synthetic_tile_pixels(size_t num_tiles) {
+	std::vector<uchar> pixels(num_tiles * NUM_TILE_PIXELS);
+	for (size_t i = 0; i < pixels.size(); i++) {
+		size_t t = i / NUM_TILE_PIXELS, p = i % NUM_TILE_PIXELS;
+		pixels[i] = (uchar)(noise((uint32_t)t, (uint32_t)(p / 4), 2) & 0xF);
+	}
+	return pixels;
+}
+
+static bool write_bytes(const char *f, const std::vector<uchar> &bytes) {
+	FILE *file = open_file(f, "wb");
+	if (!file) { return false; }
+	size_t w = fwrite(bytes.data(), 1, bytes.size(), file);
+	fclose(file);
+	return w == bytes.size();
+}
+
+static bool lz_decode(bool gba, const std::vector<uchar> &lz_data, size_t size) {
+	std::vector<uchar> data;
+	Lz::Result r = gba ? Lz::decompress_gba(lz_data, data) : Lz::decompress_crystal(lz_data, data);
+	return r == Lz::Result::LZ_OK && data.size() == size;
+}
+
+class Bench {
+private:
+	std::string _dir;
+	Context _ctx;
+	std::vector<Bench_Result> _results;
+public:
+	Bench(const char *dir) : _dir(dir), _ctx(), _results() { _ctx.format = BENCH_FORMAT; }
+	void run(const Bench_Size &size);
+	void print_curves(void) const;
+	bool write_results(const char *f) const;
+	void compare(const char *f) const;
+private:
+	inline std::string path(const char *name) const { return _dir + "/" + name; }
+	template<typename Run, typename Undo>
+	void stage(Stage s, const Bench_Size &size, Run run, Undo undo);
+};
+
+template<typename Run, typename Undo>
+void Bench::stage(Stage s, const Bench_Size &size, Run run, Undo undo) {
+	Bench_Result result;
+	result.stage = stage_names[(int)s];
+	result.width = size.width;
+	result.height = size.height;
+	result.seconds = time_stage(result.runs, run, undo);
+	if (result.seconds < 0.0) {
+		// A stage that cannot run at this size ends its curve here
+		fprintf(stderr, "  %-18s failed\n", result.stage.c_str());
+		return;
+	}
+	printf("  %-18s %12.6f s %10.2f ns/tile  (%d run%s)\n", result.stage.c_str(), result.seconds,
+		result.seconds * 1e9 / size.tiles(), result.runs, result.runs == 1 ? "" : "s");
+	fflush(stdout);
+	_results.push_back(result);
+}
+
+void Bench::run(const Bench_Size &size) {
+	printf("%zux%zu tiles:\n", size.width, size.height);
+	size_t num_tiles = std::min(size.tiles(), (size_t)format_tileset_size(_ctx.format));
+	std::vector<Tilemap_Entry> entries = synthetic_entries(size, num_tiles);
+	std::string tilemap_f = path("bench.tilemap"), csv_f = path("bench.csv"), tileset_f = path("bench.4bpp"),
+		image_f = path("bench.bmp");
+
+	// Tilemaps
+
+	std::vector<uchar> bytes;
+	stage(Stage::SAVE, size, [&]() {
+		bytes = make_tilemap_bytes(entries, _ctx.format, size.width, size.height);
+		return !bytes.empty();
+	}, []() {});
+	if (!write_bytes(tilemap_f.c_str(), bytes)) {
+		fprintf(stderr, "Error writing %s\n", tilemap_f.c_str());
+		return;
+	}
+
+	Tilemap tilemap(_ctx);
+	stage(Stage::LOAD, size, [&]() {
+		return tilemap.read_tiles(tilemap_f.c_str(), NULL) == Tilemap::Result::TILEMAP_OK;
+	}, [&]() { tilemap.free_tiles(); });
+	if (tilemap.read_tiles(tilemap_f.c_str(), NULL) != Tilemap::Result::TILEMAP_OK) { return; }
+	tilemap.width(size.width);
+
+	stage(Stage::EXPORT, size, [&]() { return tilemap.export_tiles(csv_f.c_str()); }, []() {});
+
+	Tilemap imported(_ctx);
+	stage(Stage::IMPORT, size, [&]() {
+		return imported.import_tiles(csv_f.c_str(), NULL) == Tilemap::Result::TILEMAP_OK;
+	}, [&]() { imported.free_tiles(); });
+
+	// Find Block with Find Flipped Blocks checked, looking for the top-left 4x4 block
+	std::vector<uint32_t> keys;
+	keys.reserve(entries.size());
+	for (const Tilemap_Entry &e : entries) {
+		keys.push_back(block_key(e, false));
+	}
+	std::vector<std::vector<uint32_t>> blocks(4, std::vector<uint32_t>(4 * 4));
+	for (size_t b = 0; b < blocks.size(); b++) {
+		for (size_t y = 0; y < 4; y++) {
+			for (size_t x = 0; x < 4; x++) {
+				Tilemap_Entry e = entries[(b & 2 ? 3 - y : y) * size.width + (b & 1 ? 3 - x : x)];
+				e.x_flip = e.x_flip != !!(b & 1);
+				e.y_flip = e.y_flip != !!(b & 2);
+				blocks[b][y * 4 + x] = block_key(e, false);
+			}
+		}
+	}
+	stage(Stage::FIND_BLOCKS, size, [&]() { return !find_blocks(keys, size.width, blocks, 4, 4).empty(); }, []() {});
+
+	// Tilesets
+
+	std::vector<uchar> pixels = synthetic_tile_pixels(num_tiles);
+	Tile_Layout layout = format_tile_layout(_ctx.format);
+	if (Tileset::write_tile_data(tileset_f.c_str(), pixels, layout) != Tileset::Result::TILESET_OK) {
+		fprintf(stderr, "Error writing %s\n", tileset_f.c_str());
+		tilemap.free_tiles();
+		return;
+	}
+	std::vector<Tileset> tilesets(1, Tileset(0, 0, 0, layout));
+	Tileset &tileset = tilesets.front();
+	stage(Stage::TILESET_DECODE, size, [&]() {
+		return tileset.read_tiles(tileset_f.c_str(), _ctx) == Tileset::Result::TILESET_OK;
+	}, [&]() { tileset.clear(); });
+
+	// The tilemap itself is the LZ subject, since tilesets stop growing at the format's limit; Pokemon Crystal
+	// compresses Game Boy tilemaps, which are plain tile IDs
+	if (std::vector<uchar> lz_data; Lz::compress_gba(bytes, lz_data) == Lz::Result::LZ_OK) {
+		stage(Stage::LZ_DECODE_GBA, size, [&]() { return lz_decode(true, lz_data, bytes.size()); }, []() {});
+	}
+	std::vector<uchar> plain_bytes = make_tilemap_bytes(entries, Tilemap_Format::PLAIN, size.width, size.height);
+	if (std::vector<uchar> lz_data; Lz::compress_crystal(plain_bytes, lz_data) == Lz::Result::LZ_OK) {
+		stage(Stage::LZ_DECODE_CRYSTAL, size, [&]() { return lz_decode(false, lz_data, plain_bytes.size()); }, []() {});
+	}
+
+	// Images
+
+	if (size.width <= BENCH_MAX_IMAGE_SIZE && size.height <= BENCH_MAX_IMAGE_SIZE &&
+		tileset.read_tiles(tileset_f.c_str(), _ctx) == Tileset::Result::TILESET_OK) {
+		_ctx.tilesets = &tilesets;
+		stage(Stage::RENDER, size, [&]() {
+			return tilemap.print_tilemap(image_f.c_str()) == Image::Result::IMAGE_OK;
+		}, []() {});
+		_ctx.tilesets = NULL;
+		tileset.clear();
+
+		Image_to_Tiles_Options opts;
+		opts.image_filename = image_f;
+		opts.fmt = _ctx.format;
+		opts.output_filenames(path("converted.4bpp").c_str());
+		stage(Stage::IMAGE_TO_TILES, size, [&]() {
+			size_t width;
+			std::string message;
+			return image_to_tiles(opts, width, message);
+		}, []() {});
+	}
+
+	tilemap.free_tiles();
+}
+
+void Bench::print_curves() const {
+	// The exponent is the slope of log(time) over log(tiles): 1 is linear, 2 is quadratic
+	printf("\nScaling (ns/tile from smallest to largest size, then the fitted exponent):\n");
+	for (const char *name : stage_names) {
+		double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+		size_t n = 0;
+		printf("  %-18s", name);
+		for (const Bench_Result &r : _results) {
+			if (r.stage != name) { continue; }
+			double tiles = (double)(r.width * r.height);
+			printf(" %9.2f", r.seconds * 1e9 / tiles);
+			double x = log(tiles), y = log(std::max(r.seconds, 1e-9));
+			sx += x; sy += y; sxx += x * x; sxy += x * y;
+			n++;
+		}
+		if (n > 1 && n * sxx != sx * sx) {
+			printf("  ^%.2f", (n * sxy - sx * sy) / (n * sxx - sx * sx));
+		}
+		printf("\n");
+	}
+}
+
+bool Bench::write_results(const char *f) const {
+	FILE *file = open_file(f, "wb");
+	if (!file) { return false; }
+	// One result per line, so compare can read them back without a JSON parser
+	fprintf(file, "{\n\t\"version\": \"%s\",\n\t\"format\": \"%s\",\n\t\"results\": [", PROGRAM_VERSION_STRING,
+		format_short_name(_ctx.format));
+	for (size_t i = 0; i < _results.size(); i++) {
+		const Bench_Result &r = _results[i];
+		fprintf(file, "%s\n\t\t{\"stage\": \"%s\", \"width\": %zu, \"height\": %zu, \"seconds\": %.9f, \"runs\": %d}",
+			i ? "," : "", r.stage.c_str(), r.width, r.height, r.seconds, r.runs);
+	}
+	fputs(_results.empty() ? "]\n}\n" : "\n\t]\n}\n", file);
+	fclose(file);
+	return true;
+}
+
+void Bench::compare(const char *f) const {
+	FILE *file = open_file(f, "rb");
+	if (!file) {
+		fprintf(stderr, "Cannot open %s\n", f);
+		return;
+	}
+	printf("\nCompared to %s (new / old time; under 1 is faster):\n", f);
+	char line[256], name[32];
+	while (fgets(line, sizeof(line), file)) {
+		Bench_Result old;
+		if (sscanf(line, " {\"stage\": \"%31[^\"]\", \"width\": %zu, \"height\": %zu, \"seconds\": %lf", name, &old.width,
+			&old.height, &old.seconds) != 4) {
+			continue;
+		}
+		for (const Bench_Result &r : _results) {
+			if (r.stage == name && r.width == old.width && r.height == old.height && old.seconds > 0.0) {
+				printf("  %-18s %5zux%-5zu %12.6f s -> %12.6f s  %6.3fx\n", name, r.width, r.height, old.seconds, r.seconds,
+					r.seconds / old.seconds);
+			}
+		}
+	}
+	fclose(file);
+}
+
+static int usage(void) {
+	fprintf(stderr, "Usage: tilemapstudio-bench [-m MAX] [-o RESULTS.json] [-c BASELINE.json] [DIR]\n"
+		"Times " PROGRAM_NAME " on synthetic tilemaps up to MAX x MAX tiles (default %d, at most %zu), writing files in DIR\n",
+		BENCH_DEFAULT_MAX, bench_sizes[_countof(bench_sizes) - 1].width);
+	return 2;
+}
+
+int main(int argc, char **argv) {
+	size_t max = BENCH_DEFAULT_MAX;
+	const char *results_f = NULL, *baseline_f = NULL, *dir = "bench";
+	int i = 1;
+	for (; i < argc && argv[i][0] == '-'; i++) {
+		const char *opt = argv[i];
+		if (i + 1 >= argc) { return usage(); }
+		if (!strcmp(opt, "-m")) {
+			char *end;
+			max = (size_t)strtoul(argv[++i], &end, 10);
+			if (*end || !max) { return usage(); }
+		}
+		else if (!strcmp(opt, "-o")) {
+			results_f = argv[++i];
+		}
+		else if (!strcmp(opt, "-c")) {
+			baseline_f = argv[++i];
+		}
+		else {
+			return usage();
+		}
+	}
+	if (i < argc) { dir = argv[i++]; }
+	if (i < argc) { return usage(); }
+
+	std::error_code ec;
+	std::filesystem::create_directories(dir, ec);
+	if (ec) {
+		fprintf(stderr, "Cannot create %s: %s\n", dir, ec.message().c_str());
+		return 1;
+	}
+
+	Bench bench(dir);
+	for (const Bench_Size &size : bench_sizes) {
+		if (size.width > max || size.height > max) { break; }
+		bench.run(size);
+	}
+	bench.print_curves();
+	if (baseline_f) { bench.compare(baseline_f); }
+	if (results_f) {
+		if (!bench.write_results(results_f)) {
+			fprintf(stderr, "Error writing %s\n", results_f);
+			return 1;
+		}
+		printf("\nWrote %s\n", results_f);
+	}
+	return 0;
+}
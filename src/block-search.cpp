@@ -0,0 +1,114 @@
+#include <algorithm>
+
+#include "core.h"
+#include "block-search.h"
+
+// Hashes wrap around mod 2^64; a collision only costs an extra comparison
+#define ROW_BASE 0x100000001B3ULL
+#define COLUMN_BASE 0x9E3779B97F4A7C15ULL
+
+// Spreads a key over all 64 bits; no key mixes to 0, which stands for a missing cell
+static inline uint64_t mix_key(uint32_t k) {
+	return ((uint64_t)k + 1) * 0xD6E8FEB86659FD93ULL;
+}
+
+uint32_t block_key(const Tilemap_Entry &e, bool attr) {
+	if (attr) { return (uint32_t)(e.palette + 1) << 2 | (e.priority ? 2 : 0) | (e.obp1 ? 1 : 0); }
+	return (uint32_t)e.id | (e.x_flip ? 0x10000 : 0) | (e.y_flip ? 0x20000 : 0);
+}
+
+static uint64_t power(uint64_t b, size_t e) {
+	uint64_t p = 1;
+	for (; e; e >>= 1, b *= b) {
+		if (e & 1) { p *= b; }
+	}
+	return p;
+}
+
+static uint64_t block_hash(const std::vector<uint32_t> &block, size_t bw, size_t bh) {
+	uint64_t h = 0;
+	for (size_t y = 0; y < bh; y++) {
+		uint64_t rh = 0;
+		for (size_t x = 0; x < bw; x++) {
+			rh = rh * ROW_BASE + mix_key(block[y * bw + x]);
+		}
+		h = h * COLUMN_BASE + rh;
+	}
+	return h;
+}
+
+static bool block_at(const std::vector<uint32_t> &cells, size_t w, size_t i, const std::vector<uint32_t> &block,
+	size_t bw, size_t bh) {
+	size_t n = cells.size();
+	for (size_t y = 0; y < bh; y++, i += w) {
+		if (i + bw > n) { return false; }
+		if (!std::equal(cells.begin() + i, cells.begin() + i + bw, block.begin() + y * bw)) { return false; }
+	}
+	return true;
+}
+
+std::vector<Block_Match> find_blocks(const std::vector<uint32_t> &cells, size_t w,
+	const std::vector<std::vector<uint32_t>> &blocks, size_t bw, size_t bh) {
+	std::vector<Block_Match> matches;
+	size_t n = cells.size();
+	if (!w || !bw || !bh || bw > w || blocks.empty()) { return matches; }
+	size_t h = (n + w - 1) / w;
+	if (bh > h) { return matches; }
+	std::vector<uint64_t> hashes;
+	for (const std::vector<uint32_t> &block : blocks) {
+		hashes.push_back(block_hash(block, bw, bh));
+	}
+	// The hash of each bw-wide window in the last bh rows, and of each bw x bh window ending at the current row
+	size_t nx = w - bw + 1;
+	std::vector<uint64_t> rows(bh * nx), windows(nx, 0);
+	uint64_t row_out = power(ROW_BASE, bw - 1), column_out = power(COLUMN_BASE, bh - 1);
+	std::vector<uint64_t> mixed(w);
+	for (size_t y = 0; y < h; y++) {
+		for (size_t x = 0, i = y * w; x < w; x++, i++) {
+			mixed[x] = i < n ? mix_key(cells[i]) : 0;
+		}
+		uint64_t *row = &rows[(y % bh) * nx];
+		uint64_t rh = 0;
+		for (size_t x = 0; x < bw; x++) {
+			rh = rh * ROW_BASE + mixed[x];
+		}
+		for (size_t x = 0; x < nx; x++) {
+			if (x) { rh = (rh - mixed[x - 1] * row_out) * ROW_BASE + mixed[x + bw - 1]; }
+			// The row leaving the window shares its slot with the row entering it
+			uint64_t wh = y >= bh ? windows[x] - row[x] * column_out : windows[x];
+			windows[x] = wh * COLUMN_BASE + rh;
+			row[x] = rh;
+		}
+		if (y + 1 < bh) { continue; }
+		size_t top = y + 1 - bh;
+		for (size_t x = 0; x < nx; x++) {
+			for (size_t b = 0; b < blocks.size(); b++) {
+				size_t i = top * w + x;
+				if (windows[x] == hashes[b] && block_at(cells, w, i, blocks[b], bw, bh)) {
+					matches.push_back({i, b});
+					break;
+				}
+			}
+		}
+	}
+	return matches;
+}
+
+void drop_overlapping_blocks(std::vector<Block_Match> &matches, size_t w, size_t bw, size_t bh) {
+	if (matches.empty() || !bw || !bh) { return; }
+	std::vector<bool> covered(matches.back().index + (bh - 1) * w + bw, false);
+	// Two blocks of the same size overlap only if one holds a corner of the other
+	auto overlaps = [&](size_t i) {
+		size_t r = i + bw - 1, b = (bh - 1) * w;
+		return covered[i] || covered[r] || covered[i + b] || covered[r + b];
+	};
+	size_t kept = 0;
+	for (const Block_Match &m : matches) {
+		if (overlaps(m.index)) { continue; }
+		for (size_t y = 0, i = m.index; y < bh; y++, i += w) {
+			std::fill(covered.begin() + i, covered.begin() + i + bw, true);
+		}
+		matches[kept++] = m;
+	}
+	matches.resize(kept);
+}
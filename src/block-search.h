@@ -0,0 +1,29 @@
+#ifndef BLOCK_SEARCH_H
+#define BLOCK_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "tilemap-format.h"
+
+// Where find_blocks found a block: the index of its top-left cell in the grid, and which block it was
+struct Block_Match {
+	size_t index, block;
+};
+
+// The key Find Block compares a cell by: tile mode compares IDs and flips; attribute mode compares palettes,
+// priority, and OBP1
+uint32_t block_key(const Tilemap_Entry &e, bool attr);
+
+// Finds every placement of any of several bw x bh blocks of cell keys in a grid of keys w wide, in row-major
+// order; where more than one block fits, the first one is reported. Each placement is hashed in constant time
+// by rolling hashes along the rows and then down the columns, and only placements with a block's hash are
+// compared cell by cell. The cells past the end of an incomplete last row match nothing.
+std::vector<Block_Match> find_blocks(const std::vector<uint32_t> &cells, size_t w,
+	const std::vector<std::vector<uint32_t>> &blocks, size_t bw, size_t bh);
+
+// Keeps the matches, in order, that do not overlap any match kept before them
+void drop_overlapping_blocks(std::vector<Block_Match> &matches, size_t w, size_t bw, size_t bh);
+
+#endif
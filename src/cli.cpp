@@ -0,0 +1,687 @@
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#pragma warning(push, 0)
+#include <FL/filename.H>
+#pragma warning(pop)
+
+#include "version.h"
+#include "config.h"
+#include "tilemap.h"
+#include "tileset.h"
+#include "compression-advisor.h"
+#include "image-to-tiles.h"
+#include "batch.h"
+#include "server.h"
+#include "depfile.h"
+#include "cli.h"
+
+// The Trans: slider's default, for printing bold palettes without the main window
+#define PALETTE_BG_ALPHA (4 * (0xFF / 10) + (0xFF / 10))
+
+struct Command {
+	const char *name, *usage;
+	int (*run)(Context &ctx, int argc, char **argv);
+};
+
+// Batch jobs collect their messages instead of printing them over each other
+static thread_local Batch_Job *current_job = NULL;
+
+static void print_message(bool error, const char *format, va_list args) {
+	if (!current_job) {
+		vfprintf(error ? stderr : stdout, format, args);
+		return;
+	}
+	va_list size_args;
+	va_copy(size_args, args);
+	int n = vsnprintf(NULL, 0, format, size_args);
+	va_end(size_args);
+	if (n <= 0) { return; }
+	std::string &log = error ? current_job->errors : current_job->output;
+	size_t k = log.size();
+	log.resize(k + n + 1);
+	vsnprintf(&log[k], n + 1, format, args);
+	log.resize(k + n);
+}
+
+static void print_output(const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	print_message(false, format, args);
+	va_end(args);
+}
+
+static void print_error(const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	print_message(true, format, args);
+	va_end(args);
+}
+
+static int usage_error(const Command &cmd) {
+	print_error("Usage: %s %s\n", PROGRAM_EXE_NAME, cmd.usage);
+	return 2;
+}
+
+static bool parse_format_name(const char *name, Tilemap_Format &fmt) {
+	if (format_from_short_name(name, fmt)) { return true; }
+	print_error("Unknown tilemap format: %s\nKnown formats:", name);
+	for (int i = 0; i < NUM_FORMATS; i++) {
+		print_error(" %s", format_short_name((Tilemap_Format)i));
+	}
+	print_error("\n");
+	return false;
+}
+
+static bool parse_format(int &argc, char **&argv, Tilemap_Format &fmt, bool &found) {
+	// Consumes a leading "-f FORMAT" option
+	found = false;
+	if (argc < 2 || strcmp(argv[0], "-f")) { return true; }
+	if (!parse_format_name(argv[1], fmt)) { return false; }
+	found = true;
+	argc -= 2;
+	argv += 2;
+	return true;
+}
+
+static bool parse_number(const char *opt, const char *arg, int base, long lo, long hi, long &v) {
+	char *end;
+	v = strtol(arg, &end, base);
+	if (!*arg || *end || v < lo || v > hi) {
+		print_error("Invalid value for %s: %s\n", opt, arg);
+		return false;
+	}
+	return true;
+}
+
+// Names a dependency file after an output like gcc -MD, replacing a compound extension like ".2bpp.lz"
+static std::string depfile_filename(const char *out) {
+	// Keep the whole name, so outputs that differ only in extension get their own rules
+	return std::string(out) + ".d";
+}
+
+static bool write_depfile_for(const char *out, const Dependencies &deps) {
+	std::string f = depfile_filename(out);
+	if (!write_depfile(f.c_str(), deps)) {
+		print_error("Error writing %s\n", f.c_str());
+		return false;
+	}
+	return true;
+}
+
+// The server remembers the palettes it makes for image-to-tiles
+static Palette_Cache *palette_cache = NULL;
+
+static int image_to_tiles_command(Context &, int argc, char **argv) {
+	Image_to_Tiles_Options opts;
+	bool explicit_fmt;
+	if (!parse_format(argc, argv, opts.fmt, explicit_fmt)) { return 2; }
+	// Like the dialog, IDs and indexes are hexadecimal
+	int nx = format_palettes_size(opts.fmt);
+	if (nx == 1) { nx = format_palette_size(opts.fmt); }
+	nx = std::max(nx, 1);
+
+	bool make_depfile = false;
+	for (; argc > 0 && argv[0][0] == '-'; argc--, argv++) {
+		const char *opt = argv[0];
+		if (!strcmp(opt, "-MD")) { make_depfile = true; continue; }
+		if (!strcmp(opt, "--no-unique")) { opts.allow_unique = false; continue; }
+		if (!strcmp(opt, "--no-flip")) { opts.allow_flip = false; continue; }
+		if (!strcmp(opt, "--no-extra-blank")) { opts.no_extra_blank_tiles = true; continue; }
+		// The rest take a value
+		if (argc < 2) { return -1; }
+		const char *arg = argv[1];
+		long v;
+		if (!strcmp(opt, "-p")) {
+			if (!palette_from_short_name(arg, opts.pal_fmt)) {
+				print_error("Unknown palette format: %s\nKnown formats:", arg);
+				for (int i = 0; i < NUM_PALETTE_FORMATS; i++) {
+					print_error(" %s", palette_short_name((Palette_Format)i));
+				}
+				print_error("\n");
+				return 2;
+			}
+			opts.make_palette = true;
+		}
+		else if (!strcmp(opt, "--start-id")) {
+			if (!parse_number(opt, arg, 16, 0, MAX_NUM_TILES - 1, v)) { return 2; }
+			opts.start_id = (uint16_t)v;
+		}
+		else if (!strcmp(opt, "--blank-id")) {
+			if (!parse_number(opt, arg, 16, 0, MAX_NUM_TILES - 1, v)) { return 2; }
+			opts.use_blank = true;
+			opts.blank_id = (uint16_t)v;
+		}
+		else if (!strcmp(opt, "--color-zero")) {
+			opts.use_color_zero = true;
+			opts.color_zero = color_zero_from_hex(arg);
+		}
+		else if (!strcmp(opt, "--start-index")) {
+			if (!parse_number(opt, arg, 16, 0, nx - 1, v)) { return 2; }
+			opts.start_index = (uint8_t)v;
+		}
+		else if (!strcmp(opt, "--width")) {
+			if (!parse_number(opt, arg, 10, 1, MAX_NUM_TILES, v)) { return 2; }
+			opts.tileset_width = (int)v;
+		}
+		else {
+			return -1;
+		}
+		argc--;
+		argv++;
+	}
+	if (argc != 2) { return -1; }
+
+	opts.image_filename = argv[0];
+	opts.output_filenames(argv[1]);
+	if (make_depfile) { opts.depfile_filename = depfile_filename(argv[1]); }
+	size_t width;
+	std::string message;
+	if (!image_to_tiles(opts, width, message, palette_cache)) {
+		print_error("%s\n", message.c_str());
+		return 1;
+	}
+	print_output("%s\n", message.c_str());
+	return 0;
+}
+
+// Splits "FILE,A,B" after the last path separator, returning "A,B", or NULL if there are no fields
+static char *split_fields(char *arg) {
+	const char *name = fl_filename_name(arg);
+	char *comma = strchr(arg + (name - arg), ',');
+	if (!comma) { return NULL; }
+	*comma = '\0';
+	return comma + 1;
+}
+
+// Batch jobs and server requests share the tilesets they decode, keyed by tilemap format, placement, and path
+struct Shared_Tileset {
+	std::once_flag decoded;
+	Tileset tileset{0, 0, 0};
+	Tileset::Result result = Tileset::Result::TILESET_NULL;
+	std::string filename;
+	int64_t modified = 0;
+	size_t size = 0;
+};
+
+static std::map<std::string, std::unique_ptr<Shared_Tileset>> *shared_tilesets = NULL;
+static std::mutex shared_tilesets_mutex;
+
+static Shared_Tileset *find_shared_tileset(const std::string &key) {
+	std::lock_guard<std::mutex> lock(shared_tilesets_mutex);
+	std::unique_ptr<Shared_Tileset> &shared = (*shared_tilesets)[key];
+	if (!shared) { shared = std::make_unique<Shared_Tileset>(); }
+	return shared.get();
+}
+
+static bool load_tileset(const Context &ctx, char *arg, std::vector<Tileset> &tilesets) {
+	// TILESET[,START[,OFFSET[,LENGTH[,LAYOUT]]]], in hexadecimal like the Add Tileset dialog
+	long fields[3] = {0, 0, 0}, limits[3] = {MAX_NUM_TILES - 1, 0x400, 0x400};
+	const char *names[3] = {"start", "offset", "length"};
+	char *field = split_fields(arg);
+	for (int i = 0; i < 3 && field; i++) {
+		char *next = strchr(field, ',');
+		if (next) { *next++ = '\0'; }
+		if (!parse_number(names[i], field, 16, 0, limits[i], fields[i])) { return false; }
+		field = next;
+	}
+	Tile_Layout layout = Tile_Layout::LINEAR;
+	if (field) {
+		int i = 0;
+		for (; i < NUM_TILE_LAYOUTS; i++) {
+			if (!strcmp(field, tile_layout_short_name((Tile_Layout)i))) { break; }
+		}
+		if (i == NUM_TILE_LAYOUTS) {
+			print_error("Invalid value for layout: %s\n", field);
+			return false;
+		}
+		layout = (Tile_Layout)i;
+	}
+	// The placement decides which tile ids the tiles get and which ones are too large, so it is part of the key
+	char path[FL_PATH_MAX] = {};
+	fl_filename_absolute(path, sizeof(path), arg);
+	char placement[64] = {};
+	snprintf(placement, sizeof(placement), " %lX,%lX,%lX,%s ", fields[0], fields[1], fields[2],
+		tile_layout_short_name(layout));
+	std::string key = std::string(format_short_name(ctx.format)) + placement + path;
+	Tileset tileset((int)fields[0], (int)fields[1], (int)fields[2], layout);
+	Tileset::Result result;
+	if (shared_tilesets) {
+		// The first job to need a tileset decodes it while any others wait
+		Shared_Tileset *shared = find_shared_tileset(key);
+		std::call_once(shared->decoded, [&]() {
+			shared->filename = path;
+			shared->modified = file_modified(path);
+			shared->size = file_size(path);
+			shared->result = tileset.read_tiles(arg, ctx);
+			shared->tileset = tileset;
+		});
+		tileset = shared->tileset;
+		result = shared->result;
+	}
+	else {
+		result = tileset.read_tiles(arg, ctx);
+	}
+	if (result != Tileset::Result::TILESET_OK) {
+		print_error("Error reading %s: %s\n", arg, Tileset::error_message(result));
+		return false;
+	}
+	tilesets.push_back(tileset);
+	return true;
+}
+
+static void attrmap_filename(const char *tf, const char *given_af, Tilemap_Format fmt, char *af) {
+	// Formats with an attrmap use the one next to the tilemap unless another one is given
+	af[0] = '\0';
+	if (given_af) {
+		strcpy(af, given_af);
+	}
+	else if (format_has_attrmap(fmt)) {
+		strcpy(af, tf);
+		fl_filename_setext(af, FL_PATH_MAX, ATTRMAP_EXT);
+	}
+}
+
+static bool read_tilemap(Context &ctx, char *arg, Tilemap_Format fmt, bool explicit_fmt, Tilemap &tilemap,
+	Dependencies *deps = NULL) {
+	// TILEMAP[,ATTRMAP]
+	const char *tf = arg;
+	const char *given_af = split_fields(arg);
+	if (!explicit_fmt) { fmt = guess_format(tf, ctx.format); }
+	char af[FL_PATH_MAX];
+	attrmap_filename(tf, given_af, fmt, af);
+	ctx.format = fmt;
+	Tilemap::Result tr = tilemap.read_tiles(tf, af);
+	if (tr != Tilemap::Result::TILEMAP_OK) {
+		print_error("Error reading %s: %s\n", tr >= Tilemap::Result::ATTRMAP_BAD_FILE ? af : tf, Tilemap::error_message(tr));
+		return false;
+	}
+	if (deps) {
+		deps->prerequisite(tf);
+		deps->prerequisite(af);
+	}
+	return true;
+}
+
+static int report_command(Context &ctx, int argc, char **argv) {
+	Tilemap_Format fmt = Tilemap_Format::PLAIN;
+	bool explicit_fmt;
+	if (!parse_format(argc, argv, fmt, explicit_fmt)) { return 2; }
+	if (argc < 1) { return -1; }
+
+	std::vector<Compression_Subject> subjects;
+	Tilemap tilemap(ctx);
+	if (!read_tilemap(ctx, argv[0], fmt, explicit_fmt, tilemap)) { return 1; }
+	fmt = ctx.format;
+	tilemap.guess_width();
+	subjects.push_back(tilemap.compression_subject(argv[0], fmt));
+	tilemap.free_tiles();
+
+	for (int i = 1; i < argc; i++) {
+		std::vector<uchar> data;
+		size_t bytes_per_tile;
+		Tileset::Result sr = Tileset::read_tile_data(argv[i], data, bytes_per_tile);
+		if (sr != Tileset::Result::TILESET_OK) {
+			print_error("Error reading %s: %s\n", argv[i], Tileset::error_message(sr));
+			return 1;
+		}
+		subjects.push_back({argv[i], data, {}});
+	}
+
+	print_output("Tilemap format: %s\n\n", format_name(fmt));
+	print_output("%s", compression_report(Compression_Advisor::estimate(subjects), false).c_str());
+	return 0;
+}
+
+static bool render_tilemap(Context &ctx, char *arg, Tilemap_Format fmt, bool explicit_fmt, size_t width, const char *dir,
+	const Dependencies *tileset_deps) {
+	// Each output depends on the tilesets and its own tilemap
+	Dependencies deps;
+	if (tileset_deps) { deps = *tileset_deps; }
+	Tilemap tilemap(ctx);
+	if (!read_tilemap(ctx, arg, fmt, explicit_fmt, tilemap, &deps)) { return false; }
+	const char *tf = arg;
+
+	char out[FL_PATH_MAX] = {};
+	if (dir) {
+		snprintf(out, sizeof(out), "%s/%s", dir, fl_filename_name(tf));
+	}
+	else {
+		strcpy(out, tf);
+	}
+	fl_filename_setext(out, sizeof(out), ".png");
+
+	if (width) { tilemap.width(width); }
+	Image::Result ir = tilemap.print_tilemap(out);
+	tilemap.free_tiles();
+	if (ir != Image::Result::IMAGE_OK) {
+		print_error("Error writing %s: %s\n", out, Image::error_message(ir));
+		return false;
+	}
+	if (tileset_deps) {
+		deps.target(out);
+		if (!write_depfile_for(out, deps)) { return false; }
+	}
+	print_output("Rendered %s to %s\n", tf, out);
+	return true;
+}
+
+static int render_command(Context &ctx, int argc, char **argv) {
+	Tilemap_Format fmt = Tilemap_Format::PLAIN;
+	bool explicit_fmt;
+	if (!parse_format(argc, argv, fmt, explicit_fmt)) { return 2; }
+
+	std::vector<char *> tileset_args;
+	const char *dir = NULL;
+	size_t width = 0;
+	bool make_depfile = false;
+	for (; argc > 0 && argv[0][0] == '-'; argc--, argv++) {
+		const char *opt = argv[0];
+		if (!strcmp(opt, "-MD")) { make_depfile = true; continue; }
+		if (!strcmp(opt, "--grid")) { ctx.print_grid = true; continue; }
+		if (!strcmp(opt, "--rainbow")) { ctx.print_rainbow_tiles = true; continue; }
+		if (!strcmp(opt, "--palettes")) { ctx.print_palettes = true; continue; }
+		if (!strcmp(opt, "--bold-palettes")) { ctx.print_bold_palettes = true; continue; }
+		// The rest take a value
+		if (argc < 2) { return -1; }
+		long v;
+		if (!strcmp(opt, "-t")) {
+			tileset_args.push_back(argv[1]);
+		}
+		else if (!strcmp(opt, "-o")) {
+			dir = argv[1];
+		}
+		else if (!strcmp(opt, "--width")) {
+			if (!parse_number(opt, argv[1], 10, 1, 1024, v)) { return 2; }
+			width = (size_t)v;
+		}
+		else {
+			return -1;
+		}
+		argc--;
+		argv++;
+	}
+	if (argc < 1) { return -1; }
+
+	// Tilesets are decoded once for every tilemap; their tile layout depends on the format
+	ctx.format = explicit_fmt ? fmt : guess_format(argv[0], ctx.format);
+	std::vector<Tileset> tilesets;
+	ctx.tilesets = &tilesets;
+	Dependencies tileset_deps;
+	int status = 0;
+	for (char *arg : tileset_args) {
+		if (!load_tileset(ctx, arg, tilesets)) { status = 1; break; }
+		// Only the filename is left of the argument
+		tileset_deps.prerequisite(arg);
+	}
+	if (status == 0) {
+		// Keep going after a bad tilemap, so one broken file does not hide the others
+		for (int i = 0; i < argc; i++) {
+			if (!render_tilemap(ctx, argv[i], fmt, explicit_fmt, width, dir, make_depfile ? &tileset_deps : NULL)) {
+				status = 1;
+			}
+		}
+	}
+
+	ctx.tilesets = NULL;
+	// Shared tilesets are cleared once the whole batch is done
+	if (!shared_tilesets) {
+		for (Tileset &t : tilesets) {
+			t.clear();
+		}
+	}
+	return status;
+}
+
+static int reformat_command(Context &ctx, int argc, char **argv) {
+	Tilemap_Format fmt = Tilemap_Format::PLAIN, new_fmt;
+	bool explicit_fmt, force = false, make_depfile = false;
+	if (!parse_format(argc, argv, fmt, explicit_fmt)) { return 2; }
+	for (; argc > 0 && argv[0][0] == '-'; argc--, argv++) {
+		if (!strcmp(argv[0], "--force")) { force = true; }
+		else if (!strcmp(argv[0], "-MD")) { make_depfile = true; }
+		else { return -1; }
+	}
+	if (argc != 3) { return -1; }
+	if (!parse_format_name(argv[0], new_fmt)) { return 2; }
+
+	Dependencies deps;
+	Tilemap tilemap(ctx);
+	if (!read_tilemap(ctx, argv[1], fmt, explicit_fmt, tilemap, &deps)) { return 1; }
+	const char *tf = argv[1], *out = argv[2];
+	const char *given_af = split_fields(argv[2]);
+	char af[FL_PATH_MAX];
+	attrmap_filename(out, given_af, new_fmt, af);
+
+	int status = 0;
+	if (!force && !tilemap.can_format_as(new_fmt)) {
+		// Like the Reformat dialog, only --force changes tiles to fit
+		print_error("Cannot reformat %s as %s without --force\n", tf, format_name(new_fmt));
+		status = 1;
+	}
+	else {
+		tilemap.limit_to_format(new_fmt);
+		if (tilemap.write_tiles(out, af, new_fmt)) {
+			deps.target(out);
+			if (format_has_attrmap(new_fmt)) { deps.target(af); }
+			if (make_depfile && !write_depfile_for(out, deps)) { status = 1; }
+			print_output("Reformatted %s as %s to %s\n", tf, format_name(new_fmt), out);
+		}
+		else {
+			print_error("Error writing %s\n", out);
+			status = 1;
+		}
+	}
+	tilemap.free_tiles();
+	return status;
+}
+
+static int export_command(Context &ctx, int argc, char **argv) {
+	Tilemap_Format fmt = Tilemap_Format::PLAIN;
+	bool explicit_fmt, make_depfile = false;
+	if (!parse_format(argc, argv, fmt, explicit_fmt)) { return 2; }
+	if (argc > 0 && !strcmp(argv[0], "-MD")) {
+		make_depfile = true;
+		argc--;
+		argv++;
+	}
+	if (argc != 2) { return -1; }
+
+	Dependencies deps;
+	Tilemap tilemap(ctx);
+	if (!read_tilemap(ctx, argv[0], fmt, explicit_fmt, tilemap, &deps)) { return 1; }
+	// The extension picks the syntax: .csv, .c or .h, or assembly
+	bool exported = tilemap.export_tiles(argv[1]);
+	tilemap.free_tiles();
+	if (!exported) {
+		print_error("Error writing %s\n", argv[1]);
+		return 1;
+	}
+	deps.target(argv[1]);
+	if (make_depfile && !write_depfile_for(argv[1], deps)) { return 1; }
+	print_output("Exported %s to %s\n", argv[0], argv[1]);
+	return 0;
+}
+
+static int batch_command(Context &ctx, int argc, char **argv);
+static int serve_command(Context &ctx, int argc, char **argv);
+
+static const Command commands[] = {
+	{"report", "report [-f FORMAT] TILEMAP [TILESET...]", report_command},
+	{"image-to-tiles", "image-to-tiles [-f FORMAT] [-MD] [-p PALETTE_FORMAT] [--start-id ID] [--blank-id ID] [--no-unique] "
+		"[--no-flip] [--color-zero RRGGBB] [--start-index N] [--width TILES] [--no-extra-blank] IMAGE TILESET",
+		image_to_tiles_command},
+	{"render", "render [-f FORMAT] [-MD] [--grid] [--rainbow] [--palettes] [--bold-palettes] [-o DIR] [--width TILES] "
+		"[-t TILESET[,START[,OFFSET[,LENGTH[,LAYOUT]]]]]... TILEMAP[,ATTRMAP]...", render_command},
+	{"reformat", "reformat [-f FORMAT] [-MD] [--force] NEW_FORMAT TILEMAP[,ATTRMAP] OUTPUT[,ATTRMAP]", reformat_command},
+	{"export", "export [-f FORMAT] [-MD] TILEMAP[,ATTRMAP] OUTPUT", export_command},
+	{"batch", "batch [-j THREADS] [-o SUMMARY] MANIFEST", batch_command},
+	{"serve", "serve [-s SOCKET]", serve_command},
+};
+
+static const Command *find_command(const char *name) {
+	for (const Command &cmd : commands) {
+		if (!strcmp(name, cmd.name)) { return &cmd; }
+	}
+	return NULL;
+}
+
+static int run_command(const Command &cmd, Context &ctx, int argc, char **argv) {
+	int status = cmd.run(ctx, argc, argv);
+	return status == -1 ? usage_error(cmd) : status;
+}
+
+static void run_batch_job(Batch_Job &job, void *data) {
+	// data names the kind of job for errors
+	// Each job starts from the defaults, whatever else is running
+	Context ctx;
+	current_job = &job;
+	// Commands may split their arguments in place, so they get a copy
+	std::vector<std::string> args = job.args;
+	std::vector<char *> argv;
+	for (std::string &arg : args) {
+		argv.push_back(arg.data());
+	}
+	argv.push_back(NULL);
+	const Command *cmd = find_command(argv[0]);
+	if (!cmd || cmd->run == batch_command || cmd->run == serve_command) {
+		print_error("Not a %s: %s\n", (const char *)data, argv[0]);
+		job.status = 2;
+	}
+	else {
+		job.status = run_command(*cmd, ctx, (int)args.size() - 1, argv.data() + 1);
+	}
+	current_job = NULL;
+}
+
+static int batch_command(Context &, int argc, char **argv) {
+	int threads = std::max((int)std::thread::hardware_concurrency(), 1);
+	const char *summary = NULL;
+	for (; argc > 0 && argv[0][0] == '-'; argc--, argv++) {
+		const char *opt = argv[0];
+		if (argc < 2) { return -1; }
+		long v;
+		if (!strcmp(opt, "-j")) {
+			if (!parse_number(opt, argv[1], 10, 1, 256, v)) { return 2; }
+			threads = (int)v;
+		}
+		else if (!strcmp(opt, "-o")) {
+			summary = argv[1];
+		}
+		else {
+			return -1;
+		}
+		argc--;
+		argv++;
+	}
+	if (argc != 1) { return -1; }
+
+	std::vector<Batch_Job> jobs;
+	std::string error;
+	if (!read_batch_manifest(argv[0], jobs, error)) {
+		print_error("%s\n", error.c_str());
+		return 1;
+	}
+	FILE *file = summary ? fl_fopen(summary, "w") : stdout;
+	if (!file) {
+		print_error("Cannot write %s\n", summary);
+		return 1;
+	}
+
+	std::map<std::string, std::unique_ptr<Shared_Tileset>> tilesets;
+	shared_tilesets = &tilesets;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	run_batch_jobs(jobs, threads, run_batch_job, (void *)"batch job");
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	shared_tilesets = NULL;
+	for (auto &[key, shared] : tilesets) {
+		shared->tileset.clear();
+	}
+
+	write_batch_summary(file, argv[0], jobs, threads, seconds);
+	if (summary) { fclose(file); }
+	bool ok = std::all_of(RANGE(jobs), [](const Batch_Job &job) { return job.status == 0; });
+	return ok ? 0 : 1;
+}
+
+static void forget_changed_tilesets() {
+	for (auto it = shared_tilesets->begin(); it != shared_tilesets->end();) {
+		Shared_Tileset &shared = *it->second;
+		const char *f = shared.filename.c_str();
+		if (file_modified(f) != shared.modified || file_size(f) != shared.size) {
+			shared.tileset.clear();
+			it = shared_tilesets->erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+static bool serve_request(const Server_Request &request, Server_Response &response, void *) {
+	if (request.args.size() == 1 && request.args[0] == "stop") {
+		response.output = "Stopped the server\n";
+		return false;
+	}
+	if (request.args.empty()) {
+		response.status = 2;
+		response.errors = "No command given\n";
+		return true;
+	}
+	// Requests run one at a time, so a tileset can be forgotten while nothing uses it
+	forget_changed_tilesets();
+	Batch_Job job;
+	job.args = request.args;
+	run_batch_job(job, (void *)"server request");
+	response.status = job.status;
+	response.output = std::move(job.output);
+	response.errors = std::move(job.errors);
+	return true;
+}
+
+static int serve_command(Context &, int argc, char **argv) {
+	std::string path = default_socket_path();
+	if (argc == 2 && !strcmp(argv[0], "-s")) {
+		path = argv[1];
+	}
+	else if (argc != 0) {
+		return -1;
+	}
+
+	// Decoded tilesets and palettes are kept until the server stops
+	std::map<std::string, std::unique_ptr<Shared_Tileset>> tilesets;
+	Palette_Cache palettes;
+	shared_tilesets = &tilesets;
+	palette_cache = &palettes;
+	print_output("Listening on %s\n", path.c_str());
+	fflush(stdout);
+	std::string error;
+	bool ok = serve(path.c_str(), serve_request, NULL, error);
+	shared_tilesets = NULL;
+	palette_cache = NULL;
+	for (auto &[key, shared] : tilesets) {
+		shared->tileset.clear();
+	}
+
+	if (!ok) {
+		print_error("%s\n", error.c_str());
+		return 1;
+	}
+	return 0;
+}
+
+int run_command_line(int argc, char **argv) {
+	if (argc < 2) { return -1; }
+	const Command *cmd = find_command(argv[1]);
+	if (!cmd) { return -1; }
+	// Made once here, since batch jobs on other threads share them
+	Tile_State::alpha(PALETTE_BG_ALPHA);
+	Context ctx;
+	return run_command(*cmd, ctx, argc - 2, argv + 2);
+}
@@ -0,0 +1,8 @@
+#ifndef CLI_H
+#define CLI_H
+
+// Runs a subcommand like "tilemapstudio report ..." without opening a window.
+// Returns the exit status, or -1 if the arguments are not a subcommand.
+int run_command_line(int argc, char **argv);
+
+#endif
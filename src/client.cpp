@@ -0,0 +1,37 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include "server.h"
+
+// tilemapstudio-client passes its arguments to a running "tilemapstudio serve" and prints the result,
+// so build rules can run subcommands without starting the whole program for each file.
+
+int main(int argc, char **argv) {
+	std::string path = default_socket_path();
+	int i = 1;
+	if (argc > 2 && !strcmp(argv[1], "-s")) {
+		path = argv[2];
+		i = 3;
+	}
+	if (i >= argc) {
+		fprintf(stderr, "Usage: tilemapstudio-client [-s SOCKET] COMMAND [ARGS...]\n"
+			"Runs a tilemapstudio subcommand on a running server, or stops it with \"stop\"\n");
+		return 2;
+	}
+
+	Server_Request request;
+	std::error_code ec;
+	request.cwd = std::filesystem::current_path(ec).string();
+	request.args.assign(argv + i, argv + argc);
+	Server_Response response;
+	std::string error;
+	if (!send_request(path.c_str(), request, response, error)) {
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+	fwrite(response.output.data(), 1, response.output.size(), stdout);
+	fwrite(response.errors.data(), 1, response.errors.size(), stderr);
+	return response.status;
+}
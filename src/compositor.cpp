@@ -0,0 +1,344 @@
+
+#pragma warning(push, 0)
+#include <FL/Fl.H>
+#include <FL/fl_draw.H>
+#pragma warning(pop)
+
+#include "config.h"
+#include "tilemap.h"
+#include "tile-buttons.h"
+#include "draw-stats.h"
+#include "compositor.h"
+
+static void get_rgb(Fl_Color c, uchar *rgb) {
+	Fl::get_color(c, rgb[0], rgb[1], rgb[2]);
+}
+
+static inline void blend(uchar *dst, const uchar *src, int a) {
+	dst[0] = (uchar)((src[0] * a + dst[0] * (0xFF - a)) / 0xFF);
+	dst[1] = (uchar)((src[1] * a + dst[1] * (0xFF - a)) / 0xFF);
+	dst[2] = (uchar)((src[2] * a + dst[2] * (0xFF - a)) / 0xFF);
+}
+
+static inline void copy_rgb(uchar *dst, const uchar *src) {
+	dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2];
+}
+
+// Point a cell at a tile-sized area of an image, in units of the image's drawn size
+static bool source_cell(Compositor::Cell &cell, const Fl_RGB_Image *img, int x, int y, int size) {
+	if (!img || img->fail() || !img->count() || img->d() < 1 || img->d() > 4 || !img->w() || !img->h()) { return false; }
+	// Images rendered on a scaled display have more data pixels than drawn pixels
+	int dw = img->data_w(), dh = img->data_h();
+	cell.data = (const uchar *)img->data()[0];
+	cell.d = img->d();
+	cell.ld = img->ld() ? img->ld() : dw * cell.d;
+	cell.sx = x * dw / img->w();
+	cell.sy = y * dh / img->h();
+	cell.sw = size * dw / img->w();
+	cell.sh = size * dh / img->h();
+	return cell.sw > 0 && cell.sh > 0;
+}
+
+Compositor::Compositor() : _cells(), _buffer(), _x(0), _y(0), _w(0), _h(0), _ox(0), _oy(0), _col0(0), _row0(0),
+	_cols(0), _size(0), _grid(false), _bg(), _grid_dark(), _grid_light(), _highlight_dark(), _highlight_light(),
+	_workers(), _mutex(), _start(), _done(), _frame(0), _bands(0), _band_rows(0), _pending(0), _stopping(false) {}
+
+Compositor::~Compositor() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_start.notify_all();
+	for (std::thread &t : _workers) {
+		t.join();
+	}
+}
+
+bool Compositor::prepare(const Tilemap &tilemap, int x, int y, int w, int h, Fl_Color bg) {
+	size_t n = tilemap.size(), tw = tilemap.width(), th = tilemap.height();
+	if (!n || !tw || w <= 0 || h <= 0) { return false; }
+	int z = Config::zoom(), s = TILE_SIZE * z;
+	const Tile_Tessera *first = tilemap.tile(0);
+	_ox = first->x();
+	_oy = first->y();
+	_size = s;
+
+	// Only the area covered by tiles is composited; the workspace draws its own background around them
+	int x0 = std::max(x, _ox), y0 = std::max(y, _oy);
+	int x1 = std::min(x + w, _ox + (int)tw * s), y1 = std::min(y + h, _oy + (int)th * s);
+	if (x1 <= x0 || y1 <= y0) { return false; }
+	_x = x0; _y = y0; _w = x1 - x0; _h = y1 - y0;
+	_col0 = (x0 - _ox) / s;
+	_row0 = (y0 - _oy) / s;
+	_cols = (x1 - _ox + s - 1) / s - _col0;
+	int rows = (y1 - _oy + s - 1) / s - _row0;
+
+	// Look up every visible tile's images here, since some are rendered on demand and FLTK is single-threaded
+	bool attrs = Config::show_attributes();
+	int style = (int)Config::bold_palettes();
+	_cells.assign((size_t)_cols * rows, Cell());
+	for (int r = 0; r < rows; r++) {
+		for (int c = 0; c < _cols; c++) {
+			size_t i = (size_t)(_row0 + r) * tw + _col0 + c;
+			// Past the end of a non-rectangular tilemap
+			if (i >= n) { continue; }
+			const Tile_State ts = tilemap.tile(i)->state();
+			Cell &cell = _cells[(size_t)r * _cols + c];
+			int tx = 0, ty = 0;
+			Fl_RGB_Image *img = ts.tileset_image(Config::context(), tx, ty);
+			if (img) {
+				if (!source_cell(cell, img, tx, ty, TILE_SIZE)) { return false; }
+				cell.x_flip = ts.x_flip;
+				cell.y_flip = ts.y_flip;
+			}
+			else {
+				// Labels show flips with their color, not by flipping
+				img = ts.glyph(z, false, tx, ty);
+				if (!source_cell(cell, img, tx, ty, s)) { return false; }
+			}
+			cell.highlighted = ts.highlighted();
+			if (attrs) {
+				Fl_RGB_Image *overlay = ts.attribute_overlay(z, style);
+				if (overlay) { cell.overlay = (const uchar *)overlay->data()[0]; }
+			}
+		}
+	}
+
+	_grid = Config::grid();
+	get_rgb(bg, _bg);
+	get_rgb(fl_rgb_color(0x40), _grid_dark);
+	get_rgb(fl_rgb_color(0xD0), _grid_light);
+	get_rgb(FL_DARK_YELLOW, _highlight_dark);
+	get_rgb(FL_YELLOW, _highlight_light);
+	return true;
+}
+
+void Compositor::present() {
+	_buffer.resize((size_t)_w * _h * 3);
+	// Split the buffer into bands of rows, one per thread; this thread composites the first band
+	int threads = std::max((int)std::thread::hardware_concurrency(), 1);
+	while ((int)_workers.size() < threads - 1) {
+		_workers.emplace_back(&Compositor::work, this, (int)_workers.size() + 1);
+	}
+	int bands = std::clamp(_h / MIN_COMPOSITOR_BAND_ROWS, 1, threads);
+	int rows = (_h + bands - 1) / bands;
+	bands = (_h + rows - 1) / rows;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_bands = bands;
+		_band_rows = rows;
+		_pending = bands - 1;
+		_frame++;
+	}
+	if (bands > 1) { _start.notify_all(); }
+	composite_rows(0, std::min(rows, _h));
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_done.wait(lock, [this]() { return !_pending; });
+	}
+	fl_draw_image(_buffer.data(), _x, _y, _w, _h, 3);
+	Draw_Stats::tiles_composited(_cells.size());
+}
+
+void Compositor::work(int band) {
+	size_t frame = 0;
+	for (;;) {
+		int y0, y1;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_start.wait(lock, [&]() { return _stopping || _frame != frame; });
+			if (_stopping) { return; }
+			frame = _frame;
+			// Short frames leave the later workers idle
+			if (band >= _bands) { continue; }
+			y0 = band * _band_rows;
+			y1 = std::min(y0 + _band_rows, _h);
+		}
+		composite_rows(y0, y1);
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!--_pending) { _done.notify_one(); }
+		}
+	}
+}
+
+void Compositor::composite_rows(int y0, int y1) {
+	for (int py = y0; py < y1; py++) {
+		int my = _y + py - _oy;
+		int r = my / _size - _row0, ly = my % _size;
+		uchar *out = _buffer.data() + (size_t)py * _w * 3;
+		for (int px = 0; px < _w;) {
+			int mx = _x + px - _ox;
+			int c = mx / _size - _col0, lx = mx % _size;
+			int lx1 = std::min(_size, lx + _w - px);
+			composite_cell(_cells[(size_t)r * _cols + c], out + px * 3, lx, lx1, ly);
+			px += lx1 - lx;
+		}
+	}
+}
+
+void Compositor::composite_cell(const Cell &c, uchar *out, int lx0, int lx1, int ly) const {
+	int s = _size;
+	int fy = c.y_flip ? s - 1 - ly : ly;
+	const uchar *src_row = c.data ? c.data + (size_t)(c.sy + fy * c.sh / s) * c.ld : NULL;
+	for (int lx = lx0; lx < lx1; lx++, out += 3) {
+		copy_rgb(out, _bg);
+		if (src_row) {
+			int fx = c.x_flip ? s - 1 - lx : lx;
+			const uchar *p = src_row + (size_t)(c.sx + fx * c.sw / s) * c.d;
+			uchar rgb[3];
+			int a = 0xFF;
+			switch (c.d) {
+			case 1: rgb[0] = rgb[1] = rgb[2] = p[0]; break;
+			case 2: rgb[0] = rgb[1] = rgb[2] = p[0]; a = p[1]; break;
+			case 3: copy_rgb(rgb, p); break;
+			default: copy_rgb(rgb, p); a = p[3]; break;
+			}
+			blend(out, rgb, a);
+		}
+		if (c.overlay) {
+			const uchar *o = c.overlay + ((size_t)ly * s + lx) * 4;
+			if (o[3]) { blend(out, o, o[3]); }
+		}
+		// Same pattern as draw_grid: a dark line under dashes that start light
+		if (_grid && lx == s - 1) {
+			copy_rgb(out, ly / 2 % 2 ? _grid_dark : _grid_light);
+		}
+		else if (_grid && ly == s - 1) {
+			copy_rgb(out, lx / 2 % 2 ? _grid_dark : _grid_light);
+		}
+		if (c.highlighted) {
+			int ring = std::min(std::min(lx, ly), std::min(s - 1 - lx, s - 1 - ly));
+			if (ring == 0) { copy_rgb(out, _highlight_dark); }
+			else if (ring == 1) { copy_rgb(out, _highlight_light); }
+		}
+	}
+}
+
+Tilemap_Workspace::Tilemap_Workspace(int x, int y, int w, int h, const Tilemap *tm) : Workspace(x, y, w, h),
+	_tilemap(tm), _compositor(), _view_x(0), _view_y(0), _view_w(0), _view_h(0), _scroll_unseen(false) {}
+
+void Tilemap_Workspace::view(double &x, double &y, double &w, double &h) const {
+	double s = TILE_SIZE * Config::zoom();
+	x = _view_x / s;
+	y = _view_y / s;
+	w = _view_w / s;
+	h = _view_h / s;
+}
+
+void Tilemap_Workspace::center_on(double tx, double ty) {
+	double s = TILE_SIZE * Config::zoom();
+	int X, Y, W, H;
+	bbox(X, Y, W, H);
+	scroll_clamped((int)(tx * s) - W / 2, (int)(ty * s) - H / 2);
+}
+
+void Tilemap_Workspace::damage_tiles(const Tile_Rect &r) {
+	if (r.empty() || !_tilemap || !_tilemap->size()) { return; }
+	const Tile_Tessera *tt = _tilemap->tile(r.left, r.top);
+	if (!tt) { return; }
+	// Tiles outside the damaged region are neither composited nor drawn
+	int s = TILE_SIZE * Config::zoom();
+	int W = (int)(r.right - r.left) * s, H = (int)(r.bottom - r.top) * s;
+	damage(FL_DAMAGE_ALL, tt->x(), tt->y(), W, H);
+}
+
+// Lays out the scrollbars the way Fl_Scroll::draw does, but takes the children's bounds from the tilemap
+// instead of visiting every tile; returns false if a scrollbar has to appear, disappear, or move
+bool Tilemap_Workspace::update_scrollbars() {
+	const Tile_Tessera *first = _tilemap->tile(0);
+	int s = TILE_SIZE * Config::zoom();
+	int cl = first->x(), ct = first->y();
+	int cr = cl + (int)std::min(_tilemap->width(), _tilemap->size()) * s, cb = ct + (int)_tilemap->height() * s;
+
+	int bx = x() + Fl::box_dx(box()), by = y() + Fl::box_dy(box());
+	int bw = w() - Fl::box_dw(box()), bh = h() - Fl::box_dh(box());
+	int X = bx, Y = by, W = bw, H = bh;
+	int ss = scrollbar_size() ? scrollbar_size() : Fl::scrollbar_size();
+	bool vneeded = false, hneeded = false;
+	if ((type() & VERTICAL) && ((type() & ALWAYS_ON) || ct < Y || cb > Y + H)) {
+		vneeded = true;
+		W -= ss;
+		if (scrollbar.align() & FL_ALIGN_LEFT) { X += ss; }
+	}
+	if ((type() & HORIZONTAL) && ((type() & ALWAYS_ON) || cl < X || cr > X + W)) {
+		hneeded = true;
+		H -= ss;
+		if (scrollbar.align() & FL_ALIGN_TOP) { Y += ss; }
+		if (!vneeded && (type() & VERTICAL) && ((type() & ALWAYS_ON) || ct < Y || cb > Y + H)) {
+			vneeded = true;
+			W -= ss;
+			if (scrollbar.align() & FL_ALIGN_LEFT) { X += ss; }
+		}
+	}
+	if (vneeded != !!scrollbar.visible() || hneeded != !!hscrollbar.visible()) { return false; }
+
+	int vx = scrollbar.align() & FL_ALIGN_LEFT ? bx : bx + bw - ss;
+	int hy = scrollbar.align() & FL_ALIGN_TOP ? by : by + bh - ss;
+	if (scrollbar.x() != vx || scrollbar.y() != Y || scrollbar.w() != ss || scrollbar.h() != H ||
+		hscrollbar.x() != X || hscrollbar.y() != hy || hscrollbar.w() != W || hscrollbar.h() != ss) {
+		return false;
+	}
+
+	int hpos = X - cl, hfirst = 0, htotal = cr - cl;
+	if (hpos < 0) { htotal -= hpos; hfirst = hpos; }
+	int vpos = Y - ct, vfirst = 0, vtotal = cb - ct;
+	if (vpos < 0) { vtotal -= vpos; vfirst = vpos; }
+	hscrollbar.value(hpos, W, hfirst, htotal);
+	scrollbar.value(vpos, H, vfirst, vtotal);
+	return true;
+}
+
+void Tilemap_Workspace::draw() {
+	int X, Y, W, H;
+	bbox(X, Y, W, H);
+	if (xposition() != _view_x || yposition() != _view_y || W != _view_w || H != _view_h) {
+		_view_x = xposition(); _view_y = yposition(); _view_w = W; _view_h = H;
+		do_callback();
+	}
+	// Tiles are damaged through damage_tiles, which clips drawing to them; any tile that was damaged by itself
+	// just draws itself
+	bool composite = false;
+	if (_tilemap && _tilemap->size() && active_r() && (damage() & ~FL_DAMAGE_CHILD)) {
+		fix_scrollbar_order();
+		int cx = 0, cy = 0, cw = 0, ch = 0;
+		fl_clip_box(X, Y, W, H, cx, cy, cw, ch);
+		composite = cw > 0 && ch > 0 && update_scrollbars() &&
+			_compositor.prepare(*_tilemap, cx, cy, cw, ch, color());
+	}
+	if (!composite) {
+		// Fl_Scroll blits the last frame by how far it thinks the view has moved since it last drew
+		if (_scroll_unseen && (damage() & FL_DAMAGE_SCROLL)) { clear_damage(damage() | FL_DAMAGE_ALL); }
+		_scroll_unseen = false;
+		OS_Scroll::draw();
+		return;
+	}
+
+	// Draw what Fl_Scroll::draw would, without visiting every tile
+	uchar d = damage();
+	if (d & FL_DAMAGE_SCROLL) { _scroll_unseen = true; }
+	if (d & FL_DAMAGE_ALL) {
+		draw_box(box(), x(), y(), w(), h(), color());
+	}
+	fl_push_clip(X, Y, W, H);
+	fl_rectf(X, Y, W, H, color());
+	_compositor.present();
+	// The tile under the mouse draws its own border
+	Fl_Widget *wgt = Fl::belowmouse();
+	if (wgt && wgt->parent() == this && wgt->type() == Tile_Tessera::TILE_TESSERA_TYPE &&
+		fl_not_clipped(wgt->x(), wgt->y(), wgt->w(), wgt->h())) {
+		((Tile_Tessera *)wgt)->draw();
+	}
+	fl_pop_clip();
+	if (d & (FL_DAMAGE_ALL | FL_DAMAGE_SCROLL)) {
+		draw_child(scrollbar);
+		draw_child(hscrollbar);
+		if (scrollbar.visible() && hscrollbar.visible()) {
+			fl_rectf(scrollbar.x(), hscrollbar.y(), scrollbar.w(), hscrollbar.h(), color());
+		}
+	}
+	else {
+		update_child(scrollbar);
+		update_child(hscrollbar);
+	}
+}
@@ -0,0 +1,77 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#pragma warning(push, 0)
+#include <FL/Enumerations.H>
+#pragma warning(pop)
+
+#include "utils.h"
+#include "widgets.h"
+
+#define MIN_COMPOSITOR_BAND_ROWS 64
+
+class Tilemap;
+struct Tile_Rect;
+
+// Renders the visible part of a tilemap into one RGB buffer from the tileset, label, and attribute
+// images, so a repaint costs one image draw instead of several draw calls per tile
+class Compositor {
+public:
+	struct Cell {
+		const uchar *data = NULL;
+		int d = 0, ld = 0;
+		// The tile's top-left corner and size in source pixels
+		int sx = 0, sy = 0, sw = 0, sh = 0;
+		bool x_flip = false, y_flip = false, highlighted = false;
+		const uchar *overlay = NULL;
+	};
+private:
+	std::vector<Cell> _cells;
+	std::vector<uchar> _buffer;
+	int _x, _y, _w, _h;
+	int _ox, _oy, _col0, _row0, _cols, _size;
+	bool _grid;
+	uchar _bg[3], _grid_dark[3], _grid_light[3], _highlight_dark[3], _highlight_light[3];
+	// Threads that live as long as the compositor; each frame, worker b composites band b + 1
+	std::vector<std::thread> _workers;
+	std::mutex _mutex;
+	std::condition_variable _start, _done;
+	size_t _frame;
+	int _bands, _band_rows, _pending;
+	bool _stopping;
+public:
+	Compositor();
+	~Compositor();
+	bool prepare(const Tilemap &tilemap, int x, int y, int w, int h, Fl_Color bg);
+	void present(void);
+private:
+	void work(int band);
+	void composite_rows(int y0, int y1);
+	void composite_cell(const Cell &c, uchar *out, int lx0, int lx1, int ly) const;
+};
+
+class Tilemap_Workspace : public Workspace {
+private:
+	const Tilemap *_tilemap;
+	Compositor _compositor;
+	int _view_x, _view_y, _view_w, _view_h;
+	// Whether a composited frame scrolled without Fl_Scroll::draw seeing it
+	bool _scroll_unseen;
+public:
+	Tilemap_Workspace(int x, int y, int w, int h, const Tilemap *tm);
+	// The visible area in tile units; the callback runs whenever it changes
+	void view(double &x, double &y, double &w, double &h) const;
+	void center_on(double tx, double ty);
+	// Repaints a rectangle of tiles; only the visible part of it is composited
+	void damage_tiles(const Tile_Rect &r);
+	void draw(void);
+private:
+	bool update_scrollbars(void);
+};
+
+#endif
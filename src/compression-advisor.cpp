@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+#include "lz.h"
+#include "compression-advisor.h"
+
+static const char *encoding_names[NUM_ENCODINGS] = {
+	"Plain",                // PLAIN
+	"RBY RLE",              // RBY_RLE
+	"Pok\xc3\xa9gear RLE",  // POKEGEAR_RLE
+	"SW RLE",               // SW_RLE
+	"Crystal LZ",           // CRYSTAL_LZ
+	"GBA LZ77",             // GBA_LZ77
+};
+
+const char *encoding_name(Encoding enc) {
+	return encoding_names[(int)enc];
+}
+
+// Rough costs of the reference decoders in CPU cycles of their platform: the Game Boy routines from the
+// Pokemon disassemblies for plain, RLE and Crystal LZ data, and the GBA BIOS LZ77UnCompWram for GBA LZ77.
+// They are only meant for ranking encodings of the same data.
+#define PLAIN_CYCLES_PER_BYTE 24
+#define RLE_CYCLES_PER_RUN 96
+#define RLE_CYCLES_PER_BYTE 24
+#define CRYSTAL_LZ_CYCLES_PER_COMMAND 180
+#define CRYSTAL_LZ_CYCLES_PER_LITERAL 40
+#define CRYSTAL_LZ_CYCLES_PER_FILL 28
+#define CRYSTAL_LZ_CYCLES_PER_COPY 52
+#define CRYSTAL_LZ_CYCLES_PER_TRANSFORM 64
+#define GBA_LZ77_CYCLES_PER_FLAGS 20
+#define GBA_LZ77_CYCLES_PER_LITERAL 14
+#define GBA_LZ77_CYCLES_PER_MATCH 32
+#define GBA_LZ77_CYCLES_PER_BYTE 9
+
+static size_t estimate_cycles(Encoding enc, const std::vector<uchar> &encoded, size_t plain_size) {
+	Lz_Profile profile;
+	size_t runs = 0;
+	switch (enc) {
+	case Encoding::PLAIN:
+		return encoded.size() * PLAIN_CYCLES_PER_BYTE;
+	case Encoding::RBY_RLE:
+		// One byte per run, plus the end marker
+		runs = encoded.empty() ? 0 : encoded.size() - 1;
+		return runs * RLE_CYCLES_PER_RUN + plain_size * RLE_CYCLES_PER_BYTE;
+	case Encoding::POKEGEAR_RLE:
+	case Encoding::SW_RLE:
+		// Two bytes per run, plus the end marker
+		runs = encoded.empty() ? 0 : (encoded.size() - 1) / 2;
+		return runs * RLE_CYCLES_PER_RUN + plain_size * RLE_CYCLES_PER_BYTE;
+	case Encoding::CRYSTAL_LZ:
+		profile = Lz::profile_crystal(encoded);
+		return profile.commands * CRYSTAL_LZ_CYCLES_PER_COMMAND + profile.literal_bytes * CRYSTAL_LZ_CYCLES_PER_LITERAL +
+			profile.fill_bytes * CRYSTAL_LZ_CYCLES_PER_FILL + profile.copy_bytes * CRYSTAL_LZ_CYCLES_PER_COPY +
+			profile.transform_bytes * CRYSTAL_LZ_CYCLES_PER_TRANSFORM;
+	case Encoding::GBA_LZ77:
+		profile = Lz::profile_gba(encoded);
+		return (profile.literal_bytes + profile.commands + 7) / 8 * GBA_LZ77_CYCLES_PER_FLAGS +
+			profile.literal_bytes * GBA_LZ77_CYCLES_PER_LITERAL + profile.commands * GBA_LZ77_CYCLES_PER_MATCH +
+			profile.copy_bytes * GBA_LZ77_CYCLES_PER_BYTE;
+	default:
+		return 0;
+	}
+}
+
+static Compression_Estimate make_estimate(const std::string &subject, Encoding enc, const std::vector<uchar> &encoded,
+	size_t plain_size, unsigned int generation) {
+	return {subject, enc, plain_size, encoded.size(), estimate_cycles(enc, encoded, plain_size), generation, true};
+}
+
+static Compression_Estimate unencodable_estimate(const std::string &subject, Encoding enc, size_t plain_size,
+	unsigned int generation) {
+	return {subject, enc, plain_size, 0, 0, generation, false};
+}
+
+std::vector<std::future<Compression_Estimate>> Compression_Advisor::launch(const Compression_Subject &subject,
+	unsigned int generation) {
+	std::vector<std::future<Compression_Estimate>> futures;
+	size_t n = subject.plain.size();
+	// Plain and RLE forms are already encoded, so measuring them is immediate
+	std::promise<Compression_Estimate> plain;
+	plain.set_value(make_estimate(subject.name, Encoding::PLAIN, subject.plain, n, generation));
+	futures.push_back(plain.get_future());
+	for (const auto &[enc, bytes] : subject.rle) {
+		std::promise<Compression_Estimate> rle;
+		rle.set_value(make_estimate(subject.name, enc, bytes, n, generation));
+		futures.push_back(rle.get_future());
+	}
+	// The LZ encoders run concurrently, sharing one copy of the input
+	auto data = std::make_shared<const std::vector<uchar>>(subject.plain);
+	std::string name = subject.name;
+	futures.push_back(std::async(std::launch::async, [data, name, generation]() {
+		std::vector<uchar> lz_data;
+		if (Lz::compress_crystal(*data, lz_data) != Lz::Result::LZ_OK) {
+			return unencodable_estimate(name, Encoding::CRYSTAL_LZ, data->size(), generation);
+		}
+		return make_estimate(name, Encoding::CRYSTAL_LZ, lz_data, data->size(), generation);
+	}));
+	futures.push_back(std::async(std::launch::async, [data, name, generation]() {
+		std::vector<uchar> lz_data;
+		if (Lz::compress_gba(*data, lz_data) != Lz::Result::LZ_OK) {
+			return unencodable_estimate(name, Encoding::GBA_LZ77, data->size(), generation);
+		}
+		return make_estimate(name, Encoding::GBA_LZ77, lz_data, data->size(), generation);
+	}));
+	return futures;
+}
+
+bool Compression_Advisor::pending(const std::string &name) const {
+	return std::any_of(RANGE(_pending), [&](const Pending &p) { return p.subject == name; });
+}
+
+void Compression_Advisor::begin(const Compression_Subject &subject) {
+	forget(subject.name);
+	unsigned int generation = ++_generation;
+	_generations[subject.name] = generation;
+	std::vector<std::future<Compression_Estimate>> futures = launch(subject, generation);
+	for (std::future<Compression_Estimate> &f : futures) {
+		_pending.push_back({subject.name, std::move(f)});
+	}
+}
+
+void Compression_Advisor::start(const Compression_Subject &subject) {
+	// The running estimates keep showing until they finish, and only the latest change is started then
+	if (pending(subject.name)) {
+		_deferred[subject.name] = subject;
+		return;
+	}
+	begin(subject);
+	poll();
+}
+
+void Compression_Advisor::forget(const std::string &name) {
+	_deferred.erase(name);
+	_generations.erase(name);
+	_estimates.erase(std::remove_if(RANGE(_estimates), [&](const Compression_Estimate &e) {
+		return e.subject == name;
+	}), _estimates.end());
+}
+
+bool Compression_Advisor::poll() {
+	bool updated = false;
+	for (auto it = _deferred.begin(); it != _deferred.end();) {
+		if (pending(it->first)) {
+			++it;
+			continue;
+		}
+		Compression_Subject subject = std::move(it->second);
+		it = _deferred.erase(it);
+		begin(subject);
+		updated = true;
+	}
+	for (auto it = _pending.begin(); it != _pending.end();) {
+		if (it->estimate.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			++it;
+			continue;
+		}
+		Compression_Estimate e = it->estimate.get();
+		it = _pending.erase(it);
+		// Drop results for subjects that were forgotten or restarted in the meantime
+		auto g = _generations.find(e.subject);
+		if (g == _generations.end() || g->second != e.generation) { continue; }
+		_estimates.push_back(e);
+		updated = true;
+	}
+	if (updated) {
+		std::stable_sort(RANGE(_estimates), [](const Compression_Estimate &a, const Compression_Estimate &b) {
+			return a.generation < b.generation || (a.generation == b.generation && a.encoding < b.encoding);
+		});
+	}
+	return updated;
+}
+
+std::vector<Compression_Estimate> Compression_Advisor::estimate(const std::vector<Compression_Subject> &subjects) {
+	std::vector<std::future<Compression_Estimate>> futures;
+	for (const Compression_Subject &subject : subjects) {
+		std::vector<std::future<Compression_Estimate>> f = launch(subject, 0);
+		std::move(RANGE(f), std::back_inserter(futures));
+	}
+	std::vector<Compression_Estimate> estimates;
+	estimates.reserve(futures.size());
+	for (std::future<Compression_Estimate> &f : futures) {
+		estimates.push_back(f.get());
+	}
+	return estimates;
+}
+
+static std::string html_escape(const std::string &s) {
+	std::string escaped;
+	escaped.reserve(s.size());
+	for (char c : s) {
+		switch (c) {
+		case '&': escaped += "&amp;"; break;
+		case '<': escaped += "&lt;"; break;
+		case '>': escaped += "&gt;"; break;
+		case '"': escaped += "&quot;"; break;
+		default: escaped += c;
+		}
+	}
+	return escaped;
+}
+
+std::string compression_report(const std::vector<Compression_Estimate> &estimates, bool html) {
+	std::vector<Compression_Estimate> sorted(estimates);
+	// Unencodable estimates sort after the rest of their subject, so they are never its best encoding
+	std::stable_sort(RANGE(sorted), [](const Compression_Estimate &a, const Compression_Estimate &b) {
+		if (a.generation != b.generation) { return a.generation < b.generation; }
+		if (a.subject != b.subject) { return a.subject < b.subject; }
+		if (a.encodable != b.encodable) { return a.encodable; }
+		return a.size < b.size;
+	});
+	std::string report;
+	char buffer[512] = {};
+	if (html) {
+		report += "<table border=\"1\" cellpadding=\"2\" width=\"100%\">\n"
+			"<tr><th>Data</th><th>Encoding</th><th>Bytes</th><th>Ratio</th><th>Est. cycles</th></tr>\n";
+	}
+	else {
+		snprintf(buffer, sizeof(buffer), "%-32s %-16s %10s %7s %12s\n", "Data", "Encoding", "Bytes", "Ratio", "Est. cycles");
+		report += buffer;
+	}
+	for (size_t i = 0; i < sorted.size(); i++) {
+		const Compression_Estimate &e = sorted[i];
+		// The first row of each subject is its smallest encoding
+		bool best = i == 0 || sorted[i-1].subject != e.subject;
+		if (!e.encodable) {
+			if (html) {
+				report += "<tr><td>";
+				if (best) { report += html_escape(e.subject); }
+				snprintf(buffer, sizeof(buffer), "</td><td>%s</td><td align=\"right\" colspan=\"3\">Too large</td></tr>\n",
+					encoding_name(e.encoding));
+			}
+			else {
+				snprintf(buffer, sizeof(buffer), "%-32s %-16s %10s\n", best ? e.subject.c_str() : "",
+					encoding_name(e.encoding), "Too large");
+			}
+			report += buffer;
+			continue;
+		}
+		double ratio = e.plain_size ? 100.0 * e.size / e.plain_size : 100.0;
+		if (html) {
+			const char *b = best ? "<b>" : "", *eb = best ? "</b>" : "";
+			// Subjects are filenames, which may hold markup characters; they go in their own string so that
+			// escaping a long one cannot overflow the buffer
+			report += "<tr><td>";
+			if (best) { report += b + html_escape(e.subject) + eb; }
+			snprintf(buffer, sizeof(buffer),
+				"</td><td>%s%s%s</td><td align=\"right\">%s%zu%s</td><td align=\"right\">%.1f%%</td>"
+				"<td align=\"right\">%zu</td></tr>\n", b, encoding_name(e.encoding), eb, b, e.size, eb, ratio, e.cycles);
+		}
+		else {
+			snprintf(buffer, sizeof(buffer), "%-32s %-16s %10zu %6.1f%% %12zu\n", best ? e.subject.c_str() : "",
+				encoding_name(e.encoding), e.size, ratio, e.cycles);
+		}
+		report += buffer;
+	}
+	if (html) {
+		report += "</table>\n";
+	}
+	return report;
+}
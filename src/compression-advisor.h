@@ -0,0 +1,63 @@
+#ifndef COMPRESSION_ADVISOR_H
+#define COMPRESSION_ADVISOR_H
+
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core.h"
+
+#define NUM_ENCODINGS 6
+
+enum class Encoding { PLAIN, RBY_RLE, POKEGEAR_RLE, SW_RLE, CRYSTAL_LZ, GBA_LZ77 };
+
+const char *encoding_name(Encoding enc);
+
+// A serialized tilemap or tileset, along with any RLE forms it can be stored as
+struct Compression_Subject {
+	std::string name;
+	std::vector<uchar> plain;
+	std::vector<std::pair<Encoding, std::vector<uchar>>> rle;
+};
+
+struct Compression_Estimate {
+	std::string subject;
+	Encoding encoding;
+	size_t plain_size, size, cycles;
+	unsigned int generation;
+	// False for data too large for the encoding's header or decoder, which has no size or cycles
+	bool encodable;
+};
+
+// Lists each subject's encodings from smallest to largest, as an HTML table or as plain text
+std::string compression_report(const std::vector<Compression_Estimate> &estimates, bool html);
+
+class Compression_Advisor {
+private:
+	struct Pending {
+		std::string subject;
+		std::future<Compression_Estimate> estimate;
+	};
+	std::vector<Pending> _pending;
+	// Subjects that changed while they were still being estimated; each starts once its last estimates finish,
+	// so a subject never has more than one set of LZ encoders running
+	std::unordered_map<std::string, Compression_Subject> _deferred;
+	std::vector<Compression_Estimate> _estimates;
+	std::unordered_map<std::string, unsigned int> _generations;
+	unsigned int _generation = 0;
+public:
+	inline bool busy(void) const { return !_pending.empty() || !_deferred.empty(); }
+	inline const std::vector<Compression_Estimate> &estimates(void) const { return _estimates; }
+	void start(const Compression_Subject &subject);
+	void forget(const std::string &name);
+	bool poll(void);
+	static std::vector<Compression_Estimate> estimate(const std::vector<Compression_Subject> &subjects);
+private:
+	bool pending(const std::string &name) const;
+	void begin(const Compression_Subject &subject);
+	static std::vector<std::future<Compression_Estimate>> launch(const Compression_Subject &subject, unsigned int generation);
+};
+
+#endif
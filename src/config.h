@@ -1,6 +1,8 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <vector>
+
 #include "utils.h"
 #include "tilemap-format.h"
 
@@ -8,40 +10,57 @@
 #define MAX_ZOOM 10
 #define DEFAULT_ZOOM 2
 
+class Tileset;
+
+// What reading, editing, and printing tilemaps and tilesets depends on. The editor keeps one for its
+// whole session; each command-line job makes its own, so batch jobs can run at the same time.
+struct Context {
+	Tilemap_Format format = Tilemap_Format::PLAIN;
+	int zoom = DEFAULT_ZOOM;
+	bool print_grid = false, print_rainbow_tiles = false, print_palettes = false, print_bold_palettes = false;
+	// Later tilesets cover earlier ones
+	std::vector<Tileset> *tilesets = NULL;
+};
+
 class Config {
 private:
-	static Tilemap_Format _format;
-	static int _zoom;
+	static Context _context;
 	static bool _grid, _rainbow_tiles, _bold_palettes;
-	static bool _print_grid, _print_rainbow_tiles, _print_palettes, _print_bold_palettes;
 	static uint16_t _highlight_id;
 	static bool _show_attributes;
-	static bool _auto_load_tileset;
+	static bool _auto_load_tileset, _auto_reload;
+	static bool _find_flipped;
 public:
-	inline static Tilemap_Format format(void) { return _format; }
-	inline static void format(Tilemap_Format fmt) { _format = fmt; }
-	inline static int zoom(void) { return _zoom; }
-	inline static void zoom(int z) { _zoom = z; }
+	inline static Context &context(void) { return _context; }
+	inline static Tilemap_Format format(void) { return _context.format; }
+	inline static void format(Tilemap_Format fmt) { _context.format = fmt; }
+	inline static int zoom(void) { return _context.zoom; }
+	inline static void zoom(int z) { _context.zoom = z; }
+	inline static void tilesets(std::vector<Tileset> *ts) { _context.tilesets = ts; }
 	inline static bool grid(void) { return _grid; }
 	inline static void grid(bool g) { _grid = g; }
 	inline static bool rainbow_tiles(void) { return _rainbow_tiles; }
 	inline static void rainbow_tiles(bool r) { _rainbow_tiles = r; }
 	inline static bool bold_palettes(void) { return _bold_palettes; }
 	inline static void bold_palettes(bool b) { _bold_palettes = b; }
-	inline static bool print_grid(void) { return _print_grid; }
-	inline static void print_grid(bool g) { _print_grid = g; }
-	inline static bool print_rainbow_tiles(void) { return _print_rainbow_tiles; }
-	inline static void print_rainbow_tiles(bool r) { _print_rainbow_tiles = r; }
-	inline static bool print_palettes(void) { return _print_palettes; }
-	inline static void print_palettes(bool p) { _print_palettes = p; }
-	inline static bool print_bold_palettes(void) { return _print_bold_palettes; }
-	inline static void print_bold_palettes(bool b) { _print_bold_palettes = b; }
+	inline static bool print_grid(void) { return _context.print_grid; }
+	inline static void print_grid(bool g) { _context.print_grid = g; }
+	inline static bool print_rainbow_tiles(void) { return _context.print_rainbow_tiles; }
+	inline static void print_rainbow_tiles(bool r) { _context.print_rainbow_tiles = r; }
+	inline static bool print_palettes(void) { return _context.print_palettes; }
+	inline static void print_palettes(bool p) { _context.print_palettes = p; }
+	inline static bool print_bold_palettes(void) { return _context.print_bold_palettes; }
+	inline static void print_bold_palettes(bool b) { _context.print_bold_palettes = b; }
 	inline static uint16_t highlight_id(void) { return _highlight_id; }
 	inline static void highlight_id(uint16_t id) { _highlight_id = id; }
 	inline static bool show_attributes(void) { return _show_attributes; }
 	inline static void show_attributes(bool a) { _show_attributes = a; }
 	inline static bool auto_load_tileset(void) { return _auto_load_tileset; }
 	inline static void auto_load_tileset(bool a) { _auto_load_tileset = a; }
+	inline static bool auto_reload(void) { return _auto_reload; }
+	inline static void auto_reload(bool a) { _auto_reload = a; }
+	inline static bool find_flipped(void) { return _find_flipped; }
+	inline static void find_flipped(bool f) { _find_flipped = f; }
 };
 
 #endif
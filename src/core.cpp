@@ -0,0 +1,43 @@
+#include <cctype>
+#include <algorithm>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+#include "core.h"
+
+#ifdef _WIN32
+static std::wstring wide_string(const char *s) {
+	int n = MultiByteToWideChar(CP_UTF8, 0, s, -1, NULL, 0);
+	std::wstring ws(n > 0 ? n : 1, L'\0');
+	if (n > 0) { MultiByteToWideChar(CP_UTF8, 0, s, -1, ws.data(), n); }
+	return ws;
+}
+#endif
+
+FILE *open_file(const char *f, const char *mode) {
+#ifdef _WIN32
+	return _wfopen(wide_string(f).c_str(), wide_string(mode).c_str());
+#else
+	return fopen(f, mode);
+#endif
+}
+
+static bool cmp_ignore_case(const char &a, const char &b) {
+	return tolower(a) == tolower(b);
+}
+
+bool starts_with_ignore_case(std::string_view s, std::string_view p) {
+	if (s.size() < p.size()) { return false; }
+	std::string_view ss = s.substr(0, p.size());
+	return std::equal(RANGE(ss), RANGE(p), cmp_ignore_case);
+}
+
+bool ends_with_ignore_case(std::string_view s, std::string_view p) {
+	if (s.size() < p.size()) { return false; }
+	std::string_view ss = s.substr(s.size() - p.size());
+	return std::equal(RANGE(ss), RANGE(p), cmp_ignore_case);
+}
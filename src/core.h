@@ -0,0 +1,65 @@
+#ifndef CORE_H
+#define CORE_H
+
+// The core library (libtilemapstudio) builds without FLTK, so other tools can link the same
+// tilemap codecs, tile packing, LZ, and image writers as the editor. The few FLTK types it shares
+// with the editor are declared here exactly as FLTK declares them.
+
+#include <cstdio>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+typedef unsigned char uchar;   // as in <FL/fl_types.h>
+typedef unsigned int Fl_Color; // as in <FL/Enumerations.H>
+
+#ifndef _countof
+#define _countof(a) (sizeof(a) / sizeof(a[0]))
+#endif
+
+#define RANGE(x) std::begin(x), std::end(x)
+
+#define HI_NYB(n) (uchar)(((n) & 0xF0) >> 4)
+#define LO_NYB(n) (uchar)((n) & 0x0F)
+#define LE16(n) (uchar)((n) & 0xFFUL), (uchar)(((n) & 0xFF00UL) >> 8)
+#define LE32(n) (uchar)((n) & 0xFFUL), (uchar)(((n) & 0xFF00UL) >> 8), (uchar)(((n) & 0xFF0000UL) >> 16), (uchar)(((n) & 0xFF000000UL) >> 24)
+#define BE16(n) (uchar)(((n) & 0xFF00UL) >> 8), (uchar)((n) & 0xFFUL)
+#define BE32(n) (uchar)(((n) & 0xFF000000UL) >> 24), (uchar)(((n) & 0xFF0000UL) >> 16), (uchar)(((n) & 0xFF00UL) >> 8), (uchar)((n) & 0xFFUL)
+
+typedef uint8_t size8_t;
+typedef uint16_t size16_t;
+typedef uint32_t size32_t;
+typedef uint64_t size64_t;
+
+#define BLACK_COLOR ((Fl_Color)56) // FL_BLACK, since color 0 is the theme's foreground color
+
+#define MAX_PALETTE_LENGTH 256
+
+typedef std::vector<Fl_Color> Palette;
+typedef std::vector<Palette> Palettes;
+
+// Same as fl_rgb_color
+inline Fl_Color rgb_color(uchar r, uchar g, uchar b) {
+	return !r && !g && !b ? BLACK_COLOR : (Fl_Color)(((((r << 8) | g) << 8) | b) << 8);
+}
+
+// Same as Fl::get_color for RGB colors; the core makes no other colors but black
+inline void get_rgb(Fl_Color c, uchar &r, uchar &g, uchar &b) {
+	if (c & 0xFFFFFF00) {
+		r = (uchar)(c >> 24);
+		g = (uchar)(c >> 16);
+		b = (uchar)(c >> 8);
+	}
+	else {
+		r = g = b = 0;
+	}
+}
+
+// Same as fl_fopen, taking a UTF-8 filename
+FILE *open_file(const char *f, const char *mode);
+
+bool starts_with_ignore_case(std::string_view s, std::string_view p);
+bool ends_with_ignore_case(std::string_view s, std::string_view p);
+
+#endif
@@ -0,0 +1,45 @@
+#include <algorithm>
+
+#include "core.h"
+#include "depfile.h"
+
+void Dependencies::target(const std::string &f) {
+	if (!f.empty() && std::find(RANGE(targets), f) == targets.end()) {
+		targets.push_back(f);
+	}
+}
+
+void Dependencies::prerequisite(const std::string &f) {
+	if (!f.empty() && std::find(RANGE(prerequisites), f) == prerequisites.end()) {
+		prerequisites.push_back(f);
+	}
+}
+
+static void write_make_name(FILE *file, const std::string &f) {
+	for (char c : f) {
+		if (c == ' ' || c == '\t' || c == '#') { fputc('\\', file); }
+		else if (c == '$') { fputc('$', file); }
+		fputc(c, file);
+	}
+}
+
+bool write_depfile(const char *f, const Dependencies &deps) {
+	FILE *file = open_file(f, "w");
+	if (!file) { return false; }
+	for (size_t i = 0; i < deps.targets.size(); i++) {
+		if (i) { fputc(' ', file); }
+		write_make_name(file, deps.targets[i]);
+	}
+	fputc(':', file);
+	for (const std::string &p : deps.prerequisites) {
+		fputs(" \\\n ", file);
+		write_make_name(file, p);
+	}
+	fputc('\n', file);
+	for (const std::string &p : deps.prerequisites) {
+		fputc('\n', file);
+		write_make_name(file, p);
+		fputs(":\n", file);
+	}
+	return !fclose(file);
+}
@@ -0,0 +1,18 @@
+#ifndef DEPFILE_H
+#define DEPFILE_H
+
+#include <string>
+#include <vector>
+
+// The files a command wrote and the files it read, so make can rebuild only what changed
+struct Dependencies {
+	std::vector<std::string> targets, prerequisites;
+	void target(const std::string &f);
+	void prerequisite(const std::string &f);
+};
+
+// Writes a makefile rule like gcc -MD -MP: the targets depend on every prerequisite, and each
+// prerequisite gets an empty rule of its own so make does not fail after one is deleted.
+bool write_depfile(const char *f, const Dependencies &deps);
+
+#endif
@@ -0,0 +1,59 @@
+#include <cstdio>
+
+#include "draw-stats.h"
+
+typedef std::chrono::steady_clock Clock;
+
+Frame_Stats Draw_Stats::_current, Draw_Stats::_last;
+bool Draw_Stats::_overlay = false, Draw_Stats::_logging = false, Draw_Stats::_in_frame = false;
+Clock::time_point Draw_Stats::_frame_start;
+unsigned long Draw_Stats::_frame = 0;
+
+static uint64_t elapsed_ns(Clock::time_point start) {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+Draw_Stats::Timer::Timer(Cost c) : _total(NULL), _start() {
+	if (!timing()) { return; }
+	_total = c == Cost::GRID ? &_current.grid_ns : &_current.attribute_ns;
+	_start = Clock::now();
+}
+
+Draw_Stats::Timer::~Timer() {
+	if (_total) {
+		*_total += elapsed_ns(_start);
+	}
+}
+
+void Draw_Stats::begin_frame(size_t damage_area) {
+	_current = Frame_Stats();
+	_current.damage_area = damage_area;
+	_in_frame = true;
+	if (timing()) {
+		_frame_start = Clock::now();
+	}
+}
+
+void Draw_Stats::end_frame() {
+	if (!_in_frame) { return; }
+	_in_frame = false;
+	if (timing()) {
+		_current.draw_ns = elapsed_ns(_frame_start);
+	}
+	_last = _current;
+	_current = Frame_Stats();
+	_frame++;
+	if (_logging) {
+		fprintf(stderr, "frame %lu: %.3f ms, %zu px damaged, %zu tiles (%zu composited), %zu blits, %zu flipped, "
+			"%zu labels, %zu grids (%.3f ms), %zu attributes (%.3f ms)\n", _frame, _last.draw_ns / 1e6, _last.damage_area,
+			_last.tiles, _last.composited, _last.blits, _last.flipped_blits, _last.labels, _last.grids, _last.grid_ns / 1e6,
+			_last.attributes, _last.attribute_ns / 1e6);
+	}
+}
+
+void Draw_Stats::describe(char *buffer, size_t n) {
+	snprintf(buffer, n, "Frame %lu: %.2f ms\nDamage: %zu px\nTiles: %zu (%zu composited)\nBlits: %zu cached, %zu flipped\n"
+		"Labels: %zu\nGrid: %zu (%.2f ms)\nAttributes: %zu (%.2f ms)", _frame, _last.draw_ns / 1e6, _last.damage_area,
+		_last.tiles, _last.composited, _last.blits, _last.flipped_blits, _last.labels, _last.grids, _last.grid_ns / 1e6, _last.attributes,
+		_last.attribute_ns / 1e6);
+}
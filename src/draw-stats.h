@@ -0,0 +1,53 @@
+#ifndef DRAW_STATS_H
+#define DRAW_STATS_H
+
+#include <chrono>
+
+#include "utils.h"
+
+// Per-frame drawing counters. Counting is a few integer increments per tile, so it is always compiled in;
+// the clock is only read while the overlay or the log is on.
+struct Frame_Stats {
+	uint64_t draw_ns = 0;
+	size_t damage_area = 0;
+	size_t tiles = 0, composited = 0;
+	size_t blits = 0, flipped_blits = 0, labels = 0;
+	size_t grids = 0, attributes = 0;
+	uint64_t grid_ns = 0, attribute_ns = 0;
+};
+
+class Draw_Stats {
+public:
+	enum class Cost { GRID, ATTRIBUTES };
+	class Timer {
+	private:
+		uint64_t *_total;
+		std::chrono::steady_clock::time_point _start;
+	public:
+		Timer(Cost c);
+		~Timer();
+	};
+private:
+	static Frame_Stats _current, _last;
+	static bool _overlay, _logging, _in_frame;
+	static std::chrono::steady_clock::time_point _frame_start;
+	static unsigned long _frame;
+public:
+	inline static bool overlay(void) { return _overlay; }
+	inline static void overlay(bool o) { _overlay = o; }
+	inline static bool logging(void) { return _logging; }
+	inline static void logging(bool l) { _logging = l; }
+	inline static bool timing(void) { return _overlay || _logging; }
+	inline static const Frame_Stats &last(void) { return _last; }
+	inline static void tile_drawn(void) { _current.tiles++; }
+	inline static void tiles_composited(size_t n) { _current.tiles += n; _current.composited += n; }
+	inline static void tile_blitted(bool flipped) { if (flipped) { _current.flipped_blits++; } else { _current.blits++; } }
+	inline static void tile_labeled(void) { _current.labels++; }
+	inline static void grid_drawn(void) { _current.grids++; }
+	inline static void attributes_drawn(void) { _current.attributes++; }
+	static void begin_frame(size_t damage_area);
+	static void end_frame(void);
+	static void describe(char *buffer, size_t n);
+};
+
+#endif
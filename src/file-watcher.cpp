@@ -0,0 +1,135 @@
+#include <algorithm>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+#pragma warning(push, 0)
+#include <FL/Fl.H>
+#include <FL/filename.H>
+#pragma warning(pop)
+
+#include "utils.h"
+#include "file-watcher.h"
+
+File_Watcher::File_Watcher(Changed_Cb cb, void *data) : _cb(cb), _data(data), _files(), _fd(-1) {
+#ifdef __linux__
+	_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_fd >= 0) {
+		Fl::add_fd(_fd, FL_READ, (Fl_FD_Handler)events_cb, this);
+	}
+#endif
+}
+
+File_Watcher::~File_Watcher() {
+	Fl::remove_timeout((Fl_Timeout_Handler)settle_cb, this);
+	Fl::remove_timeout((Fl_Timeout_Handler)poll_cb, this);
+#ifdef __linux__
+	if (_fd >= 0) {
+		Fl::remove_fd(_fd);
+		close(_fd);
+	}
+#endif
+}
+
+File_Watcher::Stamp File_Watcher::file_stamp(const char *f) {
+	Stamp stamp;
+	if (!file_exists(f)) { return stamp; }
+	stamp.modified = file_modified(f);
+	stamp.size = (int64_t)file_size(f);
+	return stamp;
+}
+
+void File_Watcher::watch(const std::vector<std::string> &filenames) {
+#ifdef __linux__
+	for (const Watched_File &wf : _files) {
+		if (wf.wd >= 0) { inotify_rm_watch(_fd, wf.wd); }
+	}
+#endif
+	_files.clear();
+	Fl::remove_timeout((Fl_Timeout_Handler)settle_cb, this);
+	Fl::remove_timeout((Fl_Timeout_Handler)poll_cb, this);
+	for (const std::string &f : filenames) {
+		if (f.empty() || std::any_of(RANGE(_files), [&](const Watched_File &wf) { return wf.filename == f; })) {
+			continue;
+		}
+		Watched_File wf;
+		wf.filename = f;
+		wf.name = fl_filename_name(f.c_str());
+		wf.wd = -1;
+		wf.stamp = file_stamp(f.c_str());
+#ifdef __linux__
+		if (_fd >= 0) {
+			std::string dir = f.substr(0, f.size() - wf.name.size());
+			// Watching the same directory again returns the same descriptor
+			wf.wd = inotify_add_watch(_fd, dir.empty() ? "." : dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		}
+#endif
+		_files.push_back(wf);
+	}
+	if (_fd < 0 && !_files.empty()) {
+		Fl::add_timeout(WATCH_POLL_DELAY, (Fl_Timeout_Handler)poll_cb, this);
+	}
+}
+
+void File_Watcher::settle() {
+	// Wait for a pause in the changes, since a tool may write a file in several steps
+	Fl::remove_timeout((Fl_Timeout_Handler)settle_cb, this);
+	Fl::add_timeout(WATCH_SETTLE_DELAY, (Fl_Timeout_Handler)settle_cb, this);
+}
+
+void File_Watcher::check() {
+	std::vector<std::string> changed;
+	for (Watched_File &wf : _files) {
+		Stamp stamp = file_stamp(wf.filename.c_str());
+		// A missing file is probably being replaced, and is reported once it is back
+		if (stamp.size < 0 || stamp == wf.stamp) { continue; }
+		wf.stamp = stamp;
+		changed.push_back(wf.filename);
+	}
+	// The callback may watch other files, so it comes last
+	if (!changed.empty()) {
+		_cb(changed, _data);
+	}
+}
+
+void File_Watcher::events_cb(int fd, File_Watcher *fw) {
+#ifdef __linux__
+	alignas(struct inotify_event) char buffer[4096];
+	bool relevant = false;
+	for (;;) {
+		ssize_t n = read(fd, buffer, sizeof(buffer));
+		if (n <= 0) { break; }
+		for (ssize_t i = 0; i < n;) {
+			const struct inotify_event *event = (const struct inotify_event *)(buffer + i);
+			if (event->len) {
+				relevant = relevant || std::any_of(RANGE(fw->_files), [&](const Watched_File &wf) {
+					return wf.wd == event->wd && wf.name == event->name;
+				});
+			}
+			i += sizeof(struct inotify_event) + event->len;
+		}
+	}
+	if (relevant) {
+		fw->settle();
+	}
+#else
+	(void)fd;
+	(void)fw;
+#endif
+}
+
+void File_Watcher::settle_cb(File_Watcher *fw) {
+	fw->check();
+}
+
+void File_Watcher::poll_cb(File_Watcher *fw) {
+	if (std::any_of(RANGE(fw->_files), [](const Watched_File &wf) {
+		Stamp stamp = file_stamp(wf.filename.c_str());
+		return stamp.size >= 0 && stamp != wf.stamp;
+	})) {
+		fw->settle();
+	}
+	Fl::repeat_timeout(WATCH_POLL_DELAY, (Fl_Timeout_Handler)poll_cb, fw);
+}
@@ -0,0 +1,46 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define WATCH_SETTLE_DELAY 0.3 // seconds without changes before changed files are reported
+#define WATCH_POLL_DELAY 1.0 // seconds between checks without inotify
+
+// Reports files that changed on disk once they stop changing. On Linux, inotify watches each file's
+// directory, so tools that save by renaming a new file over the old one are noticed too; elsewhere,
+// the files' sizes and modification times are polled.
+class File_Watcher {
+public:
+	typedef void (*Changed_Cb)(const std::vector<std::string> &filenames, void *data);
+private:
+	struct Stamp {
+		int64_t modified = 0, size = -1;
+		inline bool operator==(const Stamp &other) const { return modified == other.modified && size == other.size; }
+		inline bool operator!=(const Stamp &other) const { return !(*this == other); }
+	};
+	struct Watched_File {
+		std::string filename, name;
+		int wd;
+		Stamp stamp;
+	};
+	Changed_Cb _cb;
+	void *_data;
+	std::vector<Watched_File> _files;
+	int _fd;
+public:
+	File_Watcher(Changed_Cb cb, void *data);
+	~File_Watcher();
+	// Replaces the watched files, taking their current contents as unchanged
+	void watch(const std::vector<std::string> &filenames);
+private:
+	static Stamp file_stamp(const char *f);
+	void settle(void);
+	void check(void);
+	static void events_cb(int fd, File_Watcher *fw);
+	static void settle_cb(File_Watcher *fw);
+	static void poll_cb(File_Watcher *fw);
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include <cstdlib>
+#include <vector>
+
+#include "lz.h"
+
+// A libFuzzer target for both LZ codecs: arbitrary bytes go to each decoder, whatever they decode to must
+// survive a round trip, and the bytes themselves must survive compressing and decompressing them.
+
+static void round_trip(bool gba, const std::vector<uchar> &data) {
+	std::vector<uchar> lz_data, decoded;
+	if (gba) {
+		if (Lz::compress_gba(data, lz_data) != Lz::Result::LZ_OK) { abort(); }
+		if (Lz::decompress_gba(lz_data, decoded) != Lz::Result::LZ_OK) { abort(); }
+	}
+	else {
+		if (Lz::compress_crystal(data, lz_data) != Lz::Result::LZ_OK) { abort(); }
+		if (Lz::decompress_crystal(lz_data, decoded) != Lz::Result::LZ_OK) { abort(); }
+	}
+	if (decoded != data) { abort(); }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *bytes, size_t size) {
+	std::vector<uchar> input(bytes, bytes + size), data;
+	// Decoded data can be far longer than its input, so only round-trip the sizes a fuzzer input could be
+	if (Lz::decompress_gba(input, data) == Lz::Result::LZ_OK && data.size() <= 0x10000) {
+		round_trip(true, data);
+	}
+	if (Lz::decompress_crystal(input, data) == Lz::Result::LZ_OK && data.size() <= 0x10000) {
+		round_trip(false, data);
+	}
+	round_trip(true, input);
+	round_trip(false, input);
+	return 0;
+}
@@ -1,15 +1,14 @@
+#include <cstring>
 #include <string>
 #include <vector>
-#include <set>
 #include <map>
-#include <iterator>
 
 #pragma warning(push, 0)
 #include <FL/Fl.H>
 #include <FL/Fl_PNG_Image.H>
 #include <FL/Fl_GIF_Image.H>
 #include <FL/Fl_BMP_Image.H>
-#include <FL/Fl_Image_Surface.H>
+#include <FL/filename.H>
 #pragma warning(pop)
 
 #include "utils.h"
@@ -18,50 +17,9 @@
 #include "tilemap.h"
 #include "tileset.h"
 #include "tile.h"
-#include "main-window.h"
-
-typedef std::set<Fl_Color> Color_Set;
-
-static bool build_tilemap(const Tile *tiles, size_t n, const std::vector<int> tile_palettes, Tilemap &tilemap, std::vector<size_t> &tileset,
-	Tilemap_Format fmt, bool allow_unique, bool allow_flip, uint16_t start_id, bool use_blank, uint16_t blank_id, Fl_Color blank_color) {
-	size_t mn = (size_t)format_tileset_size(fmt);
-	tilemap.resize(n, 1, 0, 0);
-	tileset.reserve(mn);
-	allow_flip &= format_can_flip(fmt);
-	size_t tc = 0;
-	for (size_t i = 0; i < n; i++) {
-		if (use_blank && start_id + tileset.size() == blank_id) {
-			size_t j = 0;
-			for (; j < n; j++) {
-				if (is_blank_tile(tiles[j], blank_color)) { break; }
-			}
-			tileset.push_back(j);
-		}
-		const Tile &tile = tiles[i];
-		if (use_blank && is_blank_tile(tile, blank_color)) {
-			tilemap.tile(tc++, 0, new Tile_Tessera(0, 0, 0, 0, blank_id, false, false, false, false, tile_palettes[i]));
-			continue;
-		}
-		size_t ti = 0, nt = tileset.size();
-		bool x_flip = false, y_flip = false;
-		for (; ti < nt; ti++) {
-			size_t j = tileset[ti];
-			if (allow_unique && are_identical_tiles(tile, tiles[j], allow_flip, x_flip, y_flip)) {
-				break;
-			}
-		}
-		if (ti == nt) {
-			if (nt + (size_t)start_id > mn) {
-				return false;
-			}
-			tileset.push_back(i);
-		}
-		uint16_t id = start_id + (uint16_t)ti;
-		tilemap.tile(tc++, 0, new Tile_Tessera(0, 0, 0, 0, id, x_flip, y_flip, false, false, tile_palettes[i]));
-	}
-	tilemap.resize(tc, 1, 0, 0);
-	return true;
-}
+#include "tile-packer.h"
+#include "depfile.h"
+#include "image-to-tiles.h"
 
 static int fit_width(int nt, int dw) {
 	if (nt % dw == 0) { return dw; }
@@ -75,15 +33,9 @@ static int fit_width(int nt, int dw) {
 	return w;
 }
 
-static Fl_RGB_Image *print_tileset(const Tile *tiles, const std::vector<size_t> &tileset, const Palettes &palettes,
-	const std::vector<int> &tile_palettes, size_t nc, int tw, Fl_Color blank_color, bool indexed, uint8_t start_index) {
-	int nt = (int)tileset.size();
-	tw = std::min(nt, tw);
-	int th = (nt + tw - 1) / tw;
-
-	size_t np = palettes.size();
+static std::vector<std::map<Fl_Color, size_t>> reverse_palettes_of(const Palettes &palettes, size_t nc) {
 	std::vector<std::map<Fl_Color, size_t>> reverse_palettes;
-	reverse_palettes.reserve(np);
+	reverse_palettes.reserve(palettes.size());
 	for (const Palette &palette : palettes) {
 		std::map<Fl_Color, size_t> reverse_palette;
 		for (size_t i = 0; i < nc; i++) {
@@ -91,14 +43,30 @@ static Fl_RGB_Image *print_tileset(const Tile *tiles, const std::vector<size_t>
 		}
 		reverse_palettes.push_back(reverse_palette);
 	}
+	return reverse_palettes;
+}
 
-	Fl_Image_Surface *surface = new Fl_Image_Surface(tw * TILE_SIZE, th * TILE_SIZE);
-	surface->set_current();
+static Fl_RGB_Image *print_tileset(const Tile *tiles, const std::vector<size_t> &tileset, const Palettes &palettes,
+	const std::vector<int> &tile_palettes, size_t nc, int tw, Fl_Color blank_color, bool indexed, uint8_t start_index) {
+	int nt = (int)tileset.size();
+	tw = std::min(nt, tw);
+	int th = (nt + tw - 1) / tw;
+
+	size_t np = palettes.size();
+	std::vector<std::map<Fl_Color, size_t>> reverse_palettes = reverse_palettes_of(palettes, nc);
+
+	// Fill a buffer directly instead of drawing to an image surface, which would need a display
+	int iw = tw * TILE_SIZE, ih = th * TILE_SIZE;
+	uchar *buffer = new uchar[(size_t)iw * ih * NUM_CHANNELS];
 
 	size_t ntp = tile_palettes.size();
 	size_t ps = indexed ? MAX_PALETTE_LENGTH : nc;
-	Fl_Color extra = indexed ? Image::get_indexed_grayscale(start_index * nc, ps) : blank_color;
-	fl_rectf(0, 0, tw * TILE_SIZE, th * TILE_SIZE, extra);
+	Fl_Color extra = indexed ? indexed_grayscale(start_index * nc, ps) : blank_color;
+	uchar r, g, b;
+	Fl::get_color(extra, r, g, b);
+	for (size_t i = 0; i < (size_t)iw * ih * NUM_CHANNELS; i += NUM_CHANNELS) {
+		buffer[i] = r; buffer[i+1] = g; buffer[i+2] = b;
+	}
 	for (int i = 0; i < nt; i++) {
 		size_t ti = tileset[i];
 		const Tile &tile = tiles[ti];
@@ -106,38 +74,106 @@ static Fl_RGB_Image *print_tileset(const Tile *tiles, const std::vector<size_t>
 		if (p == -1 && indexed) { continue; }
 		int x = i % tw, y = i / tw;
 		for (int ty = 0; ty < TILE_SIZE; ty++) {
+			uchar *row = buffer + ((size_t)(y * TILE_SIZE + ty) * iw + x * TILE_SIZE) * NUM_CHANNELS;
 			for (int tx = 0; tx < TILE_SIZE; tx++) {
 				Fl_Color c = tile[ty * TILE_SIZE + tx];
 				if (p > -1) {
 					size_t pi = reverse_palettes[np == 1 ? p - start_index : p][c];
 					if (indexed) { pi += start_index * nc; }
-					c = Image::get_indexed_grayscale(pi, ps);
+					c = indexed_grayscale(pi, ps);
 				}
-				fl_color(c);
-				fl_point(x * TILE_SIZE + tx, y * TILE_SIZE + ty);
+				uchar *px = row + tx * NUM_CHANNELS;
+				Fl::get_color(c, px[0], px[1], px[2]);
 			}
 		}
 	}
 
-	Fl_RGB_Image *img = surface->image();
-	delete surface;
-	Fl_Display_Device::display_device()->set_current();
-
+	Fl_RGB_Image *img = new Fl_RGB_Image(buffer, iw, ih, NUM_CHANNELS);
+	img->alloc_array = 1;
 	return img;
 }
 
-static double luminance(Fl_Color c) {
-	uchar r, g, b;
-	Fl::get_color(c, r, g, b);
-	return 0.299 * (double)r + 0.587 * (double)g + 0.114 * (double)b;
+static std::vector<uchar> index_tileset(const Tile *tiles, const std::vector<size_t> &tileset, const Palettes &palettes,
+	const std::vector<int> &tile_palettes, size_t nc, uint8_t start_index, int bpp) {
+	size_t nt = tileset.size(), np = palettes.size(), ntp = tile_palettes.size();
+	std::vector<std::map<Fl_Color, size_t>> reverse_palettes = reverse_palettes_of(palettes, nc);
+	// Without a palette, darker colors get higher indexes, like the grayscale hues of a loaded tileset
+	int max_index = (1 << bpp) - 1;
+
+	std::vector<uchar> pixels;
+	pixels.reserve(nt * NUM_TILE_PIXELS);
+	for (size_t ti : tileset) {
+		const Tile &tile = tiles[ti];
+		int p = ti < ntp ? tile_palettes[ti] : -1;
+		for (Fl_Color c : tile) {
+			if (p > -1) {
+				pixels.push_back((uchar)reverse_palettes[np == 1 ? p - start_index : p][c]);
+			}
+			else {
+				pixels.push_back((uchar)((255.0 - luminance(c)) * max_index / 255.0 + 0.5));
+			}
+		}
+	}
+	return pixels;
 }
 
-Image_to_Tiles_Result Main_Window::image_to_tiles() {
-	Image_to_Tiles_Result output = {};
+Fl_Color color_zero_from_hex(const char *s) {
+	char rgb[7] = {};
+	if (size_t n = strlen(s); n < 6) {
+		memset(rgb, '0', 6 - n);
+	}
+	strncat(rgb, s, 6);
+
+	char buffer[3] = {};
+	buffer[0] = rgb[0];
+	buffer[1] = rgb[1];
+	uchar r = (uchar)strtoul(buffer, NULL, 16);
+	buffer[0] = rgb[2];
+	buffer[1] = rgb[3];
+	uchar g = (uchar)strtoul(buffer, NULL, 16);
+	buffer[0] = rgb[4];
+	buffer[1] = rgb[5];
+	uchar b = (uchar)strtoul(buffer, NULL, 16);
+
+	return fl_rgb_color(NORMRGB(r), NORMRGB(g), NORMRGB(b));
+}
+
+void Image_to_Tiles_Options::output_filenames(const char *tileset_f) {
+	tileset_filename = tileset_f;
+
+	// Other outputs replace the whole compound extension of "name.2bpp.lz"
+	char base_filename[FL_PATH_MAX] = {};
+	strcpy(base_filename, tileset_f);
+	if (ends_with_ignore_case(base_filename, ".lz")) {
+		fl_filename_setext(base_filename, sizeof(base_filename), "");
+	}
 
+	char output_filename[FL_PATH_MAX] = {};
+	strcpy(output_filename, base_filename);
+	fl_filename_setext(output_filename, sizeof(output_filename), format_extension(fmt));
+	tilemap_filename = output_filename;
+
+	strcpy(output_filename, base_filename);
+	fl_filename_setext(output_filename, sizeof(output_filename), ATTRMAP_EXT);
+	attrmap_filename = output_filename;
+
+	strcpy(output_filename, base_filename);
+	const char *palette_ext = palette_extension(pal_fmt);
+	if (palette_ext) {
+		fl_filename_setext(output_filename, sizeof(output_filename), palette_ext);
+	}
+	palette_filename = output_filename;
+
+	strcpy(output_filename, base_filename);
+	fl_filename_setext(output_filename, sizeof(output_filename), TILEPAL_EXT);
+	tilepal_filename = output_filename;
+}
+
+bool image_to_tiles(const Image_to_Tiles_Options &opts, size_t &width, std::string &message,
+	Palette_Cache *palette_cache) {
 	// Open the input image
 
-	const char *image_filename = _image_to_tiles_dialog->image_filename();
+	const char *image_filename = opts.image_filename.c_str();
 	const char *image_basename = fl_filename_name(image_filename);
 
 	Fl_RGB_Image *img = NULL;
@@ -155,297 +191,197 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 	}
 	if (!img || img->fail()) {
 		delete img;
-		std::string msg = "Could not convert ";
-		msg = msg + image_basename + "!\n\nCannot open file.";
-		_error_dialog->message(msg);
-		_error_dialog->show(this);
-		return output;
+		message = "Could not convert ";
+		message = message + image_basename + "!\n\nCannot open file.";
+		return false;
 	}
 
 	// Read the input image tiles
 
-	Tilemap_Format fmt = _image_to_tiles_dialog->format();
+	Tilemap_Format fmt = opts.fmt;
 	bool alt_norm = fmt == Tilemap_Format::NDS_4BPP || fmt == Tilemap_Format::NDS_8BPP; // Tinke expects 5-bit clean channels
 
-	bool use_color_zero = _image_to_tiles_dialog->color_zero();
-	Fl_Color color_zero = use_color_zero ? _image_to_tiles_dialog->fl_color_zero() : 0xFFFFFF00 /* white */;
+	bool use_color_zero = opts.use_color_zero;
+	Fl_Color color_zero = use_color_zero ? opts.color_zero : DEFAULT_COLOR_ZERO;
 	if (alt_norm) { color_zero &= ALT_NORM_MASK; }
 
 	size_t n = 0, w = 0;
-	Tile *tiles = get_image_tiles(img, n, w, alt_norm, color_zero);
+	Tile *tiles = get_image_tiles((const uchar *)img->data()[0], img->w(), img->h(), img->d(), img->ld(), n, w, alt_norm,
+		color_zero);
 	delete img;
 	if (!tiles || !n) {
 		delete [] tiles;
-		std::string msg = "Could not convert ";
-		msg = msg + image_basename + "!\n\nImage dimensions do not fit the "
+		message = "Could not convert ";
+		message = message + image_basename + "!\n\nImage dimensions do not fit the "
 			STRINGIFY(TILE_SIZE) "x" STRINGIFY(TILE_SIZE) " tile grid.";
-		_error_dialog->message(msg);
-		_error_dialog->show(this);
-		return output;
+		return false;
 	}
 
 	// Build the palette
 
-	Palette_Format pal_fmt = _image_to_tiles_dialog->palette_format();
-	bool make_palette = _image_to_tiles_dialog->palette() && format_can_make_palettes(fmt);
+	Palette_Format pal_fmt = opts.pal_fmt;
+	bool make_palette = opts.make_palette && format_can_make_palettes(fmt);
 
 	Palettes palettes;
 	std::vector<int> tile_palettes(n + 1, make_palette ? 0 : -1);
 	size_t max_colors = (size_t)format_palette_size(fmt);
-	uint8_t start_index = _image_to_tiles_dialog->start_index();
+	uint8_t start_index = opts.start_index;
 
 	if (make_palette) {
-		// Algorithm ported from superfamiconv
-		// <https://github.com/Optiroc/SuperFamiconv>
-
 		size_t max_palettes = (size_t)format_palettes_size(fmt);
-
-		// Get the color set of each tile
-		std::vector<Color_Set> cs_tiles;
-		cs_tiles.reserve(n);
-		size_t qi = 0;
-		for (; qi < n; qi++) {
-			const Tile &tile = tiles[qi];
-			Color_Set s;
-			if (use_color_zero) {
-				s.insert(color_zero);
-			}
-			for (Fl_Color c : tile) {
-				s.insert(c);
-			}
-			if (s.size() > max_colors) {
-				break;
-			}
-			cs_tiles.push_back(s);
-		}
+		size_t qi = palette_cache ?
+			palette_cache->make_palettes(tiles, n, max_colors, max_palettes, use_color_zero, color_zero, start_index,
+				palettes, tile_palettes) :
+			make_palettes(tiles, n, max_colors, max_palettes, use_color_zero, color_zero, start_index, palettes,
+				tile_palettes);
 
 		// Check that all color sets fit within the color limit
 		if (qi < n) {
 			size_t qx = qi % w, qy = qi / w;
 			delete [] tiles;
-			std::string msg = "Could not convert ";
-			msg = msg + image_basename + "!\n\nThe tile at (" +
+			message = "Could not convert ";
+			message = message + image_basename + "!\n\nThe tile at (" +
 				std::to_string(qx) + ", " + std::to_string(qy) +
 				") has more than " + std::to_string(max_colors) + " colors.";
-			_error_dialog->message(msg);
-			_error_dialog->show(this);
-			return output;
-		}
-
-		// Remove duplicate color sets
-		std::vector<Color_Set> cs_uniq(cs_tiles.size());
-		auto cs_uniq_last = std::copy_if(RANGE(cs_tiles), cs_uniq.begin(), [&](const Color_Set &s) {
-			return std::find(RANGE(cs_uniq), s) == cs_uniq.end();
-		});
-		cs_uniq.resize(std::distance(cs_uniq.begin(), cs_uniq_last));
-
-		// Remove color sets that are proper subsets of other color sets
-		std::vector<Color_Set> cs_full(cs_uniq.size());
-		auto cs_full_last = std::copy_if(RANGE(cs_uniq), cs_full.begin(), [&](const Color_Set &s) {
-			return !std::any_of(RANGE(cs_uniq), [&](const Color_Set &c) {
-				return s != c && std::includes(RANGE(c), RANGE(s));
-			});
-		});
-		cs_full.resize(std::distance(cs_full.begin(), cs_full_last));
-
-		// Combine color sets as long as they fit within the color limit
-		std::vector<Color_Set> cs_opt;
-		cs_opt.reserve(cs_full.size());
-		for (Color_Set &s : cs_full) {
-			Color_Set *b = NULL;
-			for (Color_Set &c : cs_opt) {
-				Color_Set d;
-				std::set_difference(RANGE(s), RANGE(c), std::inserter(d, d.begin()));
-				if (c.size() + d.size() <= max_colors) {
-					b = &c;
-				}
-			}
-			if (b) {
-				b->insert(RANGE(s));
-			}
-			else {
-				cs_opt.push_back(s);
-			}
-		}
-
-		// Sort color sets from most to fewest colors
-		std::stable_sort(RANGE(cs_opt), [](const Color_Set &a, const Color_Set &b) {
-			return a.size() > b.size();
-		});
-
-		// Sort each palette from brightest to darkest color, padded with black, keeping color 0 first
-		palettes.reserve(max_palettes);
-		for (Color_Set &s : cs_opt) {
-			Palette palette(RANGE(s));
-			std::sort(RANGE(palette), [use_color_zero, color_zero](Fl_Color a, Fl_Color b) {
-				if (use_color_zero) {
-					if (a == color_zero) { return true; }
-					if (b == color_zero) { return false; }
-				}
-				return luminance(a) > luminance(b);
-			});
-			if (max_palettes == 1) {
-				// Pad the palette to start at the right index
-				if (start_index > 1) {
-					palette.insert(palette.begin(), start_index - 1, FL_BLACK);
-				}
-				palette.insert(palette.begin(), color_zero);
-			}
-			if (palette.size() < max_colors) {
-				palette.insert(palette.end(), max_colors - palette.size(), FL_BLACK);
-			}
-			palettes.push_back(palette);
-		}
-
-		// Pad the palettes to start at the right index
-		if (max_palettes > 1) {
-			for (uint8_t i = 0; i < start_index; i++) {
-				Palette palette(max_colors, FL_BLACK);
-				palette[0] = color_zero;
-				palettes.insert(palettes.begin(), palette);
-			}
+			return false;
 		}
 
 		// Create the palette file
-		const char *palette_filename = _image_to_tiles_dialog->palette_filename();
+		const char *palette_filename = opts.palette_filename.c_str();
 		const char *palette_basename = fl_filename_name(palette_filename);
 		if (!write_palette(palette_filename, palettes, pal_fmt, max_colors)) {
 			delete [] tiles;
-			std::string msg = "Could not write to ";
-			msg = msg + palette_basename + "!";
-			_error_dialog->message(msg);
-			_error_dialog->show(this);
-			return output;
+			message = "Could not write to ";
+			message = message + palette_basename + "!";
+			return false;
 		}
 
 		// Check that the palettes fit within the palette limit
 		size_t np = palettes.size();
 		if (np > max_palettes) {
 			delete [] tiles;
-			std::string msg = "Could not convert ";
-			msg = msg + image_basename + "!\n\nThe tiles need more than " +
+			message = "Could not convert ";
+			message = message + image_basename + "!\n\nThe tiles need more than " +
 				std::to_string(max_palettes) + " palettes.\n\nAll " +
 				std::to_string(np) + " palettes were written to " + palette_basename + ".";
-			_error_dialog->message(msg);
-			_error_dialog->show(this);
-			return output;
+			return false;
 		}
 		else if (max_palettes == 1 && palettes[0].size() > max_colors) {
 			delete [] tiles;
-			std::string msg = "Could not convert ";
-			msg = msg + image_basename + "!\n\nThe tiles need more than " +
+			message = "Could not convert ";
+			message = message + image_basename + "!\n\nThe tiles need more than " +
 				std::to_string(max_colors) + " colors.\n\nAll " +
 				std::to_string(np) + " palettes were written to " + palette_basename + ".";
-			_error_dialog->message(msg);
-			_error_dialog->show(this);
-			return output;
+			return false;
 		}
 
-		// Associate tiles with palettes
-		for (size_t i = 0; i < n; i++) {
-			int pal = 0;
-			const Color_Set &s = cs_tiles[i];
-			for (size_t j = 0; j < np; j++) {
-				const Color_Set &c = cs_opt[j];
-				if (std::includes(RANGE(c), RANGE(s))) {
-					pal = (int)j;
-					break;
-				}
-			}
-			tile_palettes[i] = start_index + pal;
-		}
 		tile_palettes[n] = start_index; // Fail-safe blank tile at the end
 	}
 
 	// Build the tilemap and tileset
 
-	Tilemap tilemap;
+	std::vector<Tilemap_Entry> entries;
 	std::vector<size_t> tileset;
 
-	bool allow_unique = _image_to_tiles_dialog->unique_tiles();
-	bool allow_flip = _image_to_tiles_dialog->flip_tiles();
-	uint16_t start_id = _image_to_tiles_dialog->start_id();
-	bool use_blank = _image_to_tiles_dialog->use_blank();
-	uint16_t blank_id = _image_to_tiles_dialog->blank_id();
+	bool allow_unique = opts.allow_unique;
+	bool allow_flip = opts.allow_flip;
+	uint16_t start_id = opts.start_id;
+	bool use_blank = opts.use_blank;
+	uint16_t blank_id = opts.blank_id;
 
-	if (!build_tilemap(tiles, n, tile_palettes, tilemap, tileset, fmt, allow_unique, allow_flip, start_id, use_blank, blank_id, color_zero)) {
+	if (!pack_tiles(tiles, n, tile_palettes, fmt, allow_unique, allow_flip, start_id, use_blank, blank_id, color_zero, entries,
+		tileset)) {
 		delete [] tiles;
-		std::string msg = "Could not convert ";
-		msg = msg + image_basename + "!\n\nToo many unique tiles.";
-		_error_dialog->message(msg);
-		_error_dialog->show(this);
-		return output;
+		message = "Could not convert ";
+		message = message + image_basename + "!\n\nToo many unique tiles.";
+		return false;
 	}
 
 	// Get the output filenames
 
-	const char *tileset_filename = _image_to_tiles_dialog->tileset_filename();
-	const char *tilemap_filename = _image_to_tiles_dialog->tilemap_filename();
-	const char *attrmap_filename = _image_to_tiles_dialog->attrmap_filename();
+	const char *tileset_filename = opts.tileset_filename.c_str();
+	const char *tilemap_filename = opts.tilemap_filename.c_str();
+	const char *attrmap_filename = opts.attrmap_filename.c_str();
 	const char *tileset_basename = fl_filename_name(tileset_filename);
 	const char *tilemap_basename = fl_filename_name(tilemap_filename);
 
 	// Create the tilemap file
 
-	if (!tilemap.write_tiles(tilemap_filename, attrmap_filename, fmt)) {
+	std::vector<uchar> tilemap_bytes = make_tilemap_bytes(entries, fmt, entries.size(), 1);
+	if (!write_tilemap_bytes(tilemap_filename, attrmap_filename, tilemap_bytes, fmt)) {
 		delete [] tiles;
-		std::string msg = "Could not write to ";
-		msg = msg + tilemap_basename + "!";
-		_error_dialog->message(msg);
-		_error_dialog->show(this);
-		return output;
+		message = "Could not write to ";
+		message = message + tilemap_basename + "!";
+		return false;
 	}
 
 	// Create the tilepal file
 
 	if (make_palette && format_has_per_tile_palettes(fmt)) {
-		const char *tilepal_filename = _image_to_tiles_dialog->tilepal_filename();
+		const char *tilepal_filename = opts.tilepal_filename.c_str();
 		const char *tilepal_basename = fl_filename_name(tilepal_filename);
 		if (!write_tilepal(tilepal_filename, tileset, tile_palettes)) {
 			delete [] tiles;
-			std::string msg = "Could not write to ";
-			msg = msg + tilepal_basename + "!";
-			_error_dialog->message(msg);
-			_error_dialog->show(this);
-			return output;
+			message = "Could not write to ";
+			message = message + tilepal_basename + "!";
+			return false;
 		}
 	}
 
 	// Create the tileset file
 
-	int tw = tileset_width();
-	if (_image_to_tiles_dialog->no_extra_blank_tiles()) { tw = fit_width((int)tileset.size(), tw); }
-	bool indexed = make_palette && pal_fmt == Palette_Format::INDEXED;
-	Fl_RGB_Image *timg = print_tileset(tiles, tileset, palettes, tile_palettes, max_colors, tw, color_zero, indexed, start_index);
-	Image::Result result = indexed ? Image::write_image(tileset_filename, timg, 0, &palettes, max_colors) :
-		Image::write_image(tileset_filename, timg, make_palette ? format_color_depth(fmt) : 0);
-	delete timg;
-	if (result != Image::Result::IMAGE_OK) {
-		delete [] tiles;
-		std::string msg = "Could not write to ";
-		msg = msg + tileset_basename + "!\n\n" + Image::error_message(result);
-		_error_dialog->message(msg);
-		_error_dialog->show(this);
-		return output;
+	if (int bpp = Tileset::tile_data_bpp(tileset_filename); bpp) {
+		// Write console-native tile data instead of an image
+		std::vector<uchar> pixels = index_tileset(tiles, tileset, palettes, tile_palettes, max_colors, start_index, bpp);
+		Tileset::Result result = Tileset::write_tile_data(tileset_filename, pixels, format_tile_layout(fmt));
+		if (result != Tileset::Result::TILESET_OK) {
+			delete [] tiles;
+			message = "Could not write to ";
+			message = message + tileset_basename + "!\n\n" + Tileset::error_message(result);
+			return false;
+		}
+	}
+	else {
+		int tw = opts.tileset_width;
+		if (opts.no_extra_blank_tiles) { tw = fit_width((int)tileset.size(), tw); }
+		bool indexed = make_palette && pal_fmt == Palette_Format::INDEXED;
+		Fl_RGB_Image *timg = print_tileset(tiles, tileset, palettes, tile_palettes, max_colors, tw, color_zero, indexed, start_index);
+		Image::Result result = indexed ? Image::write_image(tileset_filename, timg, 0, &palettes, max_colors) :
+			Image::write_image(tileset_filename, timg, make_palette ? format_color_depth(fmt) : 0);
+		delete timg;
+		if (result != Image::Result::IMAGE_OK) {
+			delete [] tiles;
+			message = "Could not write to ";
+			message = message + tileset_basename + "!\n\n" + Image::error_message(result);
+			return false;
+		}
 	}
 
 	delete [] tiles;
 
-	// Alert the completed operation
+	// Create the dependency file
 
-	std::string msg = "Converted ";
-	msg = msg + image_basename + " to\n" + tilemap_basename + " and " + tileset_basename + "!";
-	_success_dialog->message(msg);
-	_success_dialog->show(this);
+	if (!opts.depfile_filename.empty()) {
+		Dependencies deps;
+		deps.target(tileset_filename);
+		deps.target(tilemap_filename);
+		if (format_has_attrmap(fmt)) { deps.target(attrmap_filename); }
+		if (make_palette) {
+			deps.target(opts.palette_filename);
+			if (format_has_per_tile_palettes(fmt)) { deps.target(opts.tilepal_filename); }
+		}
+		deps.prerequisite(image_filename);
+		if (!write_depfile(opts.depfile_filename.c_str(), deps)) {
+			message = "Could not write to ";
+			message = message + fl_filename_name(opts.depfile_filename.c_str()) + "!";
+			return false;
+		}
+	}
 
-	// Return the output data
+	// Describe the completed operation
 
-	output.tileset_filename = tileset_filename;
-	output.tilemap_filename = tilemap_filename;
-	output.attrmap_filename = attrmap_filename;
-	output.fmt = fmt;
-	output.width = w;
-	output.start_id = start_id;
-	output.success = true;
-	return output;
+	message = "Converted ";
+	message = message + image_basename + " to\n" + tilemap_basename + " and " + tileset_basename + "!";
+	width = w;
+	return true;
 }
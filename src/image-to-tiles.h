@@ -0,0 +1,43 @@
+#ifndef IMAGE_TO_TILES_H
+#define IMAGE_TO_TILES_H
+
+#include <cstdint>
+#include <string>
+
+#include "tilemap-format.h"
+#include "palette-format.h"
+#include "tileset.h"
+#include "tile-packer.h"
+
+#define DEFAULT_COLOR_ZERO 0xFFFFFF00 // white
+
+struct Image_to_Tiles_Options {
+	std::string image_filename, tileset_filename, tilemap_filename, attrmap_filename, palette_filename, tilepal_filename;
+	Tilemap_Format fmt = Tilemap_Format::PLAIN;
+	bool make_palette = false;
+	Palette_Format pal_fmt = Palette_Format::INDEXED;
+	bool use_color_zero = false;
+	Fl_Color color_zero = DEFAULT_COLOR_ZERO;
+	uint8_t start_index = 0;
+	bool allow_unique = true, allow_flip = true;
+	uint16_t start_id = 0x000;
+	bool use_blank = false;
+	uint16_t blank_id = 0x000;
+	int tileset_width = DEFAULT_TILES_PER_ROW;
+	bool no_extra_blank_tiles = false;
+	// A makefile rule for the outputs is written here, if given
+	std::string depfile_filename;
+	// Names the tilemap, attrmap, palette, and tilepal files after the tileset
+	void output_filenames(const char *tileset_f);
+};
+
+// Parses up to six hex digits of RRGGBB, rounded to 5 bits per channel like image colors
+Fl_Color color_zero_from_hex(const char *s);
+
+// Converts an image to tileset, tilemap, and palette files without opening any windows.
+// Sets message to describe the result, and width to the tilemap width on success.
+// Palettes are looked up in palette_cache, if given, before making new ones.
+bool image_to_tiles(const Image_to_Tiles_Options &opts, size_t &width, std::string &message,
+	Palette_Cache *palette_cache = NULL);
+
+#endif
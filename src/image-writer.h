@@ -0,0 +1,28 @@
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include "core.h"
+
+#define INCHES_PER_METER 39.3701
+
+#define NUM_CHANNELS 3
+
+// Images written without a display have no screen resolution to record
+#define DEFAULT_DPI 96.0f
+
+enum class Image_Result { IMAGE_OK, IMAGE_BAD_FILE, IMAGE_BAD_PALETTE, IMAGE_BAD_PNG };
+
+// Fills rows y to y+rows-1 of an RGB image, for images written a band at a time
+typedef void (*Image_Band_Cb)(size_t y, size_t rows, uchar *rgb, void *data);
+
+// Writes w x h pixels of d bytes each, with rows ld bytes apart (or w * d if ld is 0), as a PNG or BMP file.
+// With palettes or a bpp, the first byte of each pixel is an index (or a grayscale level for bpp).
+Image_Result write_image(const char *f, const uchar *pixels, size_t w, size_t h, int d, int ld, int bpp,
+	const Palettes *palettes, size_t max_colors, float dpi = DEFAULT_DPI);
+Image_Result write_image(const char *f, size_t w, size_t h, size_t band_rows, Image_Band_Cb cb, void *data);
+const char *image_error_message(Image_Result result);
+
+// Color i of nc evenly spaced grays, from white to black
+Fl_Color indexed_grayscale(size_t i, size_t nc);
+
+#endif
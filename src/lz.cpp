@@ -0,0 +1,568 @@
+#include <cstring>
+#include <array>
+#include <vector>
+
+#include "lz.h"
+
+// Copy len bytes from dist bytes back in the output. When the source overlaps the destination,
+// the data is periodic with period dist, so each block copy can double the length copied so far.
+static inline void copy_match(uchar *out, size_t dist, size_t len) {
+	const uchar *src = out - dist;
+	if (dist >= len) {
+		memcpy(out, src, len);
+		return;
+	}
+	if (dist == 1) {
+		memset(out, *src, len);
+		return;
+	}
+	for (size_t n = dist; len > 0;) {
+		size_t k = std::min(n, len);
+		memcpy(out, src, k);
+		out += k;
+		len -= k;
+		n += k;
+	}
+}
+
+Lz::Result Lz::decompress_gba(const std::vector<uchar> &lz_data, std::vector<uchar> &data) {
+	// <https://problemkaputt.de/gbatek.htm#biosdecompressionfunctions>
+	if (lz_data.size() < GBA_LZ77_HEADER_SIZE || lz_data[0] != GBA_LZ77_TYPE) { return Result::LZ_BAD_HEADER; }
+	size_t n = (size_t)lz_data[1] | (size_t)lz_data[2] << 8 | (size_t)lz_data[3] << 16;
+	data.resize(n);
+
+	const uchar *src = lz_data.data() + GBA_LZ77_HEADER_SIZE, *src_end = lz_data.data() + lz_data.size();
+	uchar *out = data.data();
+	size_t pos = 0;
+	while (pos < n) {
+		if (src == src_end) { return Result::LZ_TRUNCATED; }
+		uchar flags = *src++;
+		for (int i = 0; i < 8 && pos < n; i++, flags <<= 1) {
+			if (!(flags & 0x80)) {
+				// Literal byte
+				if (src == src_end) { return Result::LZ_TRUNCATED; }
+				out[pos++] = *src++;
+				continue;
+			}
+			// Back-reference: %LLLL_DDDD %DDDD_DDDD for length L+3 and distance D+1
+			if (src_end - src < 2) { return Result::LZ_TRUNCATED; }
+			size_t len = (size_t)(src[0] >> 4) + GBA_LZ77_MIN_LENGTH;
+			size_t dist = ((size_t)(src[0] & 0x0F) << 8 | src[1]) + 1;
+			src += 2;
+			if (dist > pos) { return Result::LZ_BAD_OFFSET; }
+			// The BIOS stops as soon as the declared size is reached
+			len = std::min(len, n - pos);
+			copy_match(out + pos, dist, len);
+			pos += len;
+		}
+	}
+
+	return Result::LZ_OK;
+}
+
+#define GBA_LZ77_HASH_BITS 14
+#define GBA_LZ77_MAX_CHAIN 1024
+
+// Hash chains over 3-byte prefixes, limited to the 4 KB sliding window
+class Gba_Match_Finder {
+private:
+	const std::vector<uchar> &_data;
+	std::vector<int> _head, _prev;
+public:
+	Gba_Match_Finder(const std::vector<uchar> &data) : _data(data), _head(1 << GBA_LZ77_HASH_BITS, -1),
+		_prev(GBA_LZ77_MAX_DISTANCE, -1) {}
+	void insert(size_t pos);
+	size_t find(size_t pos, size_t &dist) const;
+private:
+	inline size_t hash(size_t pos) const {
+		uint32_t v = (uint32_t)_data[pos] << 16 | (uint32_t)_data[pos + 1] << 8 | (uint32_t)_data[pos + 2];
+		return (size_t)((v * 2654435761U) >> (32 - GBA_LZ77_HASH_BITS));
+	}
+};
+
+void Gba_Match_Finder::insert(size_t pos) {
+	if (pos + GBA_LZ77_MIN_LENGTH > _data.size()) { return; }
+	size_t h = hash(pos);
+	_prev[pos % GBA_LZ77_MAX_DISTANCE] = _head[h];
+	_head[h] = (int)pos;
+}
+
+size_t Gba_Match_Finder::find(size_t pos, size_t &dist) const {
+	size_t n = _data.size();
+	if (pos + GBA_LZ77_MIN_LENGTH > n) { return 0; }
+	size_t max_len = std::min((size_t)GBA_LZ77_MAX_LENGTH, n - pos);
+	const uchar *p = _data.data() + pos;
+	size_t best = 0;
+	int depth = 0;
+	// A chain link is only overwritten once its position falls out of the window, so it stays valid here
+	for (int c = _head[hash(pos)]; c >= 0 && depth < GBA_LZ77_MAX_CHAIN; c = _prev[c % GBA_LZ77_MAX_DISTANCE], depth++) {
+		size_t d = pos - (size_t)c;
+		if (d > GBA_LZ77_MAX_DISTANCE) { break; }
+		if (d < GBA_LZ77_MIN_DISTANCE) { continue; }
+		const uchar *q = _data.data() + c;
+		if (q[best] != p[best]) { continue; }
+		size_t len = 0;
+		while (len < max_len && q[len] == p[len]) { len++; }
+		if (len > best) {
+			best = len;
+			dist = d;
+			if (best == max_len) { break; }
+		}
+	}
+	return best >= GBA_LZ77_MIN_LENGTH ? best : 0;
+}
+
+Lz::Result Lz::compress_gba(const std::vector<uchar> &data, std::vector<uchar> &lz_data) {
+	size_t n = data.size();
+	lz_data.clear();
+	// The size would not fit in the header
+	if (n > GBA_LZ77_MAX_SIZE) { return Result::LZ_TOO_LARGE; }
+	lz_data.reserve(GBA_LZ77_HEADER_SIZE + n + (n + 7) / 8 + 3);
+	lz_data.push_back(GBA_LZ77_TYPE);
+	lz_data.push_back((uchar)(n & 0xFF));
+	lz_data.push_back((uchar)((n >> 8) & 0xFF));
+	lz_data.push_back((uchar)((n >> 16) & 0xFF));
+
+	Gba_Match_Finder finder(data);
+	size_t flags_pos = 0;
+	int flag_bit = 0;
+	size_t dist = 0, len = finder.find(0, dist);
+	for (size_t pos = 0; pos < n;) {
+		if (flag_bit == 0) {
+			flags_pos = lz_data.size();
+			lz_data.push_back(0);
+			flag_bit = 8;
+		}
+		flag_bit--;
+		finder.insert(pos);
+		// Lazy matching: prefer a literal if the next position starts a longer match
+		size_t next_dist = 0, next_len = 0;
+		if (len < GBA_LZ77_MAX_LENGTH && pos + 1 < n) {
+			next_len = finder.find(pos + 1, next_dist);
+		}
+		if (len && next_len <= len) {
+			lz_data[flags_pos] |= (uchar)(1 << flag_bit);
+			size_t code_len = len - GBA_LZ77_MIN_LENGTH, code_dist = dist - 1;
+			lz_data.push_back((uchar)(code_len << 4 | code_dist >> 8));
+			lz_data.push_back((uchar)(code_dist & 0xFF));
+			for (size_t i = pos + 1; i < pos + len; i++) {
+				finder.insert(i);
+			}
+			pos += len;
+			len = finder.find(pos, dist);
+		}
+		else {
+			lz_data.push_back(data[pos++]);
+			len = next_len;
+			dist = next_dist;
+		}
+	}
+
+	// Pad to a word boundary, like gbagfx and grit
+	while (lz_data.size() % 4) {
+		lz_data.push_back(0);
+	}
+	return Result::LZ_OK;
+}
+
+// A rundown of Pokemon Crystal's LZ compression scheme:
+enum class Lz_Command {
+	// Control commands occupy bits 5-7.
+	// Bits 0-4 serve as the first parameter n for each command.
+	LZ_LITERAL,   // n values for n bytes
+	LZ_ITERATE,   // one value for n bytes
+	LZ_ALTERNATE, // alternate two values for n bytes
+	LZ_BLANK,     // zero for n bytes
+	// Repeater commands repeat any data that was just decompressed.
+	// They take an additional signed parameter s to mark a relative starting point.
+	// These wrap around (positive from the start, negative from the current position).
+	LZ_REPEAT,    // n bytes starting from s
+	LZ_FLIP,      // n bytes in reverse bit order starting from s
+	LZ_REVERSE,   // n bytes backwards starting from s
+	// The long command is used when 5 bits aren't enough. Bits 2-4 contain a new control code.
+	// Bits 0-1 are appended to a new byte as 8-9, allowing a 10-bit parameter.
+	LZ_LONG       // n is now 10 bits for a new control code
+};
+
+// If 0xff is encountered instead of a command, decompression ends.
+#define LZ_END 0xff
+
+static auto bit_flipped = ([]() constexpr {
+	std::array<uchar, 256> a{};
+	for (size_t i = 0; i < a.size(); i++) {
+		for (size_t b = 0; b < 8; b++) {
+			a[i] += ((i >> b) & 1) << (7 - b);
+		}
+	}
+	return a;
+})();
+
+Lz::Result Lz::decompress_crystal(const std::vector<uchar> &lz_data, std::vector<uchar> &data) {
+	const uchar *src = lz_data.data(), *src_end = lz_data.data() + lz_data.size();
+	data.clear();
+	size_t pos = 0;
+	for (;;) {
+		if (src == src_end) { return Result::LZ_TRUNCATED; }
+		uchar b = *src++;
+		if (b == LZ_END) { break; }
+		Lz_Command cmd = (Lz_Command)((b & 0xe0) >> 5);
+		size_t length;
+		if (cmd == Lz_Command::LZ_LONG) {
+			if (src == src_end) { return Result::LZ_TRUNCATED; }
+			cmd = (Lz_Command)((b & 0x1c) >> 2);
+			length = ((size_t)(b & 0x03) << 8 | *src++) + 1;
+		}
+		else {
+			length = (size_t)(b & 0x1f) + 1;
+		}
+		if (cmd == Lz_Command::LZ_LONG) { return Result::LZ_BAD_CMD; }
+
+		// Parameters are validated before the output grows
+		size_t need = cmd == Lz_Command::LZ_LITERAL ? length : cmd == Lz_Command::LZ_ITERATE ? 1 :
+			cmd == Lz_Command::LZ_ALTERNATE ? 2 : cmd == Lz_Command::LZ_BLANK ? 0 : 1;
+		if ((size_t)(src_end - src) < need) { return Result::LZ_TRUNCATED; }
+		size_t offset = 0;
+		if (cmd >= Lz_Command::LZ_REPEAT && cmd <= Lz_Command::LZ_REVERSE) {
+			uchar s = *src++;
+			if (s >= 0x80) {
+				size_t back = (size_t)(s & 0x7f) + 1;
+				if (back > pos) { return Result::LZ_BAD_OFFSET; }
+				offset = pos - back;
+			}
+			else {
+				if (src == src_end) { return Result::LZ_TRUNCATED; }
+				offset = (size_t)s << 8 | *src++;
+			}
+			if (offset >= pos) { return Result::LZ_BAD_OFFSET; }
+			if (cmd == Lz_Command::LZ_REVERSE && offset + 1 < length) { return Result::LZ_BAD_OFFSET; }
+		}
+		if (length > CRYSTAL_LZ_MAX_SIZE - pos) { return Result::LZ_TOO_LARGE; }
+
+		data.resize(pos + length);
+		uchar *out = data.data() + pos;
+		const uchar *in = data.data() + offset;
+		switch (cmd) {
+		case Lz_Command::LZ_LITERAL:
+			// Copy data directly.
+			memcpy(out, src, length);
+			src += length;
+			break;
+		case Lz_Command::LZ_ITERATE:
+			// Write one byte repeatedly.
+			memset(out, *src++, length);
+			break;
+		case Lz_Command::LZ_ALTERNATE:
+			// Write alternating bytes.
+			for (size_t i = 0; i < length; i++) {
+				out[i] = src[i & 1];
+			}
+			src += 2;
+			break;
+		case Lz_Command::LZ_BLANK:
+			// Write zeros.
+			memset(out, 0, length);
+			break;
+		case Lz_Command::LZ_REPEAT:
+			// Repeat bytes from output.
+			copy_match(out, pos - offset, length);
+			break;
+		case Lz_Command::LZ_FLIP:
+			// Repeat flipped bytes from output.
+			// An overlapping run reads back bytes it has just flipped, so it stays byte by byte.
+			for (size_t i = 0; i < length; i++) {
+				out[i] = bit_flipped[in[i]];
+			}
+			break;
+		case Lz_Command::LZ_REVERSE:
+			// Repeat reversed bytes from output.
+			for (size_t i = 0; i < length; i++) {
+				out[i] = *(in - i);
+			}
+			break;
+		case Lz_Command::LZ_LONG:
+		default:
+			return Result::LZ_BAD_CMD;
+		}
+		pos += length;
+	}
+
+	return Result::LZ_OK;
+}
+
+#define CRYSTAL_LZ_HASH_BITS 14
+#define CRYSTAL_LZ_MAX_CHAIN 256
+
+struct Crystal_Match {
+	Lz_Command cmd = Lz_Command::LZ_LITERAL;
+	size_t length = 0, offset = 0;
+	int gain = 0; // bytes saved compared to literal data
+};
+
+static inline size_t crystal_header_size(size_t length) {
+	return length > 0x20 ? 2 : 1;
+}
+
+static inline size_t crystal_offset_size(size_t pos, size_t offset) {
+	return pos - offset <= CRYSTAL_LZ_MAX_BACK ? 1 : offset < CRYSTAL_LZ_MAX_OFFSET ? 2 : 0;
+}
+
+// Hash chains over 3-byte prefixes of the data as-is (for repeats), bit-flipped (for flips),
+// and read backwards (for reversals)
+class Crystal_Match_Finder {
+private:
+	enum { REPEAT, FLIP, REVERSE, NUM_CHAINS };
+	const std::vector<uchar> &_data;
+	std::vector<int> _head[NUM_CHAINS], _prev[NUM_CHAINS];
+public:
+	Crystal_Match_Finder(const std::vector<uchar> &data);
+	void insert(size_t pos);
+	Crystal_Match find(size_t pos) const;
+private:
+	static inline size_t hash(uchar a, uchar b, uchar c) {
+		uint32_t v = (uint32_t)a << 16 | (uint32_t)b << 8 | (uint32_t)c;
+		return (size_t)((v * 2654435761U) >> (32 - CRYSTAL_LZ_HASH_BITS));
+	}
+	inline void link(int chain, size_t h, size_t pos) {
+		_prev[chain][pos] = _head[chain][h];
+		_head[chain][h] = (int)pos;
+	}
+	void consider(Crystal_Match &best, Lz_Command cmd, size_t pos, size_t offset, size_t length) const;
+};
+
+Crystal_Match_Finder::Crystal_Match_Finder(const std::vector<uchar> &data) : _data(data) {
+	for (int i = 0; i < NUM_CHAINS; i++) {
+		_head[i].assign(1 << CRYSTAL_LZ_HASH_BITS, -1);
+		_prev[i].assign(data.size(), -1);
+	}
+}
+
+void Crystal_Match_Finder::insert(size_t pos) {
+	const uchar *d = _data.data();
+	if (pos + 2 < _data.size()) {
+		link(REPEAT, hash(d[pos], d[pos+1], d[pos+2]), pos);
+		link(FLIP, hash(bit_flipped[d[pos]], bit_flipped[d[pos+1]], bit_flipped[d[pos+2]]), pos);
+	}
+	if (pos >= 2) {
+		link(REVERSE, hash(d[pos], d[pos-1], d[pos-2]), pos);
+	}
+}
+
+void Crystal_Match_Finder::consider(Crystal_Match &best, Lz_Command cmd, size_t pos, size_t offset, size_t length) const {
+	size_t params = crystal_offset_size(pos, offset);
+	if (!params) { return; }
+	int gain = (int)length - (int)(crystal_header_size(length) + params);
+	if (gain > best.gain) {
+		best.cmd = cmd;
+		best.length = length;
+		best.offset = offset;
+		best.gain = gain;
+	}
+}
+
+Crystal_Match Crystal_Match_Finder::find(size_t pos) const {
+	Crystal_Match best;
+	size_t n = _data.size();
+	const uchar *d = _data.data(), *p = d + pos;
+	size_t max_len = std::min((size_t)CRYSTAL_LZ_MAX_LENGTH, n - pos);
+
+	// Runs of one byte, or of zeros
+	size_t run = 1;
+	while (run < max_len && p[run] == p[0]) { run++; }
+	int gain = (int)run - (int)crystal_header_size(run) - (p[0] ? 1 : 0);
+	if (gain > best.gain) {
+		best.cmd = p[0] ? Lz_Command::LZ_ITERATE : Lz_Command::LZ_BLANK;
+		best.length = run;
+		best.gain = gain;
+	}
+
+	// Runs of two alternating bytes
+	if (max_len > 2 && p[1] != p[0]) {
+		size_t alt = 2;
+		while (alt < max_len && p[alt] == p[alt & 1]) { alt++; }
+		gain = (int)alt - (int)crystal_header_size(alt) - 2;
+		if (gain > best.gain) {
+			best.cmd = Lz_Command::LZ_ALTERNATE;
+			best.length = alt;
+			best.gain = gain;
+		}
+	}
+
+	if (max_len < 3) { return best; }
+	size_t h = hash(p[0], p[1], p[2]);
+
+	int depth = 0;
+	for (int c = _head[REPEAT][h]; c >= 0 && depth < CRYSTAL_LZ_MAX_CHAIN; c = _prev[REPEAT][c], depth++) {
+		const uchar *q = d + c;
+		size_t len = 0;
+		while (len < max_len && q[len] == p[len]) { len++; }
+		consider(best, Lz_Command::LZ_REPEAT, pos, (size_t)c, len);
+		if (len == max_len) { break; }
+	}
+
+	depth = 0;
+	for (int c = _head[FLIP][h]; c >= 0 && depth < CRYSTAL_LZ_MAX_CHAIN; c = _prev[FLIP][c], depth++) {
+		const uchar *q = d + c;
+		size_t len = 0;
+		while (len < max_len && bit_flipped[q[len]] == p[len]) { len++; }
+		consider(best, Lz_Command::LZ_FLIP, pos, (size_t)c, len);
+		if (len == max_len) { break; }
+	}
+
+	depth = 0;
+	for (int c = _head[REVERSE][h]; c >= 0 && depth < CRYSTAL_LZ_MAX_CHAIN; c = _prev[REVERSE][c], depth++) {
+		const uchar *q = d + c;
+		size_t len = 0, lim = std::min(max_len, (size_t)c + 1);
+		while (len < lim && *(q - len) == p[len]) { len++; }
+		consider(best, Lz_Command::LZ_REVERSE, pos, (size_t)c, len);
+		if (len == max_len) { break; }
+	}
+
+	return best;
+}
+
+static void put_crystal_command(std::vector<uchar> &lz_data, Lz_Command cmd, size_t length) {
+	size_t n = length - 1;
+	if (length > 0x20) {
+		lz_data.push_back((uchar)(0xe0 | (int)cmd << 2 | n >> 8));
+		lz_data.push_back((uchar)(n & 0xff));
+	}
+	else {
+		lz_data.push_back((uchar)((int)cmd << 5 | n));
+	}
+}
+
+static void put_crystal_literal(std::vector<uchar> &lz_data, const uchar *src, size_t length) {
+	while (length > 0) {
+		size_t k = std::min(length, (size_t)CRYSTAL_LZ_MAX_LENGTH);
+		put_crystal_command(lz_data, Lz_Command::LZ_LITERAL, k);
+		lz_data.insert(lz_data.end(), src, src + k);
+		src += k;
+		length -= k;
+	}
+}
+
+Lz::Result Lz::compress_crystal(const std::vector<uchar> &data, std::vector<uchar> &lz_data) {
+	size_t n = data.size();
+	lz_data.clear();
+	// decompress_crystal refuses to produce more than this
+	if (n > CRYSTAL_LZ_MAX_SIZE) { return Result::LZ_TOO_LARGE; }
+	lz_data.reserve(n + n / CRYSTAL_LZ_MAX_LENGTH * 2 + 3);
+
+	Crystal_Match_Finder finder(data);
+	size_t literal = 0; // start of the pending literal run
+	Crystal_Match m = n ? finder.find(0) : Crystal_Match();
+	for (size_t pos = 0; pos < n;) {
+		finder.insert(pos);
+		// Lazy matching: prefer a literal if the next position saves more
+		Crystal_Match next;
+		bool has_next = false;
+		if (m.gain > 0 && m.length < CRYSTAL_LZ_MAX_LENGTH && pos + 1 < n) {
+			next = finder.find(pos + 1);
+			has_next = true;
+		}
+		if (m.gain > 0 && next.gain <= m.gain) {
+			put_crystal_literal(lz_data, data.data() + literal, pos - literal);
+			put_crystal_command(lz_data, m.cmd, m.length);
+			switch (m.cmd) {
+			case Lz_Command::LZ_ITERATE:
+				lz_data.push_back(data[pos]);
+				break;
+			case Lz_Command::LZ_ALTERNATE:
+				lz_data.push_back(data[pos]);
+				lz_data.push_back(data[pos + 1]);
+				break;
+			case Lz_Command::LZ_REPEAT:
+			case Lz_Command::LZ_FLIP:
+			case Lz_Command::LZ_REVERSE:
+				if (pos - m.offset <= CRYSTAL_LZ_MAX_BACK) {
+					lz_data.push_back((uchar)(0x80 | (pos - m.offset - 1)));
+				}
+				else {
+					lz_data.push_back((uchar)(m.offset >> 8));
+					lz_data.push_back((uchar)(m.offset & 0xff));
+				}
+				break;
+			default:
+				break;
+			}
+			for (size_t i = pos + 1; i < pos + m.length; i++) {
+				finder.insert(i);
+			}
+			pos += m.length;
+			literal = pos;
+			m = pos < n ? finder.find(pos) : Crystal_Match();
+		}
+		else {
+			pos++;
+			m = has_next ? next : pos < n ? finder.find(pos) : Crystal_Match();
+		}
+	}
+	put_crystal_literal(lz_data, data.data() + literal, n - literal);
+	lz_data.push_back(LZ_END);
+	return Result::LZ_OK;
+}
+
+Lz_Profile Lz::profile_gba(const std::vector<uchar> &lz_data) {
+	Lz_Profile profile;
+	if (lz_data.size() < GBA_LZ77_HEADER_SIZE || lz_data[0] != GBA_LZ77_TYPE) { return profile; }
+	size_t n = (size_t)lz_data[1] | (size_t)lz_data[2] << 8 | (size_t)lz_data[3] << 16;
+	size_t i = GBA_LZ77_HEADER_SIZE, m = lz_data.size(), pos = 0;
+	while (pos < n && i < m) {
+		uchar flags = lz_data[i++];
+		for (int b = 0; b < 8 && pos < n && i < m; b++, flags <<= 1) {
+			if (!(flags & 0x80)) {
+				profile.literal_bytes++;
+				pos++;
+				i++;
+				continue;
+			}
+			if (i + 1 >= m) { return profile; }
+			size_t len = std::min((size_t)(lz_data[i] >> 4) + GBA_LZ77_MIN_LENGTH, n - pos);
+			profile.commands++;
+			profile.copy_bytes += len;
+			pos += len;
+			i += 2;
+		}
+	}
+	return profile;
+}
+
+Lz_Profile Lz::profile_crystal(const std::vector<uchar> &lz_data) {
+	Lz_Profile profile;
+	for (size_t i = 0, m = lz_data.size(); i < m;) {
+		uchar b = lz_data[i++];
+		if (b == LZ_END) { break; }
+		Lz_Command cmd = (Lz_Command)((b & 0xe0) >> 5);
+		size_t length;
+		if (cmd == Lz_Command::LZ_LONG) {
+			if (i >= m) { break; }
+			cmd = (Lz_Command)((b & 0x1c) >> 2);
+			length = ((size_t)(b & 0x03) << 8 | lz_data[i++]) + 1;
+		}
+		else {
+			length = (size_t)(b & 0x1f) + 1;
+		}
+		profile.commands++;
+		switch (cmd) {
+		case Lz_Command::LZ_LITERAL:
+			profile.literal_bytes += length;
+			i += length;
+			break;
+		case Lz_Command::LZ_ITERATE:
+		case Lz_Command::LZ_ALTERNATE:
+		case Lz_Command::LZ_BLANK:
+			profile.fill_bytes += length;
+			i += cmd == Lz_Command::LZ_ITERATE ? 1 : cmd == Lz_Command::LZ_ALTERNATE ? 2 : 0;
+			break;
+		case Lz_Command::LZ_REPEAT:
+		case Lz_Command::LZ_FLIP:
+		case Lz_Command::LZ_REVERSE:
+			(cmd == Lz_Command::LZ_REPEAT ? profile.copy_bytes : profile.transform_bytes) += length;
+			i += i < m && lz_data[i] >= 0x80 ? 1 : 2;
+			break;
+		default:
+			return profile;
+		}
+	}
+	return profile;
+}
@@ -0,0 +1,40 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <vector>
+
+#include "core.h"
+
+// GBA BIOS LZ77 ("LZ77UnCompWram"/"LZ77UnCompVram", SWI 0x11/0x12)
+#define GBA_LZ77_TYPE 0x10
+#define GBA_LZ77_HEADER_SIZE 4
+#define GBA_LZ77_MAX_SIZE 0xFFFFFF // the header's 24-bit size
+#define GBA_LZ77_MIN_LENGTH 3
+#define GBA_LZ77_MAX_LENGTH 18
+#define GBA_LZ77_MIN_DISTANCE 2 // a distance of 1 is not safe to decompress to VRAM
+#define GBA_LZ77_MAX_DISTANCE 0x1000
+
+// Pokemon Crystal LZ has no size header, so cap the output of corrupt or hostile data
+#define CRYSTAL_LZ_MAX_SIZE 0x1000000
+#define CRYSTAL_LZ_MAX_LENGTH 0x400 // 10-bit parameter of a long command
+#define CRYSTAL_LZ_MAX_BACK 0x80 // longer distances take a 15-bit absolute offset
+#define CRYSTAL_LZ_MAX_OFFSET 0x8000
+
+// How much output each kind of command produces, for estimating decompression cost
+struct Lz_Profile {
+	size_t commands = 0, literal_bytes = 0, fill_bytes = 0, copy_bytes = 0, transform_bytes = 0;
+};
+
+class Lz {
+public:
+	enum class Result { LZ_OK, LZ_BAD_HEADER, LZ_TRUNCATED, LZ_BAD_OFFSET, LZ_BAD_CMD, LZ_TOO_LARGE };
+	static Result decompress_gba(const std::vector<uchar> &lz_data, std::vector<uchar> &data);
+	// Returns LZ_TOO_LARGE, leaving lz_data empty, for data too large to decompress again
+	static Result compress_gba(const std::vector<uchar> &data, std::vector<uchar> &lz_data);
+	static Result decompress_crystal(const std::vector<uchar> &lz_data, std::vector<uchar> &data);
+	static Result compress_crystal(const std::vector<uchar> &data, std::vector<uchar> &lz_data);
+	static Lz_Profile profile_gba(const std::vector<uchar> &lz_data);
+	static Lz_Profile profile_crystal(const std::vector<uchar> &lz_data);
+};
+
+#endif
@@ -1,6 +1,6 @@
+#include <algorithm>
 #include <cstdlib>
 #include <cwctype>
-#include <queue>
 #include <utility>
 
 #pragma warning(push, 0)
@@ -11,7 +11,6 @@
 #include <FL/Fl_Toggle_Button.H>
 #include <FL/Fl_Multi_Label.H>
 #include <FL/Fl_Copy_Surface.H>
-#include <FL/Fl_Image_Surface.H>
 #pragma warning(pop)
 
 #include "version.h"
@@ -26,6 +25,7 @@
 #include "tilemap.h"
 #include "tileset.h"
 #include "tile.h"
+#include "draw-stats.h"
 #include "main-window.h"
 #include "icons.h"
 
@@ -38,10 +38,11 @@
 #endif
 
 Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_Window(x, y, w, h, PROGRAM_NAME),
-	_tile_buttons(), _tilemap_file(), _attrmap_file(), _tilemap_basename(), _tileset_files(), _recent_tilemaps(),
-	_recent_tilesets(), _tilemap(), _tilesets(), _wx(x), _wy(y), _ww(w), _wh(h) {
+	_tile_picker(), _tilemap_file(), _attrmap_file(), _tilemap_basename(), _tileset_files(), _recent_tilemaps(),
+	_recent_tilesets(), _tilemap(), _tilesets(), _file_watcher((File_Watcher::Changed_Cb)files_changed_cb, this),
+	_wx(x), _wy(y), _ww(w), _wh(h) {
 
-	Tile_State::tilesets(&_tilesets);
+	Config::tilesets(&_tilesets);
 
 	// Get global configs
 	Tilemap_Format format_config = (Tilemap_Format)Preferences::get("format", (int)Config::format());
@@ -50,12 +51,16 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 	int rainbow_tiles_config = Preferences::get("rainbow", Config::rainbow_tiles());
 	int bold_palettes_config = Preferences::get("bold", Config::bold_palettes());
 	int auto_tileset_config = Preferences::get("tileset", Config::auto_load_tileset());
+	int auto_reload_config = Preferences::get("reload", Config::auto_reload());
+	int find_flipped_config = Preferences::get("find-flipped", Config::find_flipped());
 	Config::format(format_config);
 	Config::zoom(zoom_config);
 	Config::grid(!!grid_config);
 	Config::rainbow_tiles(!!rainbow_tiles_config);
 	Config::bold_palettes(!!bold_palettes_config);
 	Config::auto_load_tileset(!!auto_tileset_config);
+	Config::auto_reload(!!auto_reload_config);
+	Config::find_flipped(!!find_flipped_config);
 
 	for (int i = 0; i < NUM_RECENT; i++) {
 		_recent_tilemaps[i] = Preferences::get_string(Fl_Preferences::Name("recent-map%d", i));
@@ -122,11 +127,13 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 	new Spacer(0, 0, 2, 21);
 	_tilemap_format = new Label(0, 0, format_max_name_width() + 4, 21, "");
 	new Spacer(0, 0, 2, 21);
-	_hover_id = new Label(0, 0, text_width("ID: $A:AA", 4), 21, "");
+	_hover_id = new Label(0, 0, text_width("ID: $A:AA (99999x)", 4), 21, "");
 	new Spacer(0, 0, 2, 21);
 	_hover_xy = new Label(0, 0, text_width("X/Y (9999, 9999)", 4), 21, "");
 	new Spacer(0, 0, 2, 21);
 	_hover_landmark = new Label(0, 0, text_width("Landmark (199, 199)", 4), 21, "");
+	new Spacer(0, 0, 2, 21);
+	_found_count = new Label(0, 0, text_width("Found: 99999", 4), 21, "");
 	_status_bar->end();
 	begin();
 
@@ -147,14 +154,8 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 	_tiles_scroll = new Workspace(gx+5, qy+5, gw-10, gh-10);
 	int ox = _tiles_scroll->x() + Fl::box_dx(_tiles_scroll->box());
 	int oy = _tiles_scroll->y() + Fl::box_dy(_tiles_scroll->box());
-	int tw = tileset_width();
-	for (int i = 0; i < MAX_NUM_TILES; i++) {
-		int col = i % tw, row = i / tw;
-		int tx = ox + col * TILE_SIZE_2X, ty = oy + row * TILE_SIZE_2X;
-		Tile_Button *tb = new Tile_Button(tx, ty, row, col, (uint16_t)i);
-		tb->callback((Fl_Callback *)select_tile_cb, this);
-		_tile_buttons[i] = tb;
-	}
+	_tile_picker = new Tile_Picker(ox, oy, tileset_width(), format_tileset_size(Config::format()));
+	_tile_picker->callback((Fl_Callback *)select_tile_cb, this);
 	_tiles_scroll->end();
 	_tiles_scroll->type(Fl_Scroll::VERTICAL_ALWAYS);
 	_tiles_scroll->resizable(NULL);
@@ -208,7 +209,7 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 	gx = _right_group->x(); gy = _right_group->y(); gw = _right_group->w();
 	_tilemap_name = new Label(gx, gy, gw, wgt_h);
 	wy += _tilemap_name->h() + wgt_m; wh -= _tilemap_name->h() + wgt_m;
-	_tilemap_scroll = new Workspace(wx, wy, ww, wh);
+	_tilemap_scroll = new Tilemap_Workspace(wx, wy, ww, wh, &_tilemap);
 	_tilemap_scroll->end();
 	_tilemap_scroll->resizable(NULL);
 	_right_group->resizable(_tilemap_scroll);
@@ -239,6 +240,8 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 	_add_tileset_dialog = new Add_Tileset_Dialog("Add Tileset");
 	_image_to_tiles_dialog = new Image_To_Tiles_Dialog("Image to Tiles");
 	_help_window = new Help_Window(48, 48, 700, 500, PROGRAM_NAME " Help");
+	_advisor_window = new Advisor_Window(48, 48, 600, 360, "Compression Advisor");
+	_minimap_window = new Minimap_Window(24, 48, 256, 256, "Minimap");
 
 	// Drag-and-drop receivers
 	_tilemap_dnd_receiver = new DnD_Receiver(0, 0, 0, 0);
@@ -266,6 +269,8 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 
 	// Configure workspaces
 	_tilemap_scroll->dnd_receiver(_tilemap_dnd_receiver);
+	_tilemap_scroll->callback((Fl_Callback *)tilemap_view_cb, this);
+	_minimap_window->navigate_callback((Fl_Callback *)minimap_navigate_cb, this);
 	_tiles_scroll->dnd_receiver(_tileset_dnd_receiver);
 	_palettes_pane->dnd_receiver(_tileset_dnd_receiver);
 
@@ -322,6 +327,8 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 		OS_MENU_ITEM("&Unload", FL_COMMAND + 'W', (Fl_Callback *)unload_tilesets_cb, this, FL_MENU_DIVIDER),
 		OS_MENU_ITEM("Au&to-Load Tileset", 0, (Fl_Callback *)auto_load_tileset_cb, this,
 			FL_MENU_TOGGLE | (Config::auto_load_tileset() ? FL_MENU_VALUE : 0)),
+		OS_MENU_ITEM("Reload &Changed Files", 0, (Fl_Callback *)auto_reload_cb, this,
+			FL_MENU_TOGGLE | (Config::auto_reload() ? FL_MENU_VALUE : 0)),
 		{},
 		OS_SUBMENU("&Edit"),
 		OS_MENU_ITEM("&Undo", FL_COMMAND + 'z', (Fl_Callback *)undo_cb, this, 0),
@@ -331,7 +338,11 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 		OS_MENU_ITEM("&Y Flip Selection", FL_COMMAND + 'Y', (Fl_Callback *)y_flip_selection_cb, this, 0),
 		OS_MENU_ITEM("Shift Selected &IDs...", FL_COMMAND + 'J', (Fl_Callback *)shift_selected_ids_cb, this, 0),
 		OS_MENU_ITEM("&Copy Selection", FL_COMMAND + 'C', (Fl_Callback *)copy_selection_cb, this, 0),
-		OS_MENU_ITEM("&Select All", FL_COMMAND + 'a', (Fl_Callback *)select_all_cb, this, 0),
+		OS_MENU_ITEM("&Select All", FL_COMMAND + 'a', (Fl_Callback *)select_all_cb, this, FL_MENU_DIVIDER),
+		OS_MENU_ITEM("&Find Block", FL_COMMAND + 'F', (Fl_Callback *)find_block_cb, this, 0),
+		OS_MENU_ITEM("Re&place Found Blocks", FL_COMMAND + 'H', (Fl_Callback *)replace_found_blocks_cb, this, 0),
+		OS_MENU_ITEM("Find F&lipped Blocks", 0, (Fl_Callback *)find_flipped_blocks_cb, this,
+			FL_MENU_TOGGLE | (Config::find_flipped() ? FL_MENU_VALUE : 0)),
 		{},
 		OS_SUBMENU("&View"),
 		OS_MENU_ITEM("&Theme", 0, NULL, NULL, FL_SUBMENU | FL_MENU_DIVIDER),
@@ -372,7 +383,12 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 		OS_MENU_ITEM("Tr&ansparent", FL_F + 10, (Fl_Callback *)transparent_cb, this,
 			FL_MENU_TOGGLE | (transparent ? FL_MENU_VALUE : 0)),
 		OS_MENU_ITEM("Full &Screen", FL_F + 11, (Fl_Callback *)full_screen_cb, this,
-			FL_MENU_TOGGLE | (fullscreen ? FL_MENU_VALUE : 0)),
+			FL_MENU_TOGGLE | (fullscreen ? FL_MENU_VALUE : 0) | FL_MENU_DIVIDER),
+		OS_MENU_ITEM("&Minimap...", 0, (Fl_Callback *)minimap_cb, this, FL_MENU_DIVIDER),
+		OS_MENU_ITEM("&Frame Stats Overlay", 0, (Fl_Callback *)frame_stats_cb, this,
+			FL_MENU_TOGGLE | (Draw_Stats::overlay() ? FL_MENU_VALUE : 0)),
+		OS_MENU_ITEM("&Log Frame Stats", 0, (Fl_Callback *)log_frame_stats_cb, this,
+			FL_MENU_TOGGLE | (Draw_Stats::logging() ? FL_MENU_VALUE : 0)),
 		{},
 		OS_SUBMENU("&Tools"),
 		OS_MENU_ITEM("Tilemap &Width...", FL_COMMAND + 'd', (Fl_Callback *)tilemap_width_cb, this, 0),
@@ -384,7 +400,8 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 		OS_MENU_ITEM("Re&format...", FL_COMMAND + 'f', (Fl_Callback *)reformat_cb, this, FL_MENU_DIVIDER),
 		OS_MENU_ITEM("&Tileset Width...", FL_COMMAND + 'h', (Fl_Callback *)tileset_width_cb, this, 0),
 		OS_MENU_ITEM("Shift Ti&leset...", FL_COMMAND + 'k', (Fl_Callback *)shift_tileset_cb, this, FL_MENU_DIVIDER),
-		OS_MENU_ITEM("&Image to Tiles...", FL_COMMAND + 'x', (Fl_Callback *)image_to_tiles_cb, this, 0),
+		OS_MENU_ITEM("&Image to Tiles...", FL_COMMAND + 'x', (Fl_Callback *)image_to_tiles_cb, this, FL_MENU_DIVIDER),
+		OS_MENU_ITEM("Compression &Advisor...", 0, (Fl_Callback *)compression_advisor_cb, this, 0),
 		{},
 		OS_SUBMENU("&Help"),
 		OS_MENU_ITEM("&Help", FL_F + 1, (Fl_Callback *)help_cb, this, FL_MENU_DIVIDER),
@@ -435,6 +452,8 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 	_shift_selected_ids_mi = TS_FIND_MENU_ITEM_CB(shift_selected_ids_cb);
 	_copy_selection_mi = TS_FIND_MENU_ITEM_CB(copy_selection_cb);
 	_select_all_mi = TS_FIND_MENU_ITEM_CB(select_all_cb);
+	_find_block_mi = TS_FIND_MENU_ITEM_CB(find_block_cb);
+	_replace_found_blocks_mi = TS_FIND_MENU_ITEM_CB(replace_found_blocks_cb);
 	_zoom_in_mi = TS_FIND_MENU_ITEM_CB(zoom_in_cb);
 	_zoom_out_mi = TS_FIND_MENU_ITEM_CB(zoom_out_cb);
 	_shift_tileset_mi = TS_FIND_MENU_ITEM_CB(shift_tileset_cb);
@@ -617,7 +636,7 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 	_tilemap_export_chooser->options(Fl_Native_File_Chooser::Option::SAVEAS_CONFIRM);
 
 	_tileset_load_chooser->title("Open Tileset");
-	_tileset_load_chooser->filter("Tileset Files\t*.{png,gif,bmp,1bpp,2bpp,4bpp,8bpp,1bpp.lz,2bpp.lz,rgcn,ncgr,rmp,rts}\n");
+	_tileset_load_chooser->filter("Tileset Files\t*.{png,gif,bmp,1bpp,2bpp,4bpp,8bpp,1bpp.lz,2bpp.lz,4bpp.lz,8bpp.lz,rgcn,ncgr,rmp,rts}\n");
 
 	_image_print_chooser->title("Print Screenshot");
 	_image_print_chooser->filter("PNG Files\t*.png\nBMP Files\t*.bmp\n");
@@ -683,6 +702,8 @@ Main_Window::~Main_Window() {
 	delete _reformat_dialog;
 	delete _image_to_tiles_dialog;
 	delete _help_window;
+	delete _advisor_window;
+	delete _minimap_window;
 }
 
 void Main_Window::show() {
@@ -722,20 +743,78 @@ void Main_Window::apply_transparency() {
 #endif
 }
 
+void Main_Window::draw() {
+	// The clip region covers whatever was damaged since the last frame
+	int X, Y, W, H;
+	fl_clip_box(0, 0, w(), h(), X, Y, W, H);
+	Draw_Stats::begin_frame((size_t)W * (size_t)H);
+	Fl_Overlay_Window::draw();
+	Draw_Stats::end_frame();
+}
+
 void Main_Window::draw_overlay() {
 	if (!visible()) { return; }
-	if (!_selection.from_tileset() || !Config::show_attributes()) {
-		_selection.draw_selection_border_at();
+	int X, Y, W, H;
+	if (!_found_blocks.empty() && _tilemap.size()) {
+		Tile_Tessera *tt = _tilemap.tile(0);
+		int s = tt->w();
+		_tilemap_scroll->bbox(X, Y, W, H);
+		fl_push_clip(X, Y, W, H);
+		// Only look at the blocks starting in or just above the visible rows
+		size_t w = _tilemap.width(), bw = _found_width, bh = _found_height;
+		size_t first = (size_t)std::max((Y - tt->y()) / s - (int)bh + 1, 0);
+		size_t last = (size_t)std::max((Y + H - tt->y()) / s, 0);
+		auto it = std::lower_bound(RANGE(_found_blocks), first * w,
+			[](const Block_Match &m, size_t i) { return m.index < i; });
+		for (; it != _found_blocks.end() && it->index / w <= last; ++it) {
+			int bx = tt->x() + (int)(it->index % w) * s, by = tt->y() + (int)(it->index / w) * s;
+			if (bx >= X + W || bx + (int)bw * s <= X) { continue; }
+			draw_selection_border(bx, by, (int)bw * s, (int)bh * s, FL_YELLOW, Config::zoom() > 5);
+		}
+		fl_pop_clip();
+	}
+	if (_selection.selected_multiple() && (!_selection.from_tileset() || !Config::show_attributes())) {
+		if (_selection.from_tileset()) {
+			_tiles_scroll->bbox(X, Y, W, H);
+			fl_push_clip(X, Y, W, H);
+			_selection.draw_selection_border_at(_tile_picker->tile_x(_selection.left_col()),
+				_tile_picker->tile_y(_selection.top_row()), TILE_SIZE_2X);
+			fl_pop_clip();
+		}
+		else {
+			Tile_Tessera *tt = _tilemap.tile(_selection.left_col(), _selection.top_row());
+			if (tt) {
+				_tilemap_scroll->bbox(X, Y, W, H);
+				fl_push_clip(X, Y, W, H);
+				_selection.draw_selection_border_at(tt->x(), tt->y(), tt->w());
+				fl_pop_clip();
+			}
+		}
 	}
 	if (!_selection.selecting()) {
 		Fl_Widget *wgt = Fl::belowmouse();
 		if (wgt && wgt->type() == Tile_Tessera::TILE_TESSERA_TYPE) {
 			Tile_Tessera *tt = _tilemap.tile(0);
-			fl_push_clip(tt->x(), tt->y(), _tilemap.width() * tt->w(), _tilemap.height() * tt->h());
-			_selection.draw_selection_border_at((Tile_Tessera *)wgt);
+			_tilemap_scroll->bbox(X, Y, W, H);
+			fl_push_clip(X, Y, W, H);
+			fl_push_clip(tt->x(), tt->y(), (int)_tilemap.width() * tt->w(), (int)_tilemap.height() * tt->h());
+			_selection.draw_selection_border_at(wgt->x(), wgt->y(), wgt->w());
+			fl_pop_clip();
 			fl_pop_clip();
 		}
 	}
+	if (Draw_Stats::overlay()) {
+		// Drawn as part of the overlay so that showing it does not cost another frame
+		char buffer[512] = {};
+		Draw_Stats::describe(buffer, sizeof(buffer));
+		fl_font(FL_COURIER, 12);
+		int tw = 0, th = 0;
+		fl_measure(buffer, tw, th, 0);
+		int X = _tilemap_scroll->x() + _tilemap_scroll->w() - Fl::scrollbar_size() - tw - 12, Y = _tilemap_scroll->y() + 4;
+		fl_rectf(X, Y, tw + 8, th + 8, FL_BLACK);
+		fl_color(FL_WHITE);
+		fl_draw(buffer, X + 4, Y + 4, tw, th, FL_ALIGN_TOP_LEFT | FL_ALIGN_INSIDE);
+	}
 }
 
 int Main_Window::handle(int event) {
@@ -911,6 +990,7 @@ void Main_Window::update_selection_controls() {
 		_copy_selection_mi->activate();
 		_shift_selected_ids_mi->activate();
 		_crop_to_selection_mi->activate();
+		_find_block_mi->activate();
 	}
 	else {
 		_erase_selection_mi->deactivate();
@@ -919,56 +999,74 @@ void Main_Window::update_selection_controls() {
 		_copy_selection_mi->deactivate();
 		_shift_selected_ids_mi->deactivate();
 		_crop_to_selection_mi->deactivate();
+		_find_block_mi->deactivate();
 	}
 }
 
+static void update_status_label(Label *l, const char *s) {
+	// Only repaint status bar fields whose text changed
+	const char *v = l->label();
+	if (v ? !strcmp(v, s) : !*s) { return; }
+	l->copy_label(s);
+	// Labels have no box, so their parent repaints the background behind them
+	l->parent()->damage(FL_DAMAGE_ALL, l->x(), l->y(), l->w(), l->h());
+}
+
 void Main_Window::update_status(Tile_Tessera *tt) {
 	if (!_tilemap.size()) {
-		_tilemap_dimensions->label("");
-		_hover_id->label("");
-		_hover_xy->label("");
-		_hover_landmark->label("");
-		_status_bar->redraw();
+		update_status_label(_tilemap_dimensions, "");
+		update_status_label(_hover_id, "");
+		update_status_label(_hover_xy, "");
+		update_status_label(_hover_landmark, "");
 		return;
 	}
 	char buffer[64] = {};
 	sprintf(buffer, "Tilemap: %zu x %zu", _tilemap.width(), _tilemap.height());
-	_tilemap_dimensions->copy_label(buffer);
+	update_status_label(_tilemap_dimensions, buffer);
 	if (!tt) {
-		_hover_id->label("");
-		_hover_xy->label("");
-		_hover_landmark->label("");
-		_status_bar->redraw();
+		update_status_label(_hover_id, "");
+		update_status_label(_hover_xy, "");
+		update_status_label(_hover_landmark, "");
 		return;
 	}
 	int bank = (int)(tt->id() >> 8), offset = (int)(tt->id() & 0xFF);
-	sprintf(buffer, "ID: $%d:%02X", bank, offset);
-	_hover_id->copy_label(buffer);
+	sprintf(buffer, "ID: $%d:%02X (%zux)", bank, offset, _tilemap.count(tt->id()));
+	update_status_label(_hover_id, buffer);
 	sprintf(buffer, "X/Y (%zu, %zu)", tt->col(), tt->row());
-	_hover_xy->copy_label(buffer);
+	update_status_label(_hover_xy, buffer);
 	if (_tilemap.width() == GAME_BOY_WIDTH && _tilemap.height() == GAME_BOY_HEIGHT) {
 		if (format_has_landmarks(Config::format())) {
 			size_t lx = tt->col() * TILE_SIZE + TILE_SIZE / 2;
 			size_t ly = tt->row() * TILE_SIZE + TILE_SIZE / 2;
 			sprintf(buffer, "Landmark (%zu, %zu)", lx, ly);
-			_hover_landmark->copy_label(buffer);
+			update_status_label(_hover_landmark, buffer);
 		}
 		else if (format_has_emaps(Config::format()) &&
 			tt->col() >= 2 && tt->col() <= 0xF + 2 &&
 			tt->row() >= 1 && tt->row() <= 0xF + 1) {
 			size_t lx = tt->col() - 2, ly = tt->row() - 1;
 			sprintf(buffer, "Map (%zu, %zu)", lx, ly);
-			_hover_landmark->copy_label(buffer);
+			update_status_label(_hover_landmark, buffer);
 		}
 		else {
-			_hover_landmark->label("");
+			update_status_label(_hover_landmark, "");
 		}
 	}
 	else {
-		_hover_landmark->label("");
+		update_status_label(_hover_landmark, "");
 	}
 }
 
+void Main_Window::damage_tiles(const Tile_Rect &r) {
+	if (r.empty() || !_tilemap.size()) { return; }
+	_tilemap_scroll->damage_tiles(r);
+	_minimap_window->update(_tilemap, r);
+}
+
+void Main_Window::damage_tile(const Tile_Tessera *tt) {
+	_tilemap_scroll->damage_tiles(Tile_Rect(tt->col(), tt->row(), tt->col() + 1, tt->row() + 1));
+}
+
 void Main_Window::update_tilemap_metadata() {
 	if (_tilemap.size()) {
 		if (_tilemap_file.empty()) {
@@ -995,6 +1093,7 @@ void Main_Window::update_tilemap_metadata() {
 		_tilemap_name->label(NO_FILE_SELECTED_LABEL);
 		_tilemap_format->label("");
 	}
+	update_watched_files();
 }
 
 void Main_Window::update_tileset_metadata() {
@@ -1013,9 +1112,43 @@ void Main_Window::update_tileset_metadata() {
 	else {
 		_tileset_name->label(NO_FILES_SELECTED_LABEL);
 	}
+	update_watched_files();
+	// Rebuilding the minimap visits every tile, so skip it when nothing it shows has changed, as after a save
+	std::vector<Minimap_Source> sources;
+	for (size_t i = 0; i < _tilesets.size(); i++) {
+		const Tileset &t = _tilesets[i];
+		sources.push_back({_tileset_files[i], t.modified(), t.file_size(), t.start_id(), t.offset(), t.length(),
+			t.layout()});
+	}
+	if (sources != _minimap_sources || _tilemap.width() != _minimap_width || _tilemap.size() != _minimap_size) {
+		_minimap_sources.swap(sources);
+		_minimap_width = _tilemap.width();
+		_minimap_size = _tilemap.size();
+		update_minimap();
+	}
+}
+
+void Main_Window::update_minimap() {
+	_minimap_window->rebuild(_tilemap);
+	double x, y, w, h;
+	_tilemap_scroll->view(x, y, w, h);
+	_minimap_window->view(x, y, w, h);
+}
+
+void Main_Window::update_watched_files() {
+	// Watching again after each save takes the saved files as unchanged
+	std::vector<std::string> filenames;
+	if (Config::auto_reload()) {
+		filenames.push_back(_tilemap_file);
+		filenames.push_back(_attrmap_file);
+		filenames.insert(filenames.end(), RANGE(_tileset_files));
+	}
+	_file_watcher.watch(filenames);
 }
 
 void Main_Window::update_active_controls() {
+	// Blocks found before the tilemap changed may not be there anymore
+	clear_found_blocks();
 	if (_tilemap.size()) {
 		_close_mi->activate();
 		_save_mi->activate();
@@ -1136,14 +1269,7 @@ void Main_Window::update_active_controls() {
 	int n = format_tileset_size(Config::format());
 #pragma warning(suppress: 26812)
 	_tiles_scroll->type((uchar)(tileset_width() > DEFAULT_TILES_PER_ROW ? Fl_Scroll::BOTH_ALWAYS : Fl_Scroll::VERTICAL_ALWAYS));
-	while (_tiles_scroll->children()) {
-		_tiles_scroll->remove(0);
-	}
-	for (int i = Config::format() == Tilemap_Format::SW_TOWN_MAP ? 0x01 : 0x00; i < n; i++) {
-		_tiles_scroll->add(_tile_buttons[i]);
-	}
-	_tiles_scroll->add(_tiles_scroll->scrollbar);
-	_tiles_scroll->add(_tiles_scroll->hscrollbar);
+	_tile_picker->tiles(Config::format() == Tilemap_Format::SW_TOWN_MAP ? 0x01 : 0x00, n);
 	_tiles_scroll->init_sizes();
 	int tw = tileset_width() * TILE_SIZE_2X, max_th = ((n + tileset_width() - 1) / tileset_width()) * TILE_SIZE_2X;
 	_tiles_scroll->contents(tw, max_th);
@@ -1209,14 +1335,10 @@ void Main_Window::update_active_controls() {
 
 void Main_Window::update_tileset_width(int tw) {
 	_tileset_width = tw;
-	int ox = _tiles_scroll->x() + Fl::box_dx(_tiles_scroll->box());
-	int oy = _tiles_scroll->y() + Fl::box_dy(_tiles_scroll->box());
-	for (int i = 0; i < MAX_NUM_TILES; i++) {
-		int col = i % tw, row = i / tw;
-		int tx = ox + col * TILE_SIZE_2X, ty = oy + row * TILE_SIZE_2X;
-		Tile_Button *tb = _tile_buttons[i];
-		tb->position(tx, ty);
-		tb->coords((size_t)row, (size_t)col);
+	_tile_picker->columns(tw);
+	// A single selected tile keeps its ID but moves to a new row and column
+	if (_selection.selected() && _selection.from_tileset() && !_selection.selected_multiple()) {
+		_selection.select_single(_tile_picker->cell(_selection.id()));
 	}
 }
 
@@ -1281,6 +1403,7 @@ void Main_Window::shift_tileset() {
 		t.shift(dn);
 	}
 
+	update_minimap();
 	redraw();
 }
 
@@ -1320,13 +1443,13 @@ void Main_Window::shift_tile_ids() {
 	for (size_t i = 0; i < n; i++) {
 		Tile_Tessera *tt = _tilemap.tile(i);
 		tt->shift_id(d, m);
-		tt->damage(1);
 	}
 	_tilemap.modified(true);
+	_tilemap.reindex();
+	damage_tiles(_tilemap.bounds());
 
 	update_status(NULL);
 	update_active_controls();
-	redraw();
 }
 
 void Main_Window::reformat_tilemap() {
@@ -1353,7 +1476,11 @@ void Main_Window::reformat_tilemap() {
 
 	update_tilemap_metadata();
 	update_active_controls();
-	redraw();
+	// The format affects how every tile is drawn, and which tiles and palettes are available
+	_tilemap_scroll->redraw();
+	_left_group->redraw();
+	_status_bar->redraw();
+	update_minimap();
 
 	std::string msg = "Reformatted ";
 	msg = msg + _tilemap_basename + "!";
@@ -1368,7 +1495,10 @@ void Main_Window::edit_tile(Tile_Tessera *tt) {
 		bool a = Config::show_attributes();
 		if (fs.same(ts, a)) { return; }
 		tt->assign(ts, a);
-		tt->damage(1);
+		damage_tile(tt);
+		Tile_Rect changed(tt->col(), tt->row(), tt->col() + 1, tt->row() + 1);
+		_tilemap.reindex(changed);
+		_minimap_window->update(_tilemap, changed);
 		return;
 	}
 	bool a = Config::show_attributes();
@@ -1388,7 +1518,6 @@ void Main_Window::edit_tile(Tile_Tessera *tt) {
 				if (tti && id < n) {
 					Tile_State ts(id, x_flip(), y_flip(), priority(), obp1(), palette());
 					tti->assign(ts, a);
-					tti->damage(1);
 				}
 			}
 		}
@@ -1407,11 +1536,13 @@ void Main_Window::edit_tile(Tile_Tessera *tt) {
 					const Tile_State &ps = tms.state(index);
 					Tile_State ts(ps.id, x_flip() != ps.x_flip, y_flip() != ps.y_flip, ps.priority, ps.obp1, ps.palette);
 					tti->replace(ts, a);
-					tti->damage(1);
 				}
 			}
 		}
 	}
+	Tile_Rect changed(tx, ty, tx + mx, ty + my);
+	_tilemap.reindex(changed);
+	damage_tiles(changed);
 }
 
 void Main_Window::flood_fill(Tile_Tessera *tt) {
@@ -1420,24 +1551,41 @@ void Main_Window::flood_fill(Tile_Tessera *tt) {
 	bool a = Config::show_attributes();
 	bool mf = _selection.selected_multiple() && !(a && _selection.from_tileset());
 	if (!mf && fs.same(ts, a)) { return; }
-	size_t w = _tilemap.width(), h = _tilemap.height(), n = _tilemap.size();
-	std::vector<bool> filled(n, false);
-	std::queue<size_t> queue;
+	size_t w = _tilemap.width(), n = _tilemap.size();
 	size_t row = tt->row(), col = tt->col();
-	queue.push(row * w + col);
-	while (!queue.empty()) {
-		size_t i = queue.front();
-		queue.pop();
-		if (i >= n) { continue; }
-		Tile_Tessera *ff = _tilemap.tile(i);
-		size_t r = ff->row(), c = ff->col();
-		if (!ff->state().same(fs, a) || filled[i]) { continue; }
-		if (!mf) { ff->assign(ts, a); } // fill
-		filled[i] = true;
-		if (c > 0) { queue.push(i-1); } // left
-		if (c < w - 1) { queue.push(i+1); } // right
-		if (r > 0) { queue.push(i-w); } // up
-		if (r < h - 1) { queue.push(i+w); } // down
+	if (!w || row * w + col >= n) { return; }
+	// Fill whole runs of a row at once, then look for runs to fill above and below them
+	_fill_visited.assign(n, false);
+	std::vector<Tile_Rect> spans;
+	std::vector<size_t> seeds(1, row * w + col);
+	Tile_Rect changed;
+	auto fillable = [&](size_t i) { return !_fill_visited[i] && _tilemap.tile(i)->state().same(fs, a); };
+	while (!seeds.empty()) {
+		size_t i = seeds.back();
+		seeds.pop_back();
+		if (!fillable(i)) { continue; }
+		size_t r = i / w, first = r * w, last = std::min(first + w, n);
+		size_t left = i, right = i + 1;
+		while (left > first && fillable(left - 1)) { left--; }
+		while (right < last && fillable(right)) { right++; }
+		for (size_t j = left; j < right; j++) {
+			_fill_visited[j] = true;
+			if (!mf) { _tilemap.tile(j)->assign(ts, a); _tilemap.reindex(j); } // fill
+		}
+		Tile_Rect span(left - first, r, right - first, r + 1);
+		changed.add(span.left, r);
+		changed.add(span.right - 1, r);
+		spans.push_back(span);
+		// Seed each run of fillable cells next to the span once
+		for (size_t nf : {first - w, first + w}) {
+			if (nf >= n) { continue; } // past the last row, or wrapped around above the first
+			bool run = false;
+			for (size_t j = nf + span.left, k = std::min(nf + span.right, n); j < k; j++) {
+				bool f = fillable(j);
+				if (f && !run) { seeds.push_back(j); }
+				run = f;
+			}
+		}
 	}
 	if (mf) {
 		bool fts = _selection.from_tileset();
@@ -1446,50 +1594,54 @@ void Main_Window::flood_fill(Tile_Tessera *tt) {
 		size_t tw = fts ? (size_t)tileset_width() : _tilemap.width();
 		size_t tn = (size_t)format_tileset_size(Config::format());
 		const Tilemap_State &tms = _tilemap.last_state();
-		for (size_t i = 0; i < n; i++) {
-			if (!filled[i]) { continue; }
-			Tile_Tessera *tti = _tilemap.tile(i);
-			size_t ix = tti->col();
-			while (ix < col) { ix += ow; }
-			ix = (ix - col) % ow;
-			size_t iy = tti->row();
-			while (iy < row) { iy += oh; }
-			iy = (iy - row) % oh;
-			size_t dx = x_flip() ? ow - ix - 1 : ix;
+		// The pattern repeats from the clicked cell in every direction
+		for (const Tile_Rect &span : spans) {
+			size_t iy = (span.top + oh - row % oh) % oh;
 			size_t dy = y_flip() ? oh - iy - 1 : iy;
-			size_t index = (oy + dy) * tw + ox + dx;
-			if (index >= (fts ? tn : n)) { continue; }
-			if (fts) {
-				ts.id = (uint16_t)index;
-			}
-			else {
-				ts = tms.state(index);
-				if (!a) {
-					if (x_flip()) { ts.x_flip = !ts.x_flip; }
-					if (y_flip()) { ts.y_flip = !ts.y_flip; }
+			for (size_t c = span.left; c < span.right; c++) {
+				size_t ix = (c + ow - col % ow) % ow;
+				size_t dx = x_flip() ? ow - ix - 1 : ix;
+				size_t index = (oy + dy) * tw + ox + dx;
+				if (index >= (fts ? tn : n)) { continue; }
+				if (fts) {
+					ts.id = (uint16_t)index;
 				}
 				else {
-					if (priority()) { ts.priority = true; }
-					if (obp1()) { ts.obp1 = true; }
+					ts = tms.state(index);
+					if (!a) {
+						if (x_flip()) { ts.x_flip = !ts.x_flip; }
+						if (y_flip()) { ts.y_flip = !ts.y_flip; }
+					}
+					else {
+						if (priority()) { ts.priority = true; }
+						if (obp1()) { ts.obp1 = true; }
+					}
 				}
+				size_t i = span.top * w + c;
+				_tilemap.tile(i)->assign(ts, a);
+				_tilemap.reindex(i);
 			}
-			tti->assign(ts, a);
 		}
 	}
+	damage_tiles(changed);
 }
 
 void Main_Window::substitute_tile(Tile_Tessera *tt) {
 	Tile_State fs = tt->state();
 	Tile_State ts(tile_id(), x_flip(), y_flip(), priority(), obp1(), palette());
 	bool a = Config::show_attributes();
-	size_t n = _tilemap.size();
-	for (size_t i = 0; i < n; i++) {
+	// Copied, since reindexing the cells changes their group
+	std::vector<size_t> cells(a ? _tilemap.cells_with_attributes(fs) : _tilemap.cells_with_id(fs.id));
+	Tile_Rect changed;
+	for (size_t i : cells) {
 		Tile_Tessera *ff = _tilemap.tile(i);
 		if (ff->state().same(fs, a)) {
 			ff->assign(ts, a);
-			ff->damage(1);
+			_tilemap.reindex(i);
+			changed.add(ff->col(), ff->row());
 		}
 	}
+	damage_tiles(changed);
 }
 
 void Main_Window::swap_tiles(Tile_Tessera *tt) {
@@ -1497,18 +1649,28 @@ void Main_Window::swap_tiles(Tile_Tessera *tt) {
 	Tile_State ts(tile_id(), x_flip(), y_flip(), priority(), obp1(), palette());
 	bool a = Config::show_attributes();
 	if (fs.same(ts, a)) { return; }
-	size_t n = _tilemap.size();
-	for (size_t i = 0; i < n; i++) {
+	std::vector<size_t> cells(a ? _tilemap.cells_with_attributes(fs) : _tilemap.cells_with_id(fs.id));
+	if (a || fs.id != ts.id) {
+		// Attribute groups always differ here, but tiles differing only by flips share an ID group
+		const std::vector<size_t> &others = a ? _tilemap.cells_with_attributes(ts) : _tilemap.cells_with_id(ts.id);
+		cells.insert(cells.end(), RANGE(others));
+	}
+	Tile_Rect changed;
+	for (size_t i : cells) {
 		Tile_Tessera *ff = _tilemap.tile(i);
 		if (ff->state().same(fs, a)) {
 			ff->assign(ts, a);
-			ff->damage(1);
 		}
 		else if (ff->state().same(ts, a)) {
 			ff->assign(fs, a);
-			ff->damage(1);
 		}
+		else {
+			continue;
+		}
+		_tilemap.reindex(i);
+		changed.add(ff->col(), ff->row());
 	}
+	damage_tiles(changed);
 }
 
 void Main_Window::erase_selection() {
@@ -1524,9 +1686,11 @@ void Main_Window::erase_selection() {
 			Tile_Tessera *tt = _tilemap.tile(x, y);
 			if (!tt) { continue; }
 			tt->replace(ts, a);
-			tt->damage(1);
 		}
 	}
+	Tile_Rect changed(ox, oy, mx, my);
+	_tilemap.reindex(changed);
+	damage_tiles(changed);
 	_tilemap.modified(true);
 	update_active_controls();
 }
@@ -1550,10 +1714,11 @@ void Main_Window::x_flip_selection() {
 			}
 			tt1->replace(ts2, a);
 			tt2->replace(ts1, a);
-			tt1->damage(1);
-			tt2->damage(1);
 		}
 	}
+	Tile_Rect changed(ox, oy, ox + ow, my);
+	_tilemap.reindex(changed);
+	damage_tiles(changed);
 	_tilemap.modified(true);
 	update_active_controls();
 }
@@ -1577,10 +1742,11 @@ void Main_Window::y_flip_selection() {
 			}
 			tt1->replace(ts2, a);
 			tt2->replace(ts1, a);
-			tt1->damage(1);
-			tt2->damage(1);
 		}
 	}
+	Tile_Rect changed(ox, oy, mx, oy + oh);
+	_tilemap.reindex(changed);
+	damage_tiles(changed);
 	_tilemap.modified(true);
 	update_active_controls();
 }
@@ -1591,14 +1757,16 @@ void Main_Window::shift_selected_ids(int d, int n) {
 	_tilemap.remember();
 	size_t ox = _selection.left_col(), oy = _selection.top_row();
 	size_t mx = ox + _selection.width(), my = oy + _selection.height();
-	for (size_t y = oy; y < oy + my; y++) {
-		for (size_t x = ox; x < ox + mx; x++) {
+	for (size_t y = oy; y < my; y++) {
+		for (size_t x = ox; x < mx; x++) {
 			Tile_Tessera *tt = _tilemap.tile(x, y);
 			if (!tt) { continue; }
 			tt->shift_id(d, n);
-			tt->damage(1);
 		}
 	}
+	Tile_Rect changed(ox, oy, mx, my);
+	_tilemap.reindex(changed);
+	damage_tiles(changed);
 	_tilemap.modified(true);
 	update_active_controls();
 }
@@ -1627,14 +1795,117 @@ void Main_Window::select_all() {
 	Tile_Tessera *tt1 = _tilemap.tile(_tilemap.width() - 1, 0);
 	Tile_Tessera *tt2 = _tilemap.tile(0, _tilemap.height() - 1);
 	if (!tt1 || !tt2 || tt1 == tt2) { return; }
-	_selection.start_selecting(tt1);
-	_selection.continue_selecting(tt2);
+	_selection.start_selecting(tt1->cell(), false);
+	_selection.continue_selecting(tt2->cell());
 	_selection.finish_selecting();
 	update_selection_status();
 	update_selection_controls();
 	redraw_overlay();
 }
 
+void Main_Window::find_block() {
+	if (!_selection.selected_multiple() || _selection.from_tileset()) { return; }
+	bool a = Config::show_attributes();
+	size_t w = _tilemap.width(), n = _tilemap.size();
+	size_t ox = _selection.left_col(), oy = _selection.top_row();
+	size_t bw = _selection.width(), bh = _selection.height();
+	std::vector<uint32_t> cells(n);
+	for (size_t i = 0; i < n; i++) {
+		cells[i] = block_key(_tilemap.tile(i)->state(), a);
+	}
+	// Block b is the selection flipped by b's bits: 1 for X and 2 for Y
+	std::vector<std::vector<uint32_t>> blocks(Config::find_flipped() ? 4 : 1, std::vector<uint32_t>(bw * bh));
+	for (size_t b = 0; b < blocks.size(); b++) {
+		bool xf = !!(b & 1), yf = !!(b & 2);
+		for (size_t by = 0; by < bh; by++) {
+			for (size_t bx = 0; bx < bw; bx++) {
+				size_t i = (oy + (yf ? bh - by - 1 : by)) * w + ox + (xf ? bw - bx - 1 : bx);
+				// Cells past the end of the tilemap match nothing
+				if (i >= n) { blocks[b][by * bw + bx] = UINT32_MAX; continue; }
+				Tile_State ts = _tilemap.tile(i)->state();
+				ts.x_flip = ts.x_flip != xf;
+				ts.y_flip = ts.y_flip != yf;
+				blocks[b][by * bw + bx] = block_key(ts, a);
+			}
+		}
+	}
+	_found_blocks = find_blocks(cells, w, blocks, bw, bh);
+	_found_width = bw;
+	_found_height = bh;
+	char buffer[32] = {};
+	sprintf(buffer, "Found: %zu", _found_blocks.size());
+	update_status_label(_found_count, buffer);
+	if (!_found_blocks.empty()) {
+		_replace_found_blocks_mi->activate();
+	}
+	redraw_overlay();
+}
+
+void Main_Window::replace_found_blocks() {
+	if (_found_blocks.empty() || !_selection.selected()) { return; }
+	size_t w = _tilemap.width(), n = _tilemap.size();
+	size_t bw = _found_width, bh = _found_height;
+	std::vector<Block_Match> matches = _found_blocks;
+	drop_overlapping_blocks(matches, w, bw, bh);
+	bool a = Config::show_attributes();
+	_tilemap.remember();
+	// Each block gets the selection, repeated to fill it like a flood fill's pattern, and flipped like the block was
+	bool multiple = _selection.selected_multiple(), from_tileset = multiple && _selection.from_tileset();
+	size_t sw = _selection.width(), sh = _selection.height();
+	size_t ox = _selection.left_col(), oy = _selection.top_row();
+	uint16_t tn = (uint16_t)format_tileset_size(Config::format());
+	size_t tw = (size_t)tileset_width();
+	const Tilemap_State &tms = _tilemap.last_state();
+	auto stamp = [&](size_t bx, size_t by, bool xf, bool yf, Tile_State &ts) {
+		size_t ix = (xf ? bw - bx - 1 : bx) % sw, iy = (yf ? bh - by - 1 : by) % sh;
+		size_t dx = x_flip() ? sw - ix - 1 : ix, dy = y_flip() ? sh - iy - 1 : iy;
+		if (!multiple) {
+			ts = Tile_State(tile_id(), x_flip() != xf, y_flip() != yf, priority(), obp1(), palette());
+			return true;
+		}
+		if (from_tileset) {
+			uint16_t id = (uint16_t)((oy + dy) * tw + ox + dx);
+			ts = Tile_State(id, x_flip() != xf, y_flip() != yf, priority(), obp1(), palette());
+			return id < tn;
+		}
+		size_t index = (oy + dy) * w + ox + dx;
+		if (index >= n) { return false; }
+		const Tile_State &ps = tms.state(index);
+		ts = Tile_State(ps.id, (x_flip() != ps.x_flip) != xf, (y_flip() != ps.y_flip) != yf, ps.priority, ps.obp1,
+			ps.palette);
+		return true;
+	};
+	Tile_Rect changed;
+	for (const Block_Match &m : matches) {
+		size_t tx = m.index % w, ty = m.index / w;
+		bool xf = !!(m.block & 1), yf = !!(m.block & 2);
+		for (size_t by = 0; by < bh; by++) {
+			for (size_t bx = 0; bx < bw; bx++) {
+				Tile_Tessera *tt = _tilemap.tile(tx + bx, ty + by);
+				Tile_State ts;
+				if (!tt || !stamp(bx, by, xf, yf, ts)) { continue; }
+				if (multiple && !from_tileset) { tt->replace(ts, a); }
+				else { tt->assign(ts, a); }
+			}
+		}
+		changed.add(tx, ty);
+		changed.add(tx + bw - 1, ty + bh - 1);
+	}
+	_tilemap.reindex(changed);
+	damage_tiles(changed);
+	_tilemap.modified(true);
+	update_active_controls();
+}
+
+void Main_Window::clear_found_blocks() {
+	_replace_found_blocks_mi->deactivate();
+	if (!_found_width) { return; }
+	_found_blocks.clear();
+	_found_width = _found_height = 0;
+	update_status_label(_found_count, "");
+	redraw_overlay();
+}
+
 void Main_Window::new_tilemap(size_t width, size_t height) {
 	_tilemap.modified(false);
 	close_cb(NULL, this);
@@ -1651,7 +1922,7 @@ void Main_Window::new_tilemap(size_t width, size_t height) {
 }
 
 void Main_Window::open_tilemap(const char *filename) {
-	_tilemap_options_dialog->format(guess_format(filename));
+	_tilemap_options_dialog->format(guess_format(filename, Config::format()));
 	_tilemap_options_dialog->use_tilemap(filename);
 	_tilemap_options_dialog->importing(false);
 	_tilemap_options_dialog->show(this);
@@ -1819,6 +2090,87 @@ void Main_Window::import_tilemap(const char *filename) {
 	setup_tilemap(IMPORTED_TILEMAP_NAME, old_tileset_size, importing_rmp ? filename : NULL);
 }
 
+void Main_Window::reload_tilemap() {
+	if (_tilemap_file.empty()) { return; }
+
+	// Read into another tilemap first, so a file caught half-written leaves this one alone
+	Tilemap tilemap;
+	Tilemap::Result result = tilemap.read_tiles(_tilemap_file.c_str(), _attrmap_file.c_str());
+	size_t n = tilemap.size();
+	if (result != Tilemap::Result::TILEMAP_OK || !n) {
+		tilemap.free_tiles();
+		return;
+	}
+
+	bool same_size = n == _tilemap.size();
+	Tile_Rect changed;
+	if (same_size) {
+		size_t w = _tilemap.width();
+		for (size_t i = 0; i < n; i++) {
+			Tile_State ps = _tilemap.tile(i)->state(), ts = tilemap.tile(i)->state();
+			if (!ps.same_tiles(ts) || !ps.same_attributes(ts)) {
+				changed.add(i % w, i / w);
+			}
+		}
+		if (changed.empty()) {
+			// The file already holds what is shown
+			tilemap.free_tiles();
+			_tilemap.modified(false);
+			update_active_controls();
+			return;
+		}
+	}
+
+	// Unsaved changes are confirmed before the file replaces them; canceling leaves them unsaved
+	if (unsaved()) {
+		std::string msg = fl_filename_name(_tilemap_file.c_str());
+		msg = msg + " was changed by another program!\n\n"
+			"Reload it and lose your unsaved changes?";
+		_unsaved_dialog->message(msg);
+		_unsaved_dialog->show(this);
+		if (_unsaved_dialog->canceled()) {
+			tilemap.free_tiles();
+			return;
+		}
+	}
+
+	if (same_size) {
+		// The same size keeps the view, and the reload is one more edit to undo
+		_tilemap.remember();
+		for (size_t i = 0; i < n; i++) {
+			_tilemap.tile(i)->state(tilemap.tile(i)->state());
+		}
+		_tilemap.reindex(changed);
+		tilemap.free_tiles();
+		_tilemap.modified(false);
+		damage_tiles(changed);
+		update_status(NULL);
+		update_active_controls();
+		return;
+	}
+
+	int sx = _tilemap_scroll->xposition(), sy = _tilemap_scroll->yposition();
+	if (_selection.selected_multiple() && !_selection.from_tileset()) {
+		select_tile(_selection.id());
+	}
+	_tilemap_scroll->clear();
+	_tilemap.replace(tilemap);
+	for (size_t i = 0; i < n; i++) {
+		Tile_Tessera *tt = _tilemap.tile(i);
+		tt->callback((Fl_Callback *)change_tile_cb, this);
+		_tilemap_scroll->add(tt);
+	}
+	_tilemap.modified(false);
+
+	_tilemap_width->default_value(_tilemap.width());
+	tilemap_width_tb_cb(NULL, this);
+	_tilemap_scroll->scroll_clamped(sx, sy);
+	update_status(NULL);
+	update_active_controls();
+	update_minimap();
+	redraw();
+}
+
 void Main_Window::export_tilemap(const char *filename) {
 	const char *basename = fl_filename_name(filename);
 	if (_tilemap.export_tiles(filename)) {
@@ -1836,10 +2188,53 @@ void Main_Window::export_tilemap(const char *filename) {
 	}
 }
 
-void Main_Window::add_tileset(const char *filename, int start, int offset, int length, bool quiet) {
+bool Main_Window::update_compression_subjects(bool wait_for_edits) {
+	std::vector<Subject_Source> sources;
+	// The tileset each source is, or NULL for the tilemap
+	std::vector<const Tileset *> tilesets;
+	// Subjects are named by full path, since tilesets with the same name may be in different directories
+	if (_tilemap.size()) {
+		const char *name = _tilemap_file.empty() ? _tilemap_basename.c_str() : _tilemap_file.c_str();
+		Subject_Source source = {name, (int64_t)_tilemap.revision(), (size_t)Config::format()};
+		// Encoding a large tilemap takes a while, so keep its last subject until it goes one poll without an edit
+		bool editing = wait_for_edits && _tilemap.revision() != _advisor_revision;
+		_advisor_revision = _tilemap.revision();
+		if (editing && !_compression_sources.empty() && _compression_sources.front().name == source.name) {
+			source = _compression_sources.front();
+		}
+		sources.push_back(source);
+		tilesets.push_back(NULL);
+	}
+	for (size_t i = 0; i < _tilesets.size(); i++) {
+		// Image tilesets have no raw tile data to measure
+		const Tileset &t = _tilesets[i];
+		if (t.data().empty()) { continue; }
+		sources.push_back({_tileset_files[i], t.modified(), t.file_size()});
+		tilesets.push_back(&t);
+	}
+	if (sources == _compression_sources) { return false; }
+	std::vector<Compression_Subject> subjects;
+	for (size_t i = 0; i < sources.size(); i++) {
+		auto old = std::find(RANGE(_compression_sources), sources[i]);
+		if (old != _compression_sources.end()) {
+			subjects.push_back(_compression_subjects[old - _compression_sources.begin()]);
+		}
+		else if (tilesets[i]) {
+			subjects.push_back({sources[i].name, tilesets[i]->data(), {}});
+		}
+		else {
+			subjects.push_back(_tilemap.compression_subject(sources[i].name.c_str(), Config::format()));
+		}
+	}
+	_compression_subjects.swap(subjects);
+	_compression_sources.swap(sources);
+	return true;
+}
+
+void Main_Window::add_tileset(const char *filename, int start, int offset, int length, Tile_Layout layout, bool quiet) {
 	const char *basename = fl_filename_name(filename);
-	Tileset tileset(start, offset, length);
-	Tileset::Result result = tileset.read_tiles(filename);
+	Tileset tileset(start, offset, length, layout);
+	Tileset::Result result = tileset.read_tiles(filename, Config::context());
 	if (result != Tileset::Result::TILESET_OK) {
 		if (!quiet) {
 			std::string msg = "Error reading ";
@@ -1877,7 +2272,7 @@ void Main_Window::load_recent_tileset(int n) {
 }
 
 static const char *tileset_extensions[] = {
-	".png", ".gif", ".bmp", ".1bpp", ".2bpp", ".4bpp", ".8bpp", ".1bpp.lz", ".2bpp.lz", ".rgcn", ".ncgr", ".rmp", ".rts"
+	".png", ".gif", ".bmp", ".1bpp", ".2bpp", ".4bpp", ".8bpp", ".1bpp.lz", ".2bpp.lz", ".4bpp.lz", ".8bpp.lz", ".rgcn", ".ncgr", ".rmp", ".rts"
 };
 
 void Main_Window::load_corresponding_tileset(const char *filename) {
@@ -1901,6 +2296,50 @@ void Main_Window::load_corresponding_tileset(const char *filename) {
 	}
 }
 
+Image_to_Tiles_Result Main_Window::image_to_tiles() {
+	Image_to_Tiles_Result output = {};
+
+	Image_to_Tiles_Options opts;
+	opts.image_filename = _image_to_tiles_dialog->image_filename();
+	opts.tileset_filename = _image_to_tiles_dialog->tileset_filename();
+	opts.tilemap_filename = _image_to_tiles_dialog->tilemap_filename();
+	opts.attrmap_filename = _image_to_tiles_dialog->attrmap_filename();
+	opts.palette_filename = _image_to_tiles_dialog->palette_filename();
+	opts.tilepal_filename = _image_to_tiles_dialog->tilepal_filename();
+	opts.fmt = _image_to_tiles_dialog->format();
+	opts.make_palette = _image_to_tiles_dialog->palette();
+	opts.pal_fmt = _image_to_tiles_dialog->palette_format();
+	opts.use_color_zero = _image_to_tiles_dialog->color_zero();
+	if (opts.use_color_zero) { opts.color_zero = _image_to_tiles_dialog->fl_color_zero(); }
+	opts.start_index = _image_to_tiles_dialog->start_index();
+	opts.allow_unique = _image_to_tiles_dialog->unique_tiles();
+	opts.allow_flip = _image_to_tiles_dialog->flip_tiles();
+	opts.start_id = _image_to_tiles_dialog->start_id();
+	opts.use_blank = _image_to_tiles_dialog->use_blank();
+	opts.blank_id = _image_to_tiles_dialog->blank_id();
+	opts.tileset_width = tileset_width();
+	opts.no_extra_blank_tiles = _image_to_tiles_dialog->no_extra_blank_tiles();
+
+	size_t width = 0;
+	std::string msg;
+	if (!::image_to_tiles(opts, width, msg)) {
+		_error_dialog->message(msg);
+		_error_dialog->show(this);
+		return output;
+	}
+	_success_dialog->message(msg);
+	_success_dialog->show(this);
+
+	output.tileset_filename = _image_to_tiles_dialog->tileset_filename();
+	output.tilemap_filename = _image_to_tiles_dialog->tilemap_filename();
+	output.attrmap_filename = _image_to_tiles_dialog->attrmap_filename();
+	output.fmt = opts.fmt;
+	output.width = width;
+	output.start_id = opts.start_id;
+	output.success = true;
+	return output;
+}
+
 void Main_Window::open_converted_tilemap(Image_to_Tiles_Result output) {
 	_tilemap.modified(false);
 	close_cb(NULL, this);
@@ -1937,7 +2376,8 @@ void Main_Window::open_converted_tilemap(Image_to_Tiles_Result output) {
 	_tilemap.width(output.width);
 
 	setup_tilemap(tilemap_basename, format_tileset_size(output.fmt));
-	add_tileset(output.tileset_filename, output.start_id);
+	// Tile data was written in the format's own layout
+	add_tileset(output.tileset_filename, output.start_id, 0, 0, format_tile_layout(output.fmt));
 
 }
 
@@ -1955,7 +2395,10 @@ void Main_Window::open_or_import_or_convert(const char *filename) {
 }
 
 void Main_Window::select_tile(uint16_t id) {
-	_selection.select_single(_tile_buttons[id]);
+	bool same = _selection.selected() && !_selection.selected_multiple() && _selection.from_tileset() && _selection.id() == id;
+	int py = _tiles_scroll->yposition();
+	_selection.select_single(_tile_picker->cell(id));
+	_tile_picker->select(id);
 	_current_tile->id(id);
 
 	int ds = (int)(id / tileset_width()) * TILE_SIZE_2X;
@@ -1969,21 +2412,35 @@ void Main_Window::select_tile(uint16_t id) {
 	update_selection_status();
 	update_selection_controls();
 
+	// Right-clicking the tilemap reselects the same tile often, which changes nothing
+	if (same && py == _tiles_scroll->yposition()) { return; }
 	_current_tile->redraw();
 	_tiles_tab->redraw();
 }
 
 void Main_Window::highlight_tile(uint16_t id) {
-	Config::highlight_id(Config::highlight_id() != id ? id : (uint16_t)-1);
-	_tilemap_scroll->redraw();
-	_tiles_tab->redraw();
+	uint16_t old_id = Config::highlight_id();
+	Config::highlight_id(old_id != id ? id : (uint16_t)-1);
+	// Only tiles that gain or lose the highlight need repainting
+	for (size_t i : _tilemap.cells_with_id(id)) {
+		damage_tile(_tilemap.tile(i));
+	}
+	if (old_id != id) {
+		for (size_t i : _tilemap.cells_with_id(old_id)) {
+			damage_tile(_tilemap.tile(i));
+		}
+	}
+	_tile_picker->damage_tile(old_id);
+	_tile_picker->damage_tile(id);
 }
 
 void Main_Window::select_palette(int palette) {
 	if (!_selection.from_tileset()) {
-		_selection.select_single(_tile_buttons[tile_id()]);
+		_selection.select_single(_tile_picker->cell(tile_id()));
+		_tile_picker->select(tile_id());
 	}
 
+	if (_selected_palette == _palette_buttons[palette]) { return; }
 	if (_selected_palette) {
 		_selected_palette->clear();
 	}
@@ -2115,6 +2572,7 @@ void Main_Window::close_cb(Fl_Widget *, Main_Window *mw) {
 	mw->update_tilemap_metadata();
 	mw->update_status(NULL);
 	mw->update_active_controls();
+	mw->update_minimap();
 	mw->redraw();
 }
 
@@ -2254,22 +2712,30 @@ void Main_Window::add_tileset_cb(Fl_Widget *, Main_Window *mw) {
 	int start = mw->_add_tileset_dialog->start_id();
 	int offset = mw->_add_tileset_dialog->offset();
 	int length = mw->_add_tileset_dialog->length();
-	mw->add_tileset(filename, start, offset, length);
+	Tile_Layout layout = mw->_add_tileset_dialog->layout();
+	mw->add_tileset(filename, start, offset, length, layout);
 }
 
 void Main_Window::reload_tilesets_cb(Fl_Widget *, Main_Window *mw) {
 	if (mw->_tilesets.empty()) { return; }
 
-	std::vector<Tileset> tilesets(mw->_tilesets);
-	std::vector<std::string> tileset_files(mw->_tileset_files);
-	mw->_tilesets.clear();
-	mw->_tileset_files.clear();
-	size_t n = tilesets.size();
-	for (size_t i = 0; i < n; i++) {
-		const char *filename = tileset_files[i].c_str();
-		Tileset &t = tilesets[i];
-		mw->add_tileset(filename, t.start_id(), t.offset(), t.length());
+	// Unchanged files are skipped, and changed tile data only decodes its changed tiles again
+	for (size_t i = 0; i < mw->_tilesets.size();) {
+		const char *filename = mw->_tileset_files[i].c_str();
+		Tileset &t = mw->_tilesets[i];
+		Tileset::Result result = t.reload_tiles(filename, Config::context());
+		if (result == Tileset::Result::TILESET_OK) { i++; continue; }
+		std::string msg = "Error reading ";
+		msg = msg + fl_filename_name(filename) + "!\n\n" + Tileset::error_message(result);
+		t.clear();
+		mw->_tilesets.erase(mw->_tilesets.begin() + i);
+		mw->_tileset_files.erase(mw->_tileset_files.begin() + i);
+		mw->_error_dialog->message(msg);
+		mw->_error_dialog->show(mw);
 	}
+	mw->update_tileset_metadata();
+	mw->update_active_controls();
+	mw->redraw();
 }
 
 void Main_Window::unload_tilesets_cb(Fl_Widget *w, Main_Window *mw) {
@@ -2293,6 +2759,11 @@ void Main_Window::auto_load_tileset_cb(Fl_Menu_ *m, Main_Window *) {
 	Config::auto_load_tileset(!!m->mvalue()->value());
 }
 
+void Main_Window::auto_reload_cb(Fl_Menu_ *m, Main_Window *mw) {
+	Config::auto_reload(!!m->mvalue()->value());
+	mw->update_watched_files();
+}
+
 void Main_Window::print_cb(Fl_Widget *, Main_Window *mw) {
 	if (!mw->_tilemap.size()) { return; }
 
@@ -2306,9 +2777,15 @@ void Main_Window::print_cb(Fl_Widget *, Main_Window *mw) {
 	int w = (int)mw->_tilemap.width() * TILE_SIZE, h = (int)mw->_tilemap.height() * TILE_SIZE;
 	if (mw->_print_options_dialog->copied()) {
 		float scale = fl_override_scale();
+		// The clipboard needs the whole image at once
+		size_t ld = (size_t)w * NUM_CHANNELS;
+		std::vector<uchar> rgb(ld * h);
+		for (size_t row = 0; row < mw->_tilemap.height(); row++) {
+			mw->_tilemap.print_row(row, rgb.data() + row * ld * TILE_SIZE);
+		}
 		Fl_Copy_Surface *surface = new Fl_Copy_Surface(w, h);
 		surface->set_current();
-		mw->_tilemap.print_tilemap();
+		fl_draw_image(rgb.data(), 0, 0, w, h, NUM_CHANNELS);
 		delete surface;
 		Fl_Display_Device::display_device()->set_current();
 		fl_restore_scale(scale);
@@ -2334,15 +2811,7 @@ void Main_Window::print_cb(Fl_Widget *, Main_Window *mw) {
 			return;
 		}
 
-		Fl_Image_Surface *surface = new Fl_Image_Surface(w, h);
-		surface->set_current();
-		mw->_tilemap.print_tilemap();
-		Fl_RGB_Image *img = surface->image();
-		delete surface;
-		Fl_Display_Device::display_device()->set_current();
-
-		Image::Result result = Image::write_image(filename, img);
-		delete img;
+		Image::Result result = mw->_tilemap.print_tilemap(filename);
 		if (result != Image::Result::IMAGE_OK) {
 			std::string msg = "Could not print to ";
 			msg = msg + basename + "!\n\n" + Image::error_message(result);
@@ -2431,6 +2900,8 @@ void Main_Window::exit_cb(Fl_Widget *, Main_Window *mw) {
 	Preferences::set("bold", Config::bold_palettes());
 	Preferences::set("transparent", mw->transparent());
 	Preferences::set("tileset", Config::auto_load_tileset());
+	Preferences::set("reload", Config::auto_reload());
+	Preferences::set("find-flipped", Config::find_flipped());
 	Preferences::set("alpha", (int)mw->_transparency->value());
 	Preferences::set("print-grid", Config::print_grid());
 	Preferences::set("print-rainbow", Config::print_rainbow_tiles());
@@ -2453,16 +2924,14 @@ void Main_Window::exit_cb(Fl_Widget *, Main_Window *mw) {
 
 void Main_Window::undo_cb(Fl_Widget *, Main_Window *mw) {
 	if (!mw->_tilemap.size()) { return; }
-	mw->_tilemap.undo();
+	mw->damage_tiles(mw->_tilemap.undo());
 	mw->update_active_controls();
-	mw->redraw();
 }
 
 void Main_Window::redo_cb(Fl_Widget *, Main_Window *mw) {
 	if (!mw->_tilemap.size()) { return; }
-	mw->_tilemap.redo();
+	mw->damage_tiles(mw->_tilemap.redo());
 	mw->update_active_controls();
-	mw->redraw();
 }
 
 void Main_Window::erase_selection_cb(Fl_Menu_ *, Main_Window *mw) {
@@ -2494,12 +2963,26 @@ void Main_Window::select_all_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->select_all();
 }
 
+void Main_Window::find_block_cb(Fl_Menu_ *, Main_Window *mw) {
+	mw->find_block();
+}
+
+void Main_Window::replace_found_blocks_cb(Fl_Menu_ *, Main_Window *mw) {
+	mw->replace_found_blocks();
+}
+
+void Main_Window::find_flipped_blocks_cb(Fl_Menu_ *m, Main_Window *mw) {
+	Config::find_flipped(!!m->mvalue()->value());
+}
+
 void Main_Window::classic_theme_cb(Fl_Menu_ *, Main_Window *mw) {
 	OS::use_classic_theme();
 	mw->_classic_theme_mi->setonly();
 	mw->update_icons();
 	mw->redraw();
 	mw->_help_window->redraw();
+	mw->_advisor_window->redraw();
+	mw->_minimap_window->redraw();
 }
 
 void Main_Window::aero_theme_cb(Fl_Menu_ *, Main_Window *mw) {
@@ -2508,6 +2991,8 @@ void Main_Window::aero_theme_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->update_icons();
 	mw->redraw();
 	mw->_help_window->redraw();
+	mw->_advisor_window->redraw();
+	mw->_minimap_window->redraw();
 }
 
 void Main_Window::metro_theme_cb(Fl_Menu_ *, Main_Window *mw) {
@@ -2516,6 +3001,8 @@ void Main_Window::metro_theme_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->update_icons();
 	mw->redraw();
 	mw->_help_window->redraw();
+	mw->_advisor_window->redraw();
+	mw->_minimap_window->redraw();
 }
 
 void Main_Window::aqua_theme_cb(Fl_Menu_ *, Main_Window *mw) {
@@ -2524,6 +3011,8 @@ void Main_Window::aqua_theme_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->update_icons();
 	mw->redraw();
 	mw->_help_window->redraw();
+	mw->_advisor_window->redraw();
+	mw->_minimap_window->redraw();
 }
 
 void Main_Window::greybird_theme_cb(Fl_Menu_ *, Main_Window *mw) {
@@ -2532,6 +3021,8 @@ void Main_Window::greybird_theme_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->update_icons();
 	mw->redraw();
 	mw->_help_window->redraw();
+	mw->_advisor_window->redraw();
+	mw->_minimap_window->redraw();
 }
 
 void Main_Window::ocean_theme_cb(Fl_Menu_ *, Main_Window *mw) {
@@ -2540,6 +3031,8 @@ void Main_Window::ocean_theme_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->update_icons();
 	mw->redraw();
 	mw->_help_window->redraw();
+	mw->_advisor_window->redraw();
+	mw->_minimap_window->redraw();
 }
 
 void Main_Window::blue_theme_cb(Fl_Menu_ *, Main_Window *mw) {
@@ -2548,6 +3041,8 @@ void Main_Window::blue_theme_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->update_icons();
 	mw->redraw();
 	mw->_help_window->redraw();
+	mw->_advisor_window->redraw();
+	mw->_minimap_window->redraw();
 }
 
 void Main_Window::olive_theme_cb(Fl_Menu_ *, Main_Window *mw) {
@@ -2556,6 +3051,8 @@ void Main_Window::olive_theme_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->update_icons();
 	mw->redraw();
 	mw->_help_window->redraw();
+	mw->_advisor_window->redraw();
+	mw->_minimap_window->redraw();
 }
 
 void Main_Window::rose_gold_theme_cb(Fl_Menu_ *, Main_Window *mw) {
@@ -2564,6 +3061,8 @@ void Main_Window::rose_gold_theme_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->update_icons();
 	mw->redraw();
 	mw->_help_window->redraw();
+	mw->_advisor_window->redraw();
+	mw->_minimap_window->redraw();
 }
 
 void Main_Window::dark_theme_cb(Fl_Menu_ *, Main_Window *mw) {
@@ -2572,6 +3071,8 @@ void Main_Window::dark_theme_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->update_icons();
 	mw->redraw();
 	mw->_help_window->redraw();
+	mw->_advisor_window->redraw();
+	mw->_minimap_window->redraw();
 }
 
 void Main_Window::brushed_metal_theme_cb(Fl_Menu_ *, Main_Window *mw) {
@@ -2580,6 +3081,8 @@ void Main_Window::brushed_metal_theme_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->update_icons();
 	mw->redraw();
 	mw->_help_window->redraw();
+	mw->_advisor_window->redraw();
+	mw->_minimap_window->redraw();
 }
 
 void Main_Window::high_contrast_theme_cb(Fl_Menu_ *, Main_Window *mw) {
@@ -2588,6 +3091,8 @@ void Main_Window::high_contrast_theme_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->update_icons();
 	mw->redraw();
 	mw->_help_window->redraw();
+	mw->_advisor_window->redraw();
+	mw->_minimap_window->redraw();
 }
 
 void Main_Window::zoom_in_cb(Fl_Widget *, Main_Window *mw) {
@@ -2624,6 +3129,7 @@ void Main_Window::grid_cb(Fl_Menu_ *m, Main_Window *mw) {
 void Main_Window::rainbow_tiles_cb(Fl_Menu_ *m, Main_Window *mw) {
 	Config::rainbow_tiles(!!m->mvalue()->value());
 	mw->_rainbow_tiles_tb->value(Config::rainbow_tiles());
+	mw->update_minimap();
 	mw->redraw();
 }
 
@@ -2644,6 +3150,7 @@ void Main_Window::rainbow_tiles_tb_cb(Toolbar_Button *, Main_Window *mw) {
 	Config::rainbow_tiles(!!mw->_rainbow_tiles_tb->value());
 	if (Config::rainbow_tiles()) { mw->_rainbow_tiles_mi->set(); }
 	else { mw->_rainbow_tiles_mi->clear(); }
+	mw->update_minimap();
 	mw->redraw();
 }
 
@@ -2658,6 +3165,20 @@ void Main_Window::transparent_cb(Fl_Menu_ *, Main_Window *mw) {
 	mw->apply_transparency();
 }
 
+void Main_Window::frame_stats_cb(Fl_Menu_ *m, Main_Window *mw) {
+	Draw_Stats::overlay(!!m->mvalue()->value());
+	mw->redraw();
+}
+
+void Main_Window::log_frame_stats_cb(Fl_Menu_ *m, Main_Window *) {
+	Draw_Stats::logging(!!m->mvalue()->value());
+}
+
+void Main_Window::minimap_cb(Fl_Menu_ *, Main_Window *mw) {
+	mw->_minimap_window->show(mw);
+	mw->update_minimap();
+}
+
 void Main_Window::full_screen_cb(Fl_Menu_ *m, Main_Window *mw) {
 	if (m->mvalue()->value()) {
 		if (!mw->maximize_active()) {
@@ -2808,6 +3329,16 @@ void Main_Window::image_to_tiles_cb(Fl_Widget *, Main_Window *mw) {
 	mw->open_converted_tilemap(result);
 }
 
+void Main_Window::compression_advisor_cb(Fl_Widget *, Main_Window *mw) {
+	bool running = mw->_advisor_window->visible();
+	mw->update_compression_subjects(false);
+	mw->_advisor_window->update(mw->_compression_subjects);
+	mw->_advisor_window->show(mw);
+	if (!running) {
+		Fl::add_timeout(ADVISOR_UPDATE_DELAY, (Fl_Timeout_Handler)update_advisor_cb, mw);
+	}
+}
+
 void Main_Window::help_cb(Fl_Widget *, Main_Window *mw) {
 	mw->_help_window->show(mw);
 }
@@ -2823,6 +3354,7 @@ void Main_Window::tilemap_width_tb_cb(OS_Spinner *, Main_Window *mw) {
 		mw->select_tile(mw->_selection.id());
 	}
 	mw->_tilemap.width(w);
+	mw->clear_found_blocks();
 	int sx = mw->_tilemap_scroll->x() + Fl::box_dx(mw->_tilemap_scroll->box());
 	int sy = mw->_tilemap_scroll->y() + Fl::box_dy(mw->_tilemap_scroll->box());
 	mw->_tilemap_scroll->init_sizes();
@@ -2832,6 +3364,7 @@ void Main_Window::tilemap_width_tb_cb(OS_Spinner *, Main_Window *mw) {
 	mw->_tilemap_scroll->scroll_to(0, 0);
 	mw->_tilemap.reposition_tiles(sx, sy);
 	mw->_tilemap_scroll->redraw();
+	mw->update_minimap();
 	if (mw->_tilemap.is_rectangular()) {
 		mw->_shift_mi->activate();
 		mw->_shift_tb->activate();
@@ -2876,14 +3409,14 @@ void Main_Window::change_tab_cb(OS_Tabs *, Main_Window *mw) {
 	mw->redraw();
 }
 
-void Main_Window::select_tile_cb(Tile_Button *tb, Main_Window *mw) {
+void Main_Window::select_tile_cb(Tile_Picker *tp, Main_Window *mw) {
 	if (Fl::event_button() == FL_LEFT_MOUSE) {
 		// Left-click to select
-		mw->select_tile(tb->id());
+		mw->select_tile(tp->target());
 	}
 	else if (Fl::event_button() == FL_RIGHT_MOUSE) {
 		// Right-click to highlight
-		mw->highlight_tile(tb->id());
+		mw->highlight_tile(tp->target());
 	}
 }
 
@@ -2905,17 +3438,14 @@ void Main_Window::change_tile_cb(Tile_Tessera *tt, Main_Window *mw) {
 		if (Fl::event_shift()) {
 			// Shift+left-click to flood fill
 			mw->flood_fill(tt);
-			mw->_tilemap_scroll->redraw();
 		}
 		else if (Fl::event_ctrl()) {
 			// Ctrl+left-click to replace
 			mw->substitute_tile(tt);
-			mw->_tilemap_scroll->redraw();
 		}
 		else if (Fl::event_alt()) {
 			// Alt+click to swap
 			mw->swap_tiles(tt);
-			mw->_tilemap_scroll->redraw();
 		}
 		else {
 			// Left-click/drag to edit
@@ -2947,6 +3477,40 @@ void Main_Window::change_tile_cb(Tile_Tessera *tt, Main_Window *mw) {
 			}
 			mw->select_tile(tt->id());
 		}
-		tt->redraw();
+		mw->damage_tile(tt);
+	}
+}
+
+void Main_Window::tilemap_view_cb(Tilemap_Workspace *tw, Main_Window *mw) {
+	double x, y, w, h;
+	tw->view(x, y, w, h);
+	mw->_minimap_window->view(x, y, w, h);
+}
+
+void Main_Window::minimap_navigate_cb(Minimap *, Main_Window *mw) {
+	if (!mw->_tilemap.size()) { return; }
+	mw->_tilemap_scroll->center_on(mw->_minimap_window->target_x(), mw->_minimap_window->target_y());
+}
+
+void Main_Window::update_advisor_cb(Main_Window *mw) {
+	// Stop polling once the advisor is closed; reopening it restarts the timer
+	if (!mw->_advisor_window->visible()) { return; }
+	// Only compare subjects with the advisor's after they change; otherwise just collect finished estimates
+	if (mw->update_compression_subjects(true)) {
+		mw->_advisor_window->update(mw->_compression_subjects);
+	}
+	else {
+		mw->_advisor_window->poll();
+	}
+	Fl::repeat_timeout(ADVISOR_UPDATE_DELAY, (Fl_Timeout_Handler)update_advisor_cb, mw);
+}
+
+void Main_Window::files_changed_cb(const std::vector<std::string> &filenames, Main_Window *mw) {
+	bool tilemap_changed = false, tilesets_changed = false;
+	for (const std::string &f : filenames) {
+		if (f == mw->_tilemap_file || f == mw->_attrmap_file) { tilemap_changed = true; }
+		if (std::find(RANGE(mw->_tileset_files), f) != mw->_tileset_files.end()) { tilesets_changed = true; }
 	}
+	if (tilemap_changed) { mw->reload_tilemap(); }
+	if (tilesets_changed) { reload_tilesets_cb(NULL, mw); }
 }
@@ -21,12 +21,20 @@
 #include "modal-dialog.h"
 #include "option-dialogs.h"
 #include "help-window.h"
+#include "advisor-window.h"
+#include "minimap-window.h"
+#include "compositor.h"
+#include "image-to-tiles.h"
+#include "file-watcher.h"
+#include "block-search.h"
 
 #define NEW_TILEMAP_NAME "New Tilemap"
 #define IMPORTED_TILEMAP_NAME "Imported Tilemap"
 
 #define NUM_RECENT 10
 
+#define ADVISOR_UPDATE_DELAY 0.5
+
 struct Image_to_Tiles_Result {
 	const char *tilemap_filename;
 	const char *attrmap_filename;
@@ -37,6 +45,30 @@ struct Image_to_Tiles_Result {
 	bool success;
 };
 
+// What a compression advisor subject was made from: the tilemap's revision and format,
+// or a tileset file's modification time and size
+struct Subject_Source {
+	std::string name;
+	int64_t stamp;
+	size_t size;
+	inline bool operator==(const Subject_Source &other) const {
+		return name == other.name && stamp == other.stamp && size == other.size;
+	}
+};
+
+// What the minimap's tile colors come from: a tileset file's modification time and size, and where it was placed
+struct Minimap_Source {
+	std::string name;
+	int64_t stamp;
+	size_t size;
+	int start_id, offset, length;
+	Tile_Layout layout;
+	inline bool operator==(const Minimap_Source &other) const {
+		return name == other.name && stamp == other.stamp && size == other.size && start_id == other.start_id &&
+			offset == other.offset && length == other.length && layout == other.layout;
+	}
+};
+
 class Main_Window : public Fl_Overlay_Window {
 private:
 	// GUI containers
@@ -48,7 +80,7 @@ private:
 	OS_Tab *_tiles_tab, *_palettes_tab;
 	Workspace *_tiles_scroll;
 	Workpane *_palettes_pane;
-	Workspace *_tilemap_scroll;
+	Tilemap_Workspace *_tilemap_scroll;
 	Toolbar *_status_bar;
 	// GUI inputs
 	DnD_Receiver *_tilemap_dnd_receiver, *_tileset_dnd_receiver;
@@ -66,19 +98,20 @@ private:
 	Toolbar_Button *_tileset_width_tb, *_shift_tileset_tb;
 	Toolbar_Button *_image_to_tiles_tb;
 	Toolbar_Toggle_Button *_x_flip_tb, *_y_flip_tb, *_priority_tb, *_obp1_tb;
-	Tile_Button *_tile_buttons[MAX_NUM_TILES];
+	Tile_Picker *_tile_picker;
 	Palette_Button *_palette_buttons[MAX_NUM_PALETTES];
 	Default_Slider *_transparency;
 	// GUI outputs
 	Label *_width_heading, *_tileset_name, *_tilemap_name, *_tile_heading;
 	Tile_Swatch *_current_tile, *_current_attributes;
-	Label *_tilemap_dimensions, *_tilemap_format, *_zoom_level, *_hover_id, *_hover_xy, *_hover_landmark;
+	Label *_tilemap_dimensions, *_tilemap_format, *_zoom_level, *_hover_id, *_hover_xy, *_hover_landmark, *_found_count;
 	// Conditional menu items
 	Fl_Menu_Item *_close_mi = NULL, *_save_mi = NULL, *_save_as_mi = NULL, *_export_mi = NULL, *_print_mi = NULL;
 	Fl_Menu_Item *_reload_tilesets_mi = NULL, *_unload_tilesets_mi = NULL;
 	Fl_Menu_Item *_undo_mi = NULL, *_redo_mi = NULL;
 	Fl_Menu_Item *_erase_selection_mi = NULL, *_x_flip_selection_mi = NULL, *_y_flip_selection_mi = NULL,
 		*_shift_selected_ids_mi = NULL, *_copy_selection_mi = NULL, *_select_all_mi = NULL;
+	Fl_Menu_Item *_find_block_mi = NULL, *_replace_found_blocks_mi = NULL;
 	Fl_Menu_Item *_zoom_in_mi = NULL, *_zoom_out_mi = NULL;
 	Fl_Menu_Item *_tilemap_width_mi = NULL, *_crop_to_selection_mi = NULL, *_resize_mi = NULL, *_shift_mi = NULL,
 		*_transpose_mi = NULL, *_shift_tile_ids_mi = NULL, *_reformat_mi = NULL;
@@ -98,14 +131,30 @@ private:
 	Add_Tileset_Dialog *_add_tileset_dialog;
 	Image_To_Tiles_Dialog *_image_to_tiles_dialog;
 	Help_Window *_help_window;
+	Advisor_Window *_advisor_window;
+	Minimap_Window *_minimap_window;
 	// Data
 	std::string _tilemap_file, _attrmap_file, _tilemap_basename;
 	std::vector<std::string> _tileset_files;
 	std::string _recent_tilemaps[NUM_RECENT], _recent_tilesets[NUM_RECENT];
 	Tilemap _tilemap;
 	std::vector<Tileset> _tilesets;
+	File_Watcher _file_watcher;
+	// Made again only when their sources change, since the advisor polls for them while it is open
+	std::vector<Compression_Subject> _compression_subjects;
+	std::vector<Subject_Source> _compression_sources;
+	// What the minimap was last rebuilt from, so refreshing the tileset metadata only rebuilds it after a change
+	std::vector<Minimap_Source> _minimap_sources;
+	size_t _minimap_width = 0, _minimap_size = 0;
+	// The tilemap revision the advisor last polled, so that edits only re-encode the tilemap once they pause
+	size_t _advisor_revision = 0;
 	int _tileset_width = 16;
 	Tile_Selection _selection;
+	// Kept between flood fills, so filling a large tilemap does not allocate it every time
+	std::vector<bool> _fill_visited;
+	// Where Find Block found the selected block, until the tilemap changes; each match's block index is its flips
+	std::vector<Block_Match> _found_blocks;
+	size_t _found_width = 0, _found_height = 0;
 	Palette_Button *_selected_palette = NULL;
 	// Work properties
 	bool _map_editable = false;
@@ -137,6 +186,7 @@ public:
 	inline bool map_editable(void) const { return _map_editable; }
 	inline void map_editable(bool e) { _map_editable = e; }
 	inline bool dropping(void) const { return _tilemap_scroll->dropping() || _tiles_scroll->dropping() || _palettes_pane->dropping(); }
+	void draw(void);
 	void draw_overlay(void);
 	int handle(int event);
 	void clear_flips(void);
@@ -145,6 +195,9 @@ public:
 	void update_selection_status(void);
 	void update_selection_controls(void);
 	void update_status(Tile_Tessera *tt);
+	void damage_tiles(const Tile_Rect &r);
+	// Repaints one tile without updating the minimap
+	void damage_tile(const Tile_Tessera *tt);
 	void edit_tile(Tile_Tessera *tt);
 	void flood_fill(Tile_Tessera *tt);
 	void substitute_tile(Tile_Tessera *tt);
@@ -155,16 +208,20 @@ public:
 	void shift_selected_ids(int d, int n);
 	void copy_selection(void) const;
 	void select_all(void);
+	void find_block(void);
+	void replace_found_blocks(void);
+	void clear_found_blocks(void);
 	void new_tilemap(size_t width, size_t height);
 	void open_tilemap(const char *filename);
 	void open_recent_tilemap(int n);
 	inline void load_tileset(const char *filename, bool warn = false) {
-		unload_tilesets_cb(NULL, this); add_tileset(filename, 0x000, 0, 0, warn);
+		unload_tilesets_cb(NULL, this); add_tileset(filename, 0x000, 0, 0, Tile_Layout::LINEAR, warn);
 	}
 	inline void unload_tilesets(void) {
 		for (Tileset &t : _tilesets) { t.clear(); } _tilesets.clear(); _tileset_files.clear(); update_tileset_metadata();
 	}
-	void add_tileset(const char *filename, int start = 0x000, int offset = 0, int length = 0, bool quiet = false);
+	void add_tileset(const char *filename, int start = 0x000, int offset = 0, int length = 0,
+		Tile_Layout layout = Tile_Layout::LINEAR, bool quiet = false);
 	void load_recent_tileset(int n);
 	void load_corresponding_tileset(const char *filename = NULL);
 	void open_converted_tilemap(Image_to_Tiles_Result output);
@@ -178,6 +235,8 @@ private:
 	void update_tileset_metadata(void);
 	void update_active_controls(void);
 	void update_tileset_width(int tw);
+	void update_minimap(void);
+	void update_watched_files(void);
 	void resize_tilemap(size_t w, size_t h, int px, int py);
 	void shift_tilemap(void);
 	void shift_tileset(void);
@@ -186,12 +245,14 @@ private:
 	void reformat_tilemap(void);
 	void save_tilemap(bool force);
 	void import_tilemap(const char *filename);
+	void reload_tilemap(void);
 	void setup_tilemap(const char *basename, int old_tileset_size, const char *tileset_filename = NULL);
 	void export_tilemap(const char *filename);
 	void select_tile(uint16_t id);
 	void highlight_tile(uint16_t id);
 	void select_palette(int palette);
 	Image_to_Tiles_Result image_to_tiles(void);
+	bool update_compression_subjects(bool wait_for_edits);
 private:
 	// Drag-and-drop
 	static void drag_and_drop_tilemap_cb(DnD_Receiver *dndr, Main_Window *mw);
@@ -217,6 +278,7 @@ private:
 	static void clear_recent_tilesets_cb(Fl_Menu_ *m, Main_Window *mw);
 	static void unload_tilesets_cb(Fl_Widget *w, Main_Window *mw);
 	static void auto_load_tileset_cb(Fl_Menu_ *m, Main_Window *mw);
+	static void auto_reload_cb(Fl_Menu_ *m, Main_Window *mw);
 	// Edit menu
 	static void undo_cb(Fl_Widget *w, Main_Window *mw);
 	static void redo_cb(Fl_Widget *w, Main_Window *mw);
@@ -226,6 +288,9 @@ private:
 	static void shift_selected_ids_cb(Fl_Menu_ *w, Main_Window *mw);
 	static void copy_selection_cb(Fl_Menu_ *w, Main_Window *mw);
 	static void select_all_cb(Fl_Menu_ *w, Main_Window *mw);
+	static void find_block_cb(Fl_Menu_ *w, Main_Window *mw);
+	static void replace_found_blocks_cb(Fl_Menu_ *w, Main_Window *mw);
+	static void find_flipped_blocks_cb(Fl_Menu_ *m, Main_Window *mw);
 	// View menu
 	static void classic_theme_cb(Fl_Menu_ *m, Main_Window *mw);
 	static void aero_theme_cb(Fl_Menu_ *m, Main_Window *mw);
@@ -246,6 +311,9 @@ private:
 	static void rainbow_tiles_cb(Fl_Menu_ *m, Main_Window *mw);
 	static void bold_palettes_cb(Fl_Menu_ *m, Main_Window *mw);
 	static void transparent_cb(Fl_Menu_ *m, Main_Window *mw);
+	static void frame_stats_cb(Fl_Menu_ *m, Main_Window *mw);
+	static void log_frame_stats_cb(Fl_Menu_ *m, Main_Window *mw);
+	static void minimap_cb(Fl_Menu_ *m, Main_Window *mw);
 	// Tools menu
 	static void tilemap_width_cb(Fl_Menu_ *m, Main_Window *mw);
 	static void crop_to_selection_cb(Fl_Menu_ *m, Main_Window *mw);
@@ -257,6 +325,7 @@ private:
 	static void tileset_width_cb(Fl_Widget *w, Main_Window *mw);
 	static void shift_tileset_cb(Fl_Widget *w, Main_Window *mw);
 	static void image_to_tiles_cb(Fl_Widget *w, Main_Window *mw);
+	static void compression_advisor_cb(Fl_Widget *w, Main_Window *mw);
 	// Help menu
 	static void help_cb(Fl_Widget *w, Main_Window *mw);
 	static void about_cb(Fl_Widget *w, Main_Window *mw);
@@ -273,10 +342,17 @@ private:
 	static void transparency_cb(Default_Slider *ds, Main_Window *mw);
 	// Tileset
 	static void change_tab_cb(OS_Tabs *ts, Main_Window *mw);
-	static void select_tile_cb(Tile_Button *tb, Main_Window *mw);
+	static void select_tile_cb(Tile_Picker *tp, Main_Window *mw);
 	static void select_palette_cb(Palette_Button *pb, Main_Window *mw);
 	// Tilemap
 	static void change_tile_cb(Tile_Tessera *tt, Main_Window *mw);
+	static void tilemap_view_cb(Tilemap_Workspace *tw, Main_Window *mw);
+	// Minimap
+	static void minimap_navigate_cb(Minimap *mm, Main_Window *mw);
+	// Compression advisor
+	static void update_advisor_cb(Main_Window *mw);
+	// File watcher
+	static void files_changed_cb(const std::vector<std::string> &filenames, Main_Window *mw);
 };
 
 #endif
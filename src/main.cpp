@@ -10,6 +10,7 @@
 #include "preferences.h"
 #include "themes.h"
 #include "main-window.h"
+#include "cli.h"
 
 #ifdef _WIN32
 
@@ -63,6 +64,9 @@ static void use_theme(OS::Theme theme) {
 }
 
 int main(int argc, char **argv) {
+	int status = run_command_line(argc, argv);
+	if (status != -1) { return status; }
+
 	Preferences::initialize(argv[0]);
 	std::ios::sync_with_stdio(false);
 #ifdef _WIN32
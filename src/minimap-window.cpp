@@ -0,0 +1,66 @@
+#pragma warning(push, 0)
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Group.H>
+#pragma warning(pop)
+
+#include "themes.h"
+#include "minimap-window.h"
+
+Minimap_Window::Minimap_Window(int x, int y, int w, int h, const char *t) : _dx(x), _dy(y), _width(w), _height(h),
+	_title(t), _window(NULL), _minimap(NULL), _navigate_cb(NULL), _navigate_data(NULL) {}
+
+Minimap_Window::~Minimap_Window() {
+	// The window owns the minimap
+	delete _window;
+}
+
+void Minimap_Window::rebuild(const Tilemap &tilemap) {
+	if (!visible()) { return; }
+	_minimap->rebuild(tilemap);
+}
+
+void Minimap_Window::update(const Tilemap &tilemap, const Tile_Rect &r) {
+	if (!visible()) { return; }
+	_minimap->update(tilemap, r);
+}
+
+void Minimap_Window::view(double x, double y, double w, double h) {
+	if (!visible()) { return; }
+	_minimap->view(x, y, w, h);
+}
+
+void Minimap_Window::initialize() {
+	if (_window) { return; }
+	Fl_Group *prev_current = Fl_Group::current();
+	Fl_Group::current(NULL);
+	// Populate window
+	_window = new Fl_Double_Window(_dx, _dy, _width, _height, _title);
+	_minimap = new Minimap(10, 10, _width-20, _height-20);
+	_window->end();
+	// Initialize window
+	_window->box(OS_BG_BOX);
+	_window->resizable(_minimap);
+	_window->size_range(64, 64);
+	// Initialize window's children
+	_minimap->callback(_navigate_cb, _navigate_data);
+	_minimap->when(FL_WHEN_CHANGED);
+	Fl_Group::current(prev_current);
+}
+
+void Minimap_Window::show(const Fl_Widget *p) {
+	bool was_initialized = !!_window;
+	initialize();
+	Fl_Window *prev_grab = Fl::grab();
+	if (!was_initialized) {
+		_window->position(p->x() + p->w() - _width - _dx, p->y() + _dy);
+	}
+	Fl::grab(NULL);
+	_window->show();
+	Fl::grab(prev_grab);
+}
+
+void Minimap_Window::redraw() {
+	if (!_window) { return; }
+	_window->redraw();
+}
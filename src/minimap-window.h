@@ -0,0 +1,35 @@
+#ifndef MINIMAP_WINDOW_H
+#define MINIMAP_WINDOW_H
+
+#pragma warning(push, 0)
+#include <FL/Fl_Double_Window.H>
+#pragma warning(pop)
+
+#include "minimap.h"
+
+class Minimap_Window {
+private:
+	int _dx, _dy, _width, _height;
+	const char *_title;
+	Fl_Double_Window *_window;
+	Minimap *_minimap;
+	Fl_Callback *_navigate_cb;
+	void *_navigate_data;
+public:
+	Minimap_Window(int x, int y, int w, int h, const char *t = NULL);
+	~Minimap_Window();
+	inline bool visible(void) const { return _window && _window->visible(); }
+	inline void navigate_callback(Fl_Callback *cb, void *data) { _navigate_cb = cb; _navigate_data = data; }
+	inline double target_x(void) const { return _minimap ? _minimap->target_x() : 0.0; }
+	inline double target_y(void) const { return _minimap ? _minimap->target_y() : 0.0; }
+	void rebuild(const Tilemap &tilemap);
+	void update(const Tilemap &tilemap, const Tile_Rect &r);
+	void view(double x, double y, double w, double h);
+private:
+	void initialize(void);
+public:
+	void show(const Fl_Widget *p);
+	void redraw(void);
+};
+
+#endif
@@ -0,0 +1,129 @@
+#pragma warning(push, 0)
+#include <FL/Fl.H>
+#include <FL/fl_draw.H>
+#pragma warning(pop)
+
+#include "themes.h"
+#include "tilemap.h"
+#include "tile-buttons.h"
+#include "minimap.h"
+
+// Don't blow up tiny tilemaps past this many pixels per tile
+#define MAX_MINIMAP_SCALE 8.0
+
+Minimap::Minimap(int x, int y, int w, int h, const char *l) : Fl_Widget(x, y, w, h, l), _pixels(), _map_w(0), _map_h(0),
+	_tile_colors(), _known_colors(), _view_x(0.0), _view_y(0.0), _view_w(0.0), _view_h(0.0), _target_x(0.0), _target_y(0.0) {
+	box(OS_SPACER_THIN_DOWN_BOX);
+	color(FL_INACTIVE_COLOR);
+	labeltype(FL_NO_LABEL);
+}
+
+void Minimap::rebuild(const Tilemap &tilemap) {
+	// Tilesets or their colors may have changed too
+	std::fill(RANGE(_known_colors), false);
+	_map_w = tilemap.width();
+	_map_h = tilemap.height();
+	_pixels.assign(_map_w * _map_h * 3, 0x00);
+	for (size_t y = 0; y < _map_h; y++) {
+		for (size_t x = 0; x < _map_w; x++) {
+			paint(tilemap, x, y);
+		}
+	}
+	redraw();
+}
+
+void Minimap::update(const Tilemap &tilemap, const Tile_Rect &r) {
+	if (r.empty()) { return; }
+	if (tilemap.width() != _map_w || tilemap.height() != _map_h) {
+		rebuild(tilemap);
+		return;
+	}
+	size_t right = std::min(r.right, _map_w), bottom = std::min(r.bottom, _map_h);
+	for (size_t y = r.top; y < bottom; y++) {
+		for (size_t x = r.left; x < right; x++) {
+			paint(tilemap, x, y);
+		}
+	}
+	double s = scale();
+	int X = x() + Fl::box_dx(box()), Y = y() + Fl::box_dy(box());
+	int dx = (int)(r.left * s), dy = (int)(r.top * s);
+	damage(FL_DAMAGE_ALL, X + dx, Y + dy, (int)ceil(right * s) - dx + 1, (int)ceil(bottom * s) - dy + 1);
+}
+
+void Minimap::view(double x, double y, double w, double h) {
+	if (x == _view_x && y == _view_y && w == _view_w && h == _view_h) { return; }
+	_view_x = x; _view_y = y; _view_w = w; _view_h = h;
+	redraw();
+}
+
+double Minimap::scale() const {
+	if (!_map_w || !_map_h) { return 1.0; }
+	int W = w() - Fl::box_dw(box()), H = h() - Fl::box_dh(box());
+	return std::min(std::min((double)W / _map_w, (double)H / _map_h), MAX_MINIMAP_SCALE);
+}
+
+void Minimap::paint(const Tilemap &tilemap, size_t x, size_t y) {
+	const Tile_Tessera *tt = tilemap.tile(x, y);
+	uchar *p = _pixels.data() + (y * _map_w + x) * 3;
+	if (!tt) {
+		// Past the end of a non-rectangular tilemap
+		Fl::get_color(color(), p[0], p[1], p[2]);
+		return;
+	}
+	uint16_t id = tt->id();
+	if (id >= MAX_NUM_TILES) { id = 0; }
+	if (!_known_colors[id]) {
+		_tile_colors[id] = tt->state().average_color();
+		_known_colors[id] = true;
+	}
+	Fl::get_color(_tile_colors[id], p[0], p[1], p[2]);
+}
+
+void Minimap::draw_row_cb(Minimap *mm, int x, int y, int w, uchar *buffer) {
+	// Nearest-neighbor sampling, so drawing costs the same however large the tilemap is
+	double s = mm->scale();
+	size_t ty = std::min((size_t)(y / s), mm->_map_h - 1);
+	const uchar *row = mm->_pixels.data() + ty * mm->_map_w * 3;
+	for (int i = 0; i < w; i++) {
+		size_t tx = std::min((size_t)((x + i) / s), mm->_map_w - 1);
+		const uchar *p = row + tx * 3;
+		buffer[i*3] = p[0]; buffer[i*3+1] = p[1]; buffer[i*3+2] = p[2];
+	}
+}
+
+void Minimap::draw() {
+	draw_box();
+	if (!_map_w || !_map_h) { return; }
+	int X = x() + Fl::box_dx(box()), Y = y() + Fl::box_dy(box());
+	int W = w() - Fl::box_dw(box()), H = h() - Fl::box_dh(box());
+	double s = scale();
+	int dw = std::min(std::max((int)(_map_w * s), 1), W), dh = std::min(std::max((int)(_map_h * s), 1), H);
+	fl_push_clip(X, Y, W, H);
+	fl_draw_image((Fl_Draw_Image_Cb)draw_row_cb, this, X, Y, dw, dh, 3);
+	if (_view_w > 0.0 && _view_h > 0.0) {
+		int vx = X + (int)(_view_x * s), vy = Y + (int)(_view_y * s);
+		int vw = std::max((int)(_view_w * s), 3), vh = std::max((int)(_view_h * s), 3);
+		fl_rect(vx, vy, vw, vh, FL_BLACK);
+		fl_rect(vx+1, vy+1, vw-2, vh-2, FL_WHITE);
+	}
+	fl_pop_clip();
+}
+
+int Minimap::handle(int event) {
+	switch (event) {
+	case FL_PUSH:
+	case FL_DRAG:
+		if (!_map_w || !_map_h || Fl::event_button() != FL_LEFT_MOUSE) { break; }
+		{
+			double s = scale();
+			int X = x() + Fl::box_dx(box()), Y = y() + Fl::box_dy(box());
+			_target_x = std::clamp((Fl::event_x() - X) / s, 0.0, (double)_map_w);
+			_target_y = std::clamp((Fl::event_y() - Y) / s, 0.0, (double)_map_h);
+		}
+		do_callback();
+		return 1;
+	case FL_RELEASE:
+		return 1;
+	}
+	return Fl_Widget::handle(event);
+}
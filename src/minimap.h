@@ -0,0 +1,42 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include <vector>
+
+#pragma warning(push, 0)
+#include <FL/Fl_Widget.H>
+#pragma warning(pop)
+
+#include "utils.h"
+#include "tileset.h"
+
+class Tilemap;
+struct Tile_Rect;
+
+// An overview of the whole tilemap with one pixel per tile, scaled to fit. Edits repaint only the pixels
+// of the tiles that changed, so it stays cheap for very large tilemaps.
+class Minimap : public Fl_Widget {
+private:
+	std::vector<uchar> _pixels;
+	size_t _map_w, _map_h;
+	Fl_Color _tile_colors[MAX_NUM_TILES];
+	bool _known_colors[MAX_NUM_TILES];
+	double _view_x, _view_y, _view_w, _view_h;
+	double _target_x, _target_y;
+public:
+	Minimap(int x, int y, int w, int h, const char *l = NULL);
+	inline double target_x(void) const { return _target_x; }
+	inline double target_y(void) const { return _target_y; }
+	void rebuild(const Tilemap &tilemap);
+	void update(const Tilemap &tilemap, const Tile_Rect &r);
+	void view(double x, double y, double w, double h);
+private:
+	double scale(void) const;
+	void paint(const Tilemap &tilemap, size_t x, size_t y);
+	static void draw_row_cb(Minimap *mm, int x, int y, int w, uchar *buffer);
+protected:
+	void draw(void);
+	int handle(int event);
+};
+
+#endif
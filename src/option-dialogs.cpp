@@ -17,6 +17,15 @@
 #include "icons.h"
 #include "image.h"
 #include "tile.h"
+#include "image-to-tiles.h"
+
+int format_max_name_width() {
+	int mw = 0;
+	for (int i = 0; i < NUM_FORMATS; i++) {
+		mw = std::max(mw, text_width(format_name((Tilemap_Format)i), 6));
+	}
+	return mw;
+}
 
 Option_Dialog::Option_Dialog(int w, const char *t) : _width(w), _title(t), _canceled(false),
 	_dialog(NULL), _content(NULL), _ok_button(NULL), _cancel_button(NULL) {}
@@ -704,14 +713,15 @@ int Group_Width_Dialog::refresh_content(int ww, int dy) {
 	return wgt_h;
 }
 
-Add_Tileset_Dialog::Add_Tileset_Dialog(const char *t) : Option_Dialog(270, t), _tileset_header(NULL), _start_id(NULL),
-	_offset(NULL), _length(NULL) {}
+Add_Tileset_Dialog::Add_Tileset_Dialog(const char *t) : Option_Dialog(320, t), _tileset_header(NULL), _start_id(NULL),
+	_offset(NULL), _length(NULL), _layout(NULL) {}
 
 Add_Tileset_Dialog::~Add_Tileset_Dialog() {
 	delete _tileset_header;
 	delete _start_id;
 	delete _offset;
 	delete _length;
+	delete _layout;
 }
 
 void Add_Tileset_Dialog::limit_tileset_options(const char *filename) {
@@ -721,6 +731,14 @@ void Add_Tileset_Dialog::limit_tileset_options(const char *filename) {
 	strcpy(buffer, name);
 	strcat(buffer, ":");
 	_tileset_header->copy_label(buffer);
+	// Only .4bpp and .8bpp tile data can be laid out more than one way
+	if (Tileset::tile_data_bpp(filename) >= 4) {
+		_layout->activate();
+	}
+	else {
+		_layout->value(0);
+		_layout->deactivate();
+	}
 }
 
 void Add_Tileset_Dialog::initialize_content() {
@@ -729,6 +747,7 @@ void Add_Tileset_Dialog::initialize_content() {
 	_start_id = new Default_Hex_Spinner(0, 0, 0, 0, "Start at ID: $");
 	_offset = new Default_Hex_Spinner(0, 0, 0, 0, "Offset: $");
 	_length = new Default_Hex_Spinner(0, 0, 0, 0, "Length: $");
+	_layout = new Dropdown(0, 0, 0, 0, "Layout:");
 	// Initialize content group's children
 	_start_id->format("%03X");
 	_start_id->range(0x00, MAX_NUM_TILES-1);
@@ -741,11 +760,15 @@ void Add_Tileset_Dialog::initialize_content() {
 	_length->format("%X");
 	_length->range(0x0, 0x400);
 	_length->default_value(0x0);
+	for (int i = 0; i < NUM_TILE_LAYOUTS; i++) {
+		_layout->add(tile_layout_name((Tile_Layout)i));
+	}
+	_layout->value(0);
 }
 
 int Add_Tileset_Dialog::refresh_content(int ww, int dy) {
 	int wgt_h = 22, win_m = 10, wgt_m = 4;
-	int ch = (wgt_h + wgt_m) * 2 + wgt_h;
+	int ch = (wgt_h + wgt_m) * 3 + wgt_h;
 	_content->resize(win_m, dy, ww, ch);
 
 	_tileset_header->resize(win_m, dy, ww, wgt_h);
@@ -758,6 +781,9 @@ int Add_Tileset_Dialog::refresh_content(int ww, int dy) {
 	_offset->resize(wgt_off, dy, wgt_w, wgt_h);
 	wgt_off = _offset->x() + _offset->w() + win_m + text_width(_length->label(), 3);
 	_length->resize(wgt_off, dy, wgt_w, wgt_h);
+	dy += wgt_h + wgt_m;
+	wgt_off = win_m + text_width(_layout->label(), 2);
+	_layout->resize(wgt_off, dy, ww - wgt_off + win_m, wgt_h);
 
 	return ch;
 }
@@ -803,25 +829,7 @@ Image_To_Tiles_Dialog::~Image_To_Tiles_Dialog() {
 }
 
 Fl_Color Image_To_Tiles_Dialog::fl_color_zero() const {
-	const char *s = _color_zero_rgb->value();
-	char rgb[7] = {};
-	if (size_t n = strlen(s); n < 6) {
-		memset(rgb, '0', 6 - n);
-	}
-	strncat(rgb, s, 6);
-
-	char buffer[3] = {};
-	buffer[0] = rgb[0];
-	buffer[1] = rgb[1];
-	uchar r = (uchar)strtoul(buffer, NULL, 16);
-	buffer[0] = rgb[2];
-	buffer[1] = rgb[3];
-	uchar g = (uchar)strtoul(buffer, NULL, 16);
-	buffer[0] = rgb[4];
-	buffer[1] = rgb[5];
-	uchar b = (uchar)strtoul(buffer, NULL, 16);
-
-	return fl_rgb_color(NORMRGB(r), NORMRGB(g), NORMRGB(b));
+	return color_zero_from_hex(_color_zero_rgb->value());
 }
 
 void Image_To_Tiles_Dialog::update_image_name() {
@@ -846,25 +854,14 @@ void Image_To_Tiles_Dialog::update_output_names() {
 	else {
 		_tileset_name->copy_label(fl_filename_name(tileset_filename()));
 
-		char output_filename[FL_PATH_MAX] = {};
-		strcpy(output_filename, tileset_filename());
-		fl_filename_setext(output_filename, sizeof(output_filename), format_extension(format()));
-		_tilemap_filename = output_filename;
-
-		strcpy(output_filename, tileset_filename());
-		fl_filename_setext(output_filename, sizeof(output_filename), ATTRMAP_EXT);
-		_attrmap_filename = output_filename;
-
-		strcpy(output_filename, tileset_filename());
-		const char *palette_ext = palette_extension(palette_format());
-		if (palette_ext) {
-			fl_filename_setext(output_filename, sizeof(output_filename), palette_ext);
-		}
-		_palette_filename = output_filename;
-
-		strcpy(output_filename, tileset_filename());
-		fl_filename_setext(output_filename, sizeof(output_filename), TILEPAL_EXT);
-		_tilepal_filename = output_filename;
+		Image_to_Tiles_Options opts;
+		opts.fmt = format();
+		opts.pal_fmt = palette_format();
+		opts.output_filenames(tileset_filename());
+		_tilemap_filename = opts.tilemap_filename;
+		_attrmap_filename = opts.attrmap_filename;
+		_palette_filename = opts.palette_filename;
+		_tilepal_filename = opts.tilepal_filename;
 
 		char tilemap_name[FL_PATH_MAX] = {};
 		strcpy(tilemap_name, "Output: ");
@@ -1029,7 +1026,10 @@ void Image_To_Tiles_Dialog::initialize_content() {
 	_image_chooser->title("Read Image");
 	_image_chooser->filter("Image Files\t*.{png,gif,bmp}\n");
 	_tileset_chooser->title("Write Tileset");
-	_tileset_chooser->filter("PNG Files\t*.png\nBMP Files\t*.bmp\n");
+	_tileset_chooser->filter("PNG Files\t*.png\nBMP Files\t*.bmp\n"
+		"1BPP Tiles\t*.1bpp\n2BPP Tiles\t*.2bpp\n4BPP Tiles\t*.4bpp\n8BPP Tiles\t*.8bpp\n"
+		"LZ-Compressed 1BPP Tiles\t*.1bpp.lz\nLZ-Compressed 2BPP Tiles\t*.2bpp.lz\n"
+		"LZ-Compressed 4BPP Tiles\t*.4bpp.lz\nLZ-Compressed 8BPP Tiles\t*.8bpp.lz\n");
 	_tileset_chooser->options(Fl_Native_File_Chooser::Option::SAVEAS_CONFIRM);
 }
 
@@ -1171,7 +1171,10 @@ void Image_To_Tiles_Dialog::tileset_cb(Fl_Widget *, Image_To_Tiles_Dialog *itd)
 	}
 	else {
 		char filename[FL_PATH_MAX] = {};
-		const char *default_ext = itd->_tileset_chooser->filter_value() == 1 ? ".bmp" : ".png";
+		static const char *tileset_exts[] = {".png", ".bmp", ".1bpp", ".2bpp", ".4bpp", ".8bpp",
+			".1bpp.lz", ".2bpp.lz", ".4bpp.lz", ".8bpp.lz"};
+		int fv = itd->_tileset_chooser->filter_value();
+		const char *default_ext = fv >= 0 && fv < (int)_countof(tileset_exts) ? tileset_exts[fv] : ".png";
 		add_dot_ext(itd->_tileset_chooser->filename(), default_ext, filename);
 		itd->_tileset_filename.assign(filename);
 	}
@@ -7,6 +7,7 @@
 #include "utils.h"
 #include "widgets.h"
 #include "palette-format.h"
+#include "tileset.h"
 
 #pragma warning(push, 0)
 #include <FL/Fl_Double_Window.H>
@@ -19,6 +20,8 @@
 #define NO_FILES_SELECTED_LABEL "No file(s) selected"
 #define NO_FILES_DETERMINED_LABEL "No file(s) determined"
 
+int format_max_name_width(void);
+
 class Option_Dialog {
 protected:
 	int _width;
@@ -232,6 +235,7 @@ class Add_Tileset_Dialog : public Option_Dialog {
 private:
 	Label *_tileset_header;
 	Default_Hex_Spinner *_start_id, *_offset, *_length;
+	Dropdown *_layout;
 public:
 	Add_Tileset_Dialog(const char *t);
 	~Add_Tileset_Dialog();
@@ -241,6 +245,7 @@ public:
 	inline void offset(int n) { initialize(); _offset->value(n); }
 	inline int length(void) const { return _length->value(); }
 	inline void length(int n) { initialize(); _length->value(n); }
+	inline Tile_Layout layout(void) const { return _layout->active() ? (Tile_Layout)_layout->value() : Tile_Layout::LINEAR; }
 	void limit_tileset_options(const char *filename);
 protected:
 	void initialize_content(void);
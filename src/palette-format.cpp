@@ -1,9 +1,9 @@
+#include <cstring>
 #include <vector>
 #include <random>
 
 #pragma warning(push, 0)
 #include <FL/Fl.H>
-#include <FL/Fl_Image_Surface.H>
 #pragma warning(pop)
 
 #include "image.h"
@@ -32,6 +32,39 @@ const char *palette_name(Palette_Format pal_fmt) {
 	return palette_names[(int)pal_fmt];
 }
 
+static const char *palette_short_names[NUM_PALETTE_FORMATS] = {
+	"indexed", // INDEXED
+	"png",     // PNG
+	"bmp",     // BMP
+	"rgb",     // RGB
+	"jasc",    // JASC
+	"act",     // ACT
+	"aco",     // ACO
+	"ase",     // ASE
+	"col",     // COL
+	"riff",    // RIFF
+	"txt",     // TXT
+	"gpl",     // GPL
+	"xml",     // XML
+	"json",    // JSON
+	"map",     // MAP
+	"hex",     // HEX
+};
+
+const char *palette_short_name(Palette_Format pal_fmt) {
+	return palette_short_names[(int)pal_fmt];
+}
+
+bool palette_from_short_name(const char *name, Palette_Format &pal_fmt) {
+	for (int i = 0; i < NUM_PALETTE_FORMATS; i++) {
+		if (!strcmp(name, palette_short_names[i])) {
+			pal_fmt = (Palette_Format)i;
+			return true;
+		}
+	}
+	return false;
+}
+
 int palette_max_name_width() {
 	int mw = 0;
 	for (const char *pal_name : palette_names) {
@@ -52,25 +85,21 @@ const char *palette_extension(Palette_Format pal_fmt) {
 static bool write_graphic_palette(const char *f, const Palettes &palettes, size_t nc) {
 	int w = (int)nc, h = (int)palettes.size();
 	if (w % 16 == 0) { w /= 16; h *= 16; }
-	Fl_Image_Surface *surface = new Fl_Image_Surface(w, h);
-	surface->set_current();
-
-	fl_rectf(0, 0, w, h, FL_BLACK);
+	// Fill a buffer directly instead of drawing to an image surface, which would need a display
+	uchar *buffer = new uchar[(size_t)w * h * NUM_CHANNELS]();
 	int i = 0;
 	for (const Palette &palette : palettes) {
 		int j = 0;
 		for (Fl_Color c : palette) {
-			fl_color(c);
-			fl_point(j % w, i + j / w);
+			uchar *px = buffer + ((size_t)(i + j / w) * w + j % w) * NUM_CHANNELS;
+			Fl::get_color(c, px[0], px[1], px[2]);
 			j++;
 		}
 		i++;
 	}
 
-	Fl_RGB_Image *img = surface->image();
-	delete surface;
-	Fl_Display_Device::display_device()->set_current();
-
+	Fl_RGB_Image *img = new Fl_RGB_Image(buffer, w, h, NUM_CHANNELS);
+	img->alloc_array = 1;
 	Image::Result result = Image::write_image(f, img);
 	delete img;
 
@@ -82,10 +111,10 @@ static inline int hex_char(int c) {
 }
 
 static void write_guid(FILE *file) {
-	static std::random_device rd;
-	static std::mt19937_64 gen(rd());
-	static std::uniform_int_distribution<> dis(0x0, 0xF);
-	static std::uniform_int_distribution<> dis2(0x8, 0xB);
+	static thread_local std::random_device rd;
+	static thread_local std::mt19937_64 gen(rd());
+	static thread_local std::uniform_int_distribution<> dis(0x0, 0xF);
+	static thread_local std::uniform_int_distribution<> dis2(0x8, 0xB);
 	// GUID version 4 variant 1: xxxxxxxx-xxxx-4xxx-Xxxx-xxxxxxxxxxxx
 	for (int i = 0; i < 36; i++) {
 		if (i == 8 || i == 13 || i == 18 || i == 23) {
@@ -3,14 +3,7 @@
 
 #include <vector>
 
-#pragma warning(push, 0)
-#include <FL/Enumerations.H>
-#pragma warning(pop)
-
-typedef std::vector<Fl_Color> Palette;
-typedef std::vector<Palette> Palettes;
-
-#define MAX_PALETTE_LENGTH 256
+#include "core.h"
 
 #define NUM_PALETTE_FORMATS 16
 
@@ -18,6 +11,8 @@ enum class Palette_Format { INDEXED, PNG, BMP, RGB, JASC, ACT, ACO, ASE, COL, RI
 
 const char *palette_name(Palette_Format pal_fmt);
 const char *palette_extension(Palette_Format pal_fmt);
+const char *palette_short_name(Palette_Format pal_fmt);
+bool palette_from_short_name(const char *name, Palette_Format &pal_fmt);
 int palette_max_name_width(void);
 bool write_palette(const char *f, const Palettes &palettes, Palette_Format pal_fmt, size_t nc);
 bool write_tilepal(const char *f, const std::vector<size_t> &tileset, const std::vector<int> &tile_palettes);
@@ -0,0 +1,227 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#endif
+
+#include "core.h"
+#include "server.h"
+
+#ifdef _WIN32
+
+std::string default_socket_path() {
+	return "";
+}
+
+bool serve(const char *, Server_Request_Cb, void *, std::string &error) {
+	error = "The server needs UNIX-domain sockets, which this platform does not support";
+	return false;
+}
+
+bool send_request(const char *, const Server_Request &, Server_Response &, std::string &error) {
+	error = "The server needs UNIX-domain sockets, which this platform does not support";
+	return false;
+}
+
+#else
+
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+#define MAX_REQUEST_ARGS 0x10000
+#define MAX_STRING_SIZE 0x10000000
+// How long the server waits for a client to send or receive more before dropping it
+#define CONNECTION_TIMEOUT_SECONDS 10
+
+std::string default_socket_path() {
+	if (const char *path = getenv("TILEMAPSTUDIO_SOCKET"); path && *path) { return path; }
+	if (const char *dir = getenv("XDG_RUNTIME_DIR"); dir && *dir) { return std::string(dir) + "/tilemapstudio.sock"; }
+	return "/tmp/tilemapstudio-" + std::to_string(getuid()) + ".sock";
+}
+
+static bool send_all(int fd, const void *p, size_t n) {
+	const char *s = (const char *)p;
+	while (n) {
+		ssize_t k = send(fd, s, n, SEND_FLAGS);
+		if (k < 0 && errno == EINTR) { continue; }
+		if (k <= 0) { return false; }
+		s += k;
+		n -= (size_t)k;
+	}
+	return true;
+}
+
+static bool recv_all(int fd, void *p, size_t n) {
+	char *s = (char *)p;
+	while (n) {
+		ssize_t k = recv(fd, s, n, 0);
+		if (k < 0 && errno == EINTR) { continue; }
+		if (k <= 0) { return false; }
+		s += k;
+		n -= (size_t)k;
+	}
+	return true;
+}
+
+static bool send_uint32(int fd, uint32_t v) {
+	uchar b[4] = {LE32(v)};
+	return send_all(fd, b, sizeof(b));
+}
+
+static bool recv_uint32(int fd, uint32_t &v) {
+	uchar b[4];
+	if (!recv_all(fd, b, sizeof(b))) { return false; }
+	v = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+	return true;
+}
+
+static bool send_string(int fd, const std::string &s) {
+	return send_uint32(fd, (uint32_t)s.size()) && send_all(fd, s.data(), s.size());
+}
+
+static bool recv_string(int fd, std::string &s) {
+	uint32_t n;
+	if (!recv_uint32(fd, n) || n > MAX_STRING_SIZE) { return false; }
+	s.resize(n);
+	return recv_all(fd, s.data(), n);
+}
+
+static bool make_address(const char *path, sockaddr_un &addr, std::string &error) {
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		error = std::string("Socket path is too long: ") + path;
+		return false;
+	}
+	strcpy(addr.sun_path, path);
+	return true;
+}
+
+static int connect_to(const sockaddr_un &addr) {
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) { return -1; }
+#ifdef SO_NOSIGPIPE
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+	if (connect(fd, (const sockaddr *)&addr, sizeof(addr))) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static bool recv_request(int fd, uint32_t &version, Server_Request &request) {
+	uint32_t argc;
+	if (!recv_uint32(fd, version) || version != SERVER_PROTOCOL_VERSION) { return false; }
+	if (!recv_string(fd, request.cwd) || !recv_uint32(fd, argc) || argc > MAX_REQUEST_ARGS) { return false; }
+	request.args.resize(argc);
+	for (std::string &arg : request.args) {
+		if (!recv_string(fd, arg)) { return false; }
+	}
+	return true;
+}
+
+static bool send_response(int fd, const Server_Response &response) {
+	return send_uint32(fd, (uint32_t)response.status) && send_string(fd, response.output) &&
+		send_string(fd, response.errors);
+}
+
+static bool handle_connection(int fd, Server_Request_Cb cb, void *data) {
+	uint32_t version = 0;
+	Server_Request request;
+	Server_Response response;
+	bool running = true;
+	if (!recv_request(fd, version, request)) {
+		// Answer clients of another version, and drop anything else, including clients that timed out
+		if (!version || version == SERVER_PROTOCOL_VERSION) { return true; }
+		response.status = 2;
+		response.errors = "The client and server are different versions\n";
+	}
+	else if (chdir(request.cwd.c_str())) {
+		response.status = 1;
+		response.errors = "Cannot enter " + request.cwd + "\n";
+	}
+	else {
+		running = cb(request, response, data);
+	}
+	send_response(fd, response);
+	return running;
+}
+
+bool serve(const char *path, Server_Request_Cb cb, void *data, std::string &error) {
+	sockaddr_un addr;
+	if (!make_address(path, addr, error)) { return false; }
+	// Replace a socket left behind by a server that did not stop, but not a live one
+	if (int fd = connect_to(addr); fd >= 0) {
+		close(fd);
+		error = std::string("A server is already listening on ") + path;
+		return false;
+	}
+	unlink(path);
+
+	int sfd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sfd < 0 || bind(sfd, (const sockaddr *)&addr, sizeof(addr)) || listen(sfd, SOMAXCONN)) {
+		error = std::string("Cannot listen on ") + path + ": " + strerror(errno);
+		if (sfd >= 0) { close(sfd); }
+		return false;
+	}
+
+	bool ok = true;
+	for (bool running = true; running;) {
+		int fd = accept(sfd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) { continue; }
+			error = std::string("Cannot accept connections on ") + path + ": " + strerror(errno);
+			ok = false;
+			break;
+		}
+#ifdef SO_NOSIGPIPE
+		int on = 1;
+		setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+		// A client that stops sending or reading would otherwise block every request after it
+		timeval timeout = {CONNECTION_TIMEOUT_SECONDS, 0};
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+		running = handle_connection(fd, cb, data);
+		close(fd);
+	}
+	close(sfd);
+	unlink(path);
+	return ok;
+}
+
+bool send_request(const char *path, const Server_Request &request, Server_Response &response, std::string &error) {
+	sockaddr_un addr;
+	if (!make_address(path, addr, error)) { return false; }
+	int fd = connect_to(addr);
+	if (fd < 0) {
+		error = std::string("No server is listening on ") + path + "; start one with \"tilemapstudio serve\"";
+		return false;
+	}
+	bool ok = send_uint32(fd, SERVER_PROTOCOL_VERSION) && send_string(fd, request.cwd) &&
+		send_uint32(fd, (uint32_t)request.args.size());
+	for (size_t i = 0; ok && i < request.args.size(); i++) {
+		ok = send_string(fd, request.args[i]);
+	}
+	uint32_t status;
+	ok = ok && recv_uint32(fd, status) && recv_string(fd, response.output) && recv_string(fd, response.errors);
+	close(fd);
+	if (!ok) {
+		error = std::string("The server on ") + path + " did not respond";
+		return false;
+	}
+	response.status = (int)status;
+	return true;
+}
+
+#endif
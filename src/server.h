@@ -0,0 +1,38 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+#include <vector>
+
+// "tilemapstudio serve" listens on a UNIX-domain socket, so build rules can run subcommands through
+// tilemapstudio-client without starting the program for each file. Each connection carries one request
+// and its response. Numbers are 32-bit little-endian, and strings are a length followed by their bytes.
+//   Request: version, working directory, argument count, arguments
+//   Response: exit status, output, errors
+
+#define SERVER_PROTOCOL_VERSION 1
+
+struct Server_Request {
+	std::string cwd;
+	std::vector<std::string> args;
+};
+
+struct Server_Response {
+	int status = 0;
+	std::string output, errors;
+};
+
+// Handles a request in its working directory; returns false to stop the server after responding
+typedef bool (*Server_Request_Cb)(const Server_Request &request, Server_Response &response, void *data);
+
+// $TILEMAPSTUDIO_SOCKET, or tilemapstudio.sock in $XDG_RUNTIME_DIR, or a per-user file in /tmp
+std::string default_socket_path(void);
+
+// Handles requests one at a time until the callback stops it, then removes the socket; a client that stalls
+// mid-request is dropped after a timeout. Requests are not run concurrently, since each one changes to its
+// client's working directory, which the whole process shares.
+bool serve(const char *path, Server_Request_Cb cb, void *data, std::string &error);
+
+bool send_request(const char *path, const Server_Request &request, Server_Response &response, std::string &error);
+
+#endif
@@ -1,9 +1,14 @@
 #include <zlib.h>
 
+#pragma warning(push, 0)
+#include <FL/Fl_Image_Surface.H>
+#pragma warning(pop)
+
 #include "themes.h"
 #include "main-window.h"
 #include "tile-selection.h"
 #include "tile-buttons.h"
+#include "draw-stats.h"
 
 static const Fl_Color palette_colors[MAX_NUM_PALETTES] = {
 	fl_rgb_color(0xA0, 0xB0, 0xC0), fl_rgb_color(0xE6, 0x19, 0x4B),
@@ -128,10 +133,14 @@ void draw_selection_border(int x, int y, int w, int h, Fl_Color c, bool zoom) {
 	}
 }
 
-std::vector<Tileset> *Tile_State::_tilesets = NULL;
-
 Fl_PNG_Image *Tile_State::_palette_bgs_image = NULL;
 
+Fl_RGB_Image *Tile_State::_glyph_pages[MAX_ZOOM + 1][NUM_GLYPH_BANKS][NUM_GLYPH_COLORINGS] = {};
+
+bool Tile_State::_glyph_rainbow = false;
+
+Fl_RGB_Image *Tile_State::_attribute_overlays[MAX_ZOOM + 1][NUM_ATTRIBUTE_STYLES][MAX_NUM_PALETTES + 1][2][2][2] = {};
+
 void Tile_State::alpha(uchar alfa) {
 	const uchar trns_data[20] = {
 		0x74, 0x52, 0x4e, 0x53,
@@ -168,12 +177,15 @@ void Tile_State::alpha(uchar alfa) {
 	};
 	delete _palette_bgs_image;
 	_palette_bgs_image = new Fl_PNG_Image(NULL, palette_bgs_png_buffer, sizeof(palette_bgs_png_buffer));
+	clear_attribute_overlays();
 }
 
 void Tile_State::update_zoom() {
-	if (!_tilesets) { return; }
-	for (Tileset &t : *_tilesets) {
-		t.update_zoom();
+	clear_glyphs(true);
+	const Context &ctx = Config::context();
+	if (!ctx.tilesets) { return; }
+	for (Tileset &t : *ctx.tilesets) {
+		t.update_zoom(ctx.zoom);
 	}
 }
 
@@ -184,46 +196,107 @@ void Tile_State::draw_tile(int x, int y, int z, bool active, bool selected) {
 		draw_tile_1x(x, y, active, selected);
 		return;
 	}
-	if (_tilesets) {
-		for (std::vector<Tileset>::reverse_iterator it = _tilesets->rbegin(); it != _tilesets->rend(); ++it) {
+	if (std::vector<Tileset> *tilesets = Config::context().tilesets; tilesets) {
+		for (std::vector<Tileset>::reverse_iterator it = tilesets->rbegin(); it != tilesets->rend(); ++it) {
 			if (it->draw_tile(this, x, y, z, active)) {
 				return;
 			}
 		}
 	}
-	uint16_t hi = HI_NYB(id), lo = LO_NYB(id), bank = (id & 0x300) >> 8;
-	char l1 = (char)(hi > 9 ? 'A' + hi - 10 : '0' + hi), l2 = (char)(lo > 9 ? 'A' + lo - 10 : '0' + lo);
-	const char buffer[] = {l1, l2, '\0'};
-	if (bank & 1) {
-		hi ^= 8;
-		lo ^= 8;
+	Draw_Stats::tile_labeled();
+	if (!draw_glyph(x, y, z, selected)) {
+		draw_label(x, y, z, selected);
 	}
-	bool r = Config::rainbow_tiles();
-	Fl_Color bg = rainbow_bg_colors[r ? lo : 0];
-	int s = TILE_SIZE * z;
-	fl_rectf(x, y, s, s, bg);
-	int f = (OS::is_consolas() ? 11 : 10) + z * 2 - 4;
-	fl_font(tile_fonts[bank], f);
-	Fl_Color fg = selected ? FL_YELLOW : x_flip ? y_flip ? FL_YELLOW : FL_MAGENTA : y_flip ? FL_CYAN : rainbow_fg_colors[r ? hi : 0];
-	fl_color(fg);
-	fl_draw(buffer, x, y, s, s, FL_ALIGN_CENTER);
 }
 
-void Tile_State::draw_attributes(int x, int y, int z, int style, bool active) {
-	int s = TILE_SIZE * z;
-	if (!active) {
-		fl_rectf(x, y, s, s, FL_INACTIVE_COLOR);
+// Source-over blend of part of an image onto an RGBA tile buffer
+static void blend_image(std::vector<uchar> &rgba, int s, const Fl_RGB_Image *img, int dx, int dy, int w, int h, int sx, int sy) {
+	const uchar *data = (const uchar *)img->data()[0];
+	int d = img->d(), ld = img->ld();
+	if (!ld) { ld = img->w() * d; }
+	w = std::min(w, img->w() - sx);
+	h = std::min(h, img->h() - sy);
+	for (int py = 0; py < h && dy + py < s; py++) {
+		for (int px = 0; px < w && dx + px < s; px++) {
+			const uchar *src = data + (sy + py) * ld + (sx + px) * d;
+			uchar r = src[0], g = d < 3 ? src[0] : src[1], b = d < 3 ? src[0] : src[2];
+			int sa = d == 2 || d == 4 ? src[d-1] : 0xFF;
+			if (!sa) { continue; }
+			uchar *dst = rgba.data() + ((dy + py) * s + dx + px) * 4;
+			int da = dst[3] * (0xFF - sa) / 0xFF, oa = sa + da;
+			dst[0] = (uchar)((r * sa + dst[0] * da) / oa);
+			dst[1] = (uchar)((g * sa + dst[1] * da) / oa);
+			dst[2] = (uchar)((b * sa + dst[2] * da) / oa);
+			dst[3] = (uchar)oa;
+		}
 	}
-	else if (palette > -1) {
+}
+
+Fl_RGB_Image *Tile_State::attribute_overlay(int z, int style) const {
+	if (palette < 0 && (z == 1 || (!priority && !obp1))) { return NULL; }
+	if (z < MIN_ZOOM || z > MAX_ZOOM) { return NULL; }
+	int dy = z > 1 || !Config::grid();
+	Fl_RGB_Image *&overlay = _attribute_overlays[z][style + 1][palette + 1][priority][obp1][dy];
+	if (overlay) { return overlay; }
+
+	// Compose the palette background, palette digit, and priority and OBP1 icons into one image, once
+	int s = TILE_SIZE * z;
+	std::vector<uchar> rgba(s * s * 4, 0x00);
+	if (palette > -1) {
 		if (style > 0) {
-			_palette_bgs_image->draw(x, y, s, s, TILE_SIZE * MAX_ZOOM * palette, 0);
+			blend_image(rgba, s, _palette_bgs_image, 0, 0, s, s, TILE_SIZE * MAX_ZOOM * palette, 0);
 		}
 		else if (style < 0) {
-			fl_rectf(x, y, s, s, palette_colors[palette]);
+			uchar r, g, b;
+			Fl::get_color(palette_colors[palette], r, g, b);
+			for (size_t i = 0; i < rgba.size(); i += 4) {
+				rgba[i] = r; rgba[i+1] = g; rgba[i+2] = b; rgba[i+3] = 0xFF;
+			}
+		}
+		blend_image(rgba, s, &palette_digits_image, 1, dy, 5, 7, 5 * palette, 0);
+	}
+	if (z > 1) {
+		if (priority) {
+			blend_image(rgba, s, &priority_image, 8, 8, priority_image.w(), priority_image.h(), 0, 0);
+		}
+		if (obp1) {
+			blend_image(rgba, s, &obp1_image, 8, 1, obp1_image.w(), obp1_image.h(), 0, 0);
+		}
+	}
+	uchar *data = new uchar[rgba.size()];
+	std::copy(RANGE(rgba), data);
+	overlay = new Fl_RGB_Image(data, s, s, 4);
+	overlay->alloc_array = 1;
+	return overlay;
+}
+
+void Tile_State::clear_attribute_overlays() {
+	for (auto &zoom : _attribute_overlays) {
+		for (auto &style : zoom) {
+			for (auto &pal : style) {
+				for (auto &pri : pal) {
+					for (auto &obp : pri) {
+						for (Fl_RGB_Image *&overlay : obp) {
+							delete overlay;
+							overlay = NULL;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void Tile_State::draw_attributes(int x, int y, int z, int style, bool active) {
+	int s = TILE_SIZE * z;
+	if (active) {
+		Fl_RGB_Image *overlay = attribute_overlay(z, style);
+		if (overlay) {
+			overlay->draw(x, y, s, s);
 		}
-		int dy = z > 1 || !Config::grid();
-		palette_digits_image.draw(x+1, y+dy, 5, 7, 5 * palette, 0);
+		return;
 	}
+	fl_rectf(x, y, s, s, FL_INACTIVE_COLOR);
 	if (z > 1) {
 		if (priority) {
 			priority_image.draw(x+8, y+8);
@@ -272,58 +345,229 @@ void Tile_State::draw(int x, int y, int z, bool tile, bool attr, int style, bool
 		fl_rectf(x, y, s, s, FL_WHITE);
 	}
 	if (attr) {
+		Draw_Stats::Timer t(Draw_Stats::Cost::ATTRIBUTES);
 		draw_attributes(x, y, z, style, active);
+		Draw_Stats::attributes_drawn();
 	}
 }
 
 void Tile_State::draw_tile_1x(int x, int y, bool active, bool selected) {
-	if (_tilesets) {
-		for (std::vector<Tileset>::reverse_iterator it = _tilesets->rbegin(); it != _tilesets->rend(); ++it) {
+	if (std::vector<Tileset> *tilesets = Config::context().tilesets; tilesets) {
+		for (std::vector<Tileset>::reverse_iterator it = tilesets->rbegin(); it != tilesets->rend(); ++it) {
 			if (it->print_tile(this, x, y, active)) {
 				return;
 			}
 		}
 	}
-	uchar hi = HI_NYB(id), lo = LO_NYB(id);
+	Draw_Stats::tile_labeled();
+	if (!draw_glyph(x, y, 1, selected)) {
+		draw_label(x, y, 1, selected);
+	}
+}
+
+void Tile_State::draw_label(int x, int y, int z, bool selected) const {
+	uint16_t hi = HI_NYB(id), lo = LO_NYB(id), bank = (id & 0x300) >> 8;
 	bool r = Config::rainbow_tiles();
+	if (z == 1) {
+		fl_rectf(x, y, TILE_SIZE, TILE_SIZE, rainbow_bg_colors[r ? lo : 0]);
+		fl_color(selected ? FL_YELLOW : x_flip ? y_flip ? FL_YELLOW : FL_MAGENTA : y_flip ? FL_CYAN : rainbow_fg_colors[r ? hi : 0]);
+		print_digit(x, y+1, (uchar)hi);
+		print_digit(x+4, y+2, (uchar)lo);
+		return;
+	}
+	char l1 = (char)(hi > 9 ? 'A' + hi - 10 : '0' + hi), l2 = (char)(lo > 9 ? 'A' + lo - 10 : '0' + lo);
+	const char buffer[] = {l1, l2, '\0'};
+	if (bank & 1) {
+		hi ^= 8;
+		lo ^= 8;
+	}
 	Fl_Color bg = rainbow_bg_colors[r ? lo : 0];
-	fl_rectf(x, y, TILE_SIZE, TILE_SIZE, bg);
+	int s = TILE_SIZE * z;
+	fl_rectf(x, y, s, s, bg);
+	int f = (OS::is_consolas() ? 11 : 10) + z * 2 - 4;
+	fl_font(tile_fonts[bank], f);
 	Fl_Color fg = selected ? FL_YELLOW : x_flip ? y_flip ? FL_YELLOW : FL_MAGENTA : y_flip ? FL_CYAN : rainbow_fg_colors[r ? hi : 0];
 	fl_color(fg);
-	print_digit(x, y+1, hi);
-	print_digit(x+4, y+2, lo);
+	fl_draw(buffer, x, y, s, s, FL_ALIGN_CENTER);
 }
 
-void Tile_State::print(int x, int y, bool active, bool selected, int palette_) {
-	bool drawn = false;
-	if (_tilesets) {
-		for (std::vector<Tileset>::reverse_iterator it = _tilesets->rbegin(); it != _tilesets->rend(); ++it) {
-			if (it->print_tile(this, x, y, active)) {
-				drawn = true;
-				break;
+// Labels only vary by the low ten bits of their ID and four foreground colorings, so each zoom level gets
+// one page of 256 labels per bank and coloring, rendered the first time any of them is drawn
+Fl_RGB_Image *Tile_State::render_glyph_page(int bank, int coloring, int z) {
+	int s = TILE_SIZE * z;
+	Fl_Image_Surface *surface = new Fl_Image_Surface(GLYPHS_PER_ROW * s, GLYPHS_PER_ROW * s);
+	Fl_Surface_Device::push_current(surface);
+	for (int i = 0; i < GLYPHS_PER_ROW * GLYPHS_PER_ROW; i++) {
+		Tile_State ts((uint16_t)(bank << 8 | i), !!(coloring & 1), !!(coloring & 2));
+		int gx = i % GLYPHS_PER_ROW * s, gy = i / GLYPHS_PER_ROW * s;
+		fl_push_clip(gx, gy, s, s);
+		ts.draw_label(gx, gy, z, false);
+		fl_pop_clip();
+	}
+	Fl_RGB_Image *img = surface->image();
+	Fl_Surface_Device::pop_current();
+	delete surface;
+	return img;
+}
+
+void Tile_State::clear_glyphs(bool keep_visible) {
+	for (int z = MIN_ZOOM; z <= MAX_ZOOM; z++) {
+		// The tilemap is drawn at the current zoom, and the tileset at the default zoom
+		if (keep_visible && (z == Config::zoom() || z == DEFAULT_ZOOM)) { continue; }
+		for (int b = 0; b < NUM_GLYPH_BANKS; b++) {
+			for (int c = 0; c < NUM_GLYPH_COLORINGS; c++) {
+				delete _glyph_pages[z][b][c];
+				_glyph_pages[z][b][c] = NULL;
 			}
 		}
 	}
-	if (!drawn) {
+}
+
+Fl_RGB_Image *Tile_State::glyph(int z, bool selected, int &gx, int &gy) const {
+	if (z < MIN_ZOOM || z > MAX_ZOOM) { return NULL; }
+	if (_glyph_rainbow != Config::rainbow_tiles()) {
+		clear_glyphs(false);
+		_glyph_rainbow = Config::rainbow_tiles();
+	}
+	// Selected labels are yellow, like labels flipped both ways
+	int bank = (id & 0x300) >> 8, coloring = selected ? 3 : (x_flip ? 1 : 0) | (y_flip ? 2 : 0);
+	Fl_RGB_Image *&page = _glyph_pages[z][bank][coloring];
+	if (!page) {
+		page = render_glyph_page(bank, coloring, z);
+		if (!page) { return NULL; }
+	}
+	int s = TILE_SIZE * z, i = id & 0xFF;
+	gx = i % GLYPHS_PER_ROW * s;
+	gy = i / GLYPHS_PER_ROW * s;
+	return page;
+}
+
+bool Tile_State::draw_glyph(int x, int y, int z, bool selected) const {
+	int gx, gy;
+	Fl_RGB_Image *page = glyph(z, selected, gx, gy);
+	if (!page) { return false; }
+	int s = TILE_SIZE * z;
+	page->draw(x, y, s, s, gx, gy);
+	return true;
+}
+
+Fl_RGB_Image *Tile_State::tileset_image(const Context &ctx, int &tx, int &ty) const {
+	if (!ctx.tilesets) { return NULL; }
+	for (std::vector<Tileset>::const_reverse_iterator it = ctx.tilesets->crbegin(); it != ctx.tilesets->crend(); ++it) {
+		Fl_RGB_Image *img = it->tile_image(this, tx, ty);
+		if (img) { return img; }
+	}
+	return NULL;
+}
+
+Fl_Color Tile_State::average_color() const {
+	int tx, ty;
+	Fl_RGB_Image *img = tileset_image(Config::context(), tx, ty);
+	if (!img || img->fail() || !img->count() || img->d() < 1 || img->d() > 4 || !img->w() || !img->h()) {
+		// Tiles without an image are labeled over their rainbow background
+		uint16_t lo = LO_NYB(id);
+		if (id & 0x100) { lo ^= 8; }
+		return rainbow_bg_colors[Config::rainbow_tiles() ? lo : 0];
+	}
+	int dw = img->data_w(), dh = img->data_h(), d = img->d();
+	int ld = img->ld() ? img->ld() : dw * d;
+	int sx = tx * dw / img->w(), sy = ty * dh / img->h();
+	int sw = std::max(TILE_SIZE * dw / img->w(), 1), sh = std::max(TILE_SIZE * dh / img->h(), 1);
+	const uchar *data = (const uchar *)img->data()[0];
+	unsigned long r = 0, g = 0, b = 0;
+	for (int y = sy; y < sy + sh; y++) {
+		const uchar *p = data + y * ld + sx * d;
+		for (int x = 0; x < sw; x++, p += d) {
+			if (d < 3) { r += p[0]; g += p[0]; b += p[0]; }
+			else { r += p[0]; g += p[1]; b += p[2]; }
+		}
+	}
+	unsigned long n = (unsigned long)sw * sh;
+	return fl_rgb_color((uchar)(r / n), (uchar)(g / n), (uchar)(b / n));
+}
+
+// Source-over blend of part of an image onto an opaque RGB buffer
+static void blend_image(uchar *rgb, size_t ld, const Fl_RGB_Image *img, int dx, int dy, int w, int h, int sx, int sy) {
+	const uchar *data = (const uchar *)img->data()[0];
+	int d = img->d(), ild = img->ld();
+	if (!ild) { ild = img->w() * d; }
+	w = std::min(w, img->w() - sx);
+	h = std::min(h, img->h() - sy);
+	for (int py = 0; py < h && dy + py < TILE_SIZE; py++) {
+		for (int px = 0; px < w && dx + px < TILE_SIZE; px++) {
+			const uchar *src = data + (sy + py) * ild + (sx + px) * d;
+			int a = d == 2 || d == 4 ? src[d-1] : 0xFF;
+			if (!a) { continue; }
+			uchar *dst = rgb + (dy + py) * ld + (dx + px) * NUM_CHANNELS;
+			for (int k = 0; k < NUM_CHANNELS; k++) {
+				uchar v = d < 3 ? src[0] : src[k];
+				dst[k] = (uchar)((v * a + dst[k] * (0xFF - a)) / 0xFF);
+			}
+		}
+	}
+}
+
+static void fill_rgb(uchar *rgb, size_t ld, int x, int y, int w, int h, Fl_Color c) {
+	uchar r, g, b;
+	Fl::get_color(c, r, g, b);
+	for (int py = y; py < y + h; py++) {
+		for (int px = x; px < x + w; px++) {
+			uchar *dst = rgb + py * ld + px * NUM_CHANNELS;
+			dst[0] = r; dst[1] = g; dst[2] = b;
+		}
+	}
+}
+
+static void print_digit(uchar *rgb, size_t ld, int x, int y, uchar d, Fl_Color c) {
+	const int *pixels = digit_pixels[d];
+	int n = pixels[0];
+	for (int i = 1; i <= n; i += 2) {
+		fill_rgb(rgb, ld, x + pixels[i], y + pixels[i+1], 1, 1, c);
+	}
+}
+
+void Tile_State::print(const Context &ctx, uchar *rgb, size_t ld, int palette_) const {
+	int tx = 0, ty = 0;
+	const Fl_RGB_Image *img = tileset_image(ctx, tx, ty);
+	if (img && !img->fail() && img->count() && img->d() >= 1 && img->d() <= 4) {
+		const uchar *data = (const uchar *)img->data()[0];
+		int d = img->d(), ild = img->ld();
+		if (!ild) { ild = img->w() * d; }
+		for (int py = 0; py < TILE_SIZE; py++) {
+			int fy = y_flip ? TILE_SIZE - 1 - py : py;
+			for (int px = 0; px < TILE_SIZE; px++) {
+				int fx = x_flip ? TILE_SIZE - 1 - px : px;
+				const uchar *src = data + (ty + fy) * ild + (tx + fx) * d;
+				uchar *dst = rgb + py * ld + px * NUM_CHANNELS;
+				for (int k = 0; k < NUM_CHANNELS; k++) {
+					dst[k] = d < 3 ? src[0] : src[k];
+				}
+			}
+		}
+	}
+	else {
 		uchar hi = HI_NYB(id), lo = LO_NYB(id);
-		bool r = Config::print_rainbow_tiles();
-		Fl_Color bg = rainbow_bg_colors[r ? lo : 0];
-		fl_rectf(x, y, TILE_SIZE, TILE_SIZE, bg);
-		Fl_Color fg = selected ? FL_YELLOW : x_flip ? y_flip ? FL_YELLOW : FL_MAGENTA : y_flip ? FL_CYAN : rainbow_fg_colors[r ? hi : 0];
-		fl_color(fg);
-		print_digit(x, y+1, hi);
-		print_digit(x+4, y+2, lo);
+		bool r = ctx.print_rainbow_tiles;
+		fill_rgb(rgb, ld, 0, 0, TILE_SIZE, TILE_SIZE, rainbow_bg_colors[r ? lo : 0]);
+		Fl_Color fg = x_flip ? y_flip ? FL_YELLOW : FL_MAGENTA : y_flip ? FL_CYAN : rainbow_fg_colors[r ? hi : 0];
+		print_digit(rgb, ld, 0, 1, hi, fg);
+		print_digit(rgb, ld, 4, 2, lo, fg);
 	}
-	if (Config::print_grid()) {
-		draw_grid(x, y, 1);
+	if (ctx.print_grid) {
+		// Same pattern as draw_grid: a dark line under dashes that start light
+		Fl_Color dark = fl_rgb_color(0x40), light = fl_rgb_color(0xD0);
+		for (int i = 0; i < TILE_SIZE; i++) {
+			fill_rgb(rgb, ld, i, TILE_SIZE - 1, 1, 1, i / 2 % 2 ? dark : light);
+			fill_rgb(rgb, ld, TILE_SIZE - 1, i, 1, 1, i / 2 % 2 ? dark : light);
+		}
 	}
 	if (palette_ > -1) {
-		if (Config::print_bold_palettes()) {
-			_palette_bgs_image->draw(x, y, TILE_SIZE, TILE_SIZE, TILE_SIZE * MAX_ZOOM * palette_, 0);
+		if (ctx.print_bold_palettes) {
+			blend_image(rgb, ld, _palette_bgs_image, 0, 0, TILE_SIZE, TILE_SIZE, TILE_SIZE * MAX_ZOOM * palette_, 0);
 		}
-		if (Config::print_palettes()) {
-			int dy = !Config::print_grid();
-			palette_digits_image.draw(x+1, y+dy, 5, 7, 5 * palette_, 0);
+		if (ctx.print_palettes) {
+			int dy = !ctx.print_grid;
+			blend_image(rgb, ld, &palette_digits_image, 1, dy, 5, 7, 5 * palette_, 0);
 		}
 	}
 }
@@ -360,8 +604,11 @@ void Tile_Tessera::draw() {
 	Main_Window *mw = (Main_Window *)user_data();
 	int X = x(), Y = y(), Z = Config::zoom();
 	_state.draw(X, Y, Z, true, Config::show_attributes(), (int)Config::bold_palettes(), !!active(), false);
+	Draw_Stats::tile_drawn();
 	if (Config::grid()) {
+		Draw_Stats::Timer t(Draw_Stats::Cost::GRID);
 		draw_grid(X, Y, Z);
+		Draw_Stats::grid_drawn();
 	}
 	if (_state.highlighted()) {
 		draw_highlight(X, Y, Z);
@@ -380,7 +627,7 @@ int Tile_Tessera::handle(int event) {
 	case FL_ENTER:
 		if (ts.selecting() && !ts.from_tileset()) {
 			if (Fl::event_button3()) {
-				ts.continue_selecting(this);
+				ts.continue_selecting(cell());
 				mw->update_selection_status();
 				mw->redraw_overlay();
 			}
@@ -396,14 +643,14 @@ int Tile_Tessera::handle(int event) {
 			}
 		}
 		mw->update_status(this);
-		redraw();
+		mw->damage_tile(this);
 		return 1;
 	case FL_LEAVE:
 		if (ts.selecting() && !pushed_in_tileset) {
-			ts.continue_selecting(NULL);
+			ts.continue_selecting();
 		}
 		mw->update_status(NULL);
-		redraw();
+		mw->damage_tile(this);
 		return 1;
 	case FL_MOVE:
 		return 1;
@@ -421,6 +668,7 @@ int Tile_Tessera::handle(int event) {
 			}
 			mw->update_selection_status();
 			mw->update_selection_controls();
+			mw->damage_tile(this);
 		}
 		return 1;
 	case FL_DRAG:
@@ -428,7 +676,7 @@ int Tile_Tessera::handle(int event) {
 			Fl::pushed(NULL);
 		}
 		if (Fl::event_button3() && !ts.selecting() && !pushed_in_tileset) {
-			ts.start_selecting(this);
+			ts.start_selecting(cell(), false);
 			mw->redraw_overlay();
 		}
 		return 1;
@@ -436,129 +684,139 @@ int Tile_Tessera::handle(int event) {
 	return 0;
 }
 
-Tile_Button::Tile_Button(int x, int y, size_t row, size_t col, uint16_t id) : Groupable(x, y, row, col, id),
-	_value(), _old_value() {
+Tile_Picker::Tile_Picker(int x, int y, int columns, int n) : Fl_Widget(x, y, 0, 0), _columns(columns), _first_id(0),
+	_num_tiles(n), _selected_id(-1), _target_id(0) {
 	user_data(NULL);
 	box(FL_NO_BOX);
 	labeltype(FL_NO_LABEL);
-	type(FL_RADIO_BUTTON);
+	fit();
 }
 
-int Tile_Button::value(char v) {
-	// Based on Fl_Radio_Button::value()
-	_old_value = v ? 1 : 0;
-	clear_changed();
-	if (_value != _old_value) {
-		_value = _old_value;
-		redraw();
-		return 1;
-	}
-	return 0;
+void Tile_Picker::fit() {
+	int rows = (_num_tiles + _columns - 1) / _columns;
+	size(_columns * TILE_SIZE_2X, rows * TILE_SIZE_2X);
 }
 
-void Tile_Button::setonly() {
-	// Based on Fl_Radio_Button::setonly()
-	set();
-	Fl_Group *g = parent();
-	Fl_Widget * const *a = g->array();
-	for (int i = g->children(); i--;) {
-		Fl_Widget *o = *a++;
-		if (o != this && o->type() == FL_RADIO_BUTTON) {
-			((Tile_Button *)o)->clear();
-		}
-	}
+void Tile_Picker::columns(int c) {
+	if (c < 1 || c == _columns) { return; }
+	_columns = c;
+	fit();
+	redraw();
+}
+
+void Tile_Picker::tiles(int first, int n) {
+	if (first == _first_id && n == _num_tiles) { return; }
+	_first_id = first;
+	_num_tiles = n;
+	fit();
+	redraw();
+}
+
+void Tile_Picker::select(uint16_t id) {
+	if (_selected_id == (int)id) { return; }
+	if (_selected_id >= 0) { damage_tile((uint16_t)_selected_id); }
+	_selected_id = (int)id;
+	damage_tile(id);
 }
 
-void Tile_Button::draw() {
+void Tile_Picker::damage_tile(uint16_t id) {
+	if ((int)id < _first_id || (int)id >= _num_tiles) { return; }
+	Tile_Cell c = cell(id);
+	damage(FL_DAMAGE_ALL, tile_x(c.col), tile_y(c.row), TILE_SIZE_2X, TILE_SIZE_2X);
+}
+
+int Tile_Picker::id_at(int ex, int ey) const {
+	if (ex < x() || ey < y() || ex >= x() + w() || ey >= y() + h()) { return -1; }
+	int col = (ex - x()) / TILE_SIZE_2X, row = (ey - y()) / TILE_SIZE_2X;
+	int id = row * _columns + col;
+	return id >= _first_id && id < _num_tiles ? id : -1;
+}
+
+void Tile_Picker::draw() {
+	int cx, cy, cw, ch;
+	fl_clip_box(x(), y(), w(), h(), cx, cy, cw, ch);
+	if (cw <= 0 || ch <= 0) { return; }
 	Main_Window *mw = (Main_Window *)user_data();
-	int X = x(), Y = y();
 	bool multi = mw->selection().selected_multiple();
-	_state.draw(X, Y, DEFAULT_ZOOM, true, Config::show_attributes(), (int)Config::bold_palettes(), !!active(), !!value() && !multi);
-	if (Config::grid()) {
-		draw_grid(X, Y);
-	}
-	if (_state.highlighted()) {
-		draw_highlight(X, Y);
-	}
-	if (value() && !multi) {
-		draw_selection_border(X, Y, DEFAULT_ZOOM, _state.highlighted());
+	bool attr = Config::show_attributes(), act = !!active();
+	int style = (int)Config::bold_palettes();
+	int col0 = (cx - x()) / TILE_SIZE_2X, col1 = std::min((cx + cw - x() + TILE_SIZE_2X - 1) / TILE_SIZE_2X, _columns);
+	int row0 = (cy - y()) / TILE_SIZE_2X, row1 = (cy + ch - y() + TILE_SIZE_2X - 1) / TILE_SIZE_2X;
+	for (int row = row0; row < row1; row++) {
+		for (int col = col0; col < col1; col++) {
+			int id = row * _columns + col;
+			if (id >= _num_tiles) { return; }
+			if (id < _first_id) { continue; }
+			int X = tile_x((size_t)col), Y = tile_y((size_t)row);
+			Tile_State ts((uint16_t)id);
+			bool selected = id == _selected_id && !multi;
+			ts.draw(X, Y, DEFAULT_ZOOM, true, attr, style, act, selected);
+			if (Config::grid()) {
+				draw_grid(X, Y);
+			}
+			if (ts.highlighted()) {
+				draw_highlight(X, Y);
+			}
+			if (selected) {
+				draw_selection_border(X, Y, DEFAULT_ZOOM, ts.highlighted());
+			}
+		}
 	}
 }
 
-int Tile_Button::handle(int event) {
-	// Based on Fl_Button::handle()
-	char new_value;
+int Tile_Picker::handle(int event) {
 	Main_Window *mw = (Main_Window *)user_data();
 	Tile_Selection &ts = mw->selection();
+	int id = id_at(Fl::event_x(), Fl::event_y());
 	switch (event) {
 	case FL_ENTER:
 		// Don't interfere with dragging onto the parent Droppable|Workspace
 		if (mw->dropping()) { return 0; }
-		if (ts.selecting() && ts.from_tileset()) {
-			if (Fl::event_button1()) {
-				ts.continue_selecting(this);
-				mw->update_selection_status();
-				mw->redraw_overlay();
-			}
-			else {
-				ts.finish_selecting();
-				mw->update_selection_controls();
-			}
-		}
-		if ((Fl::event_button1() || Fl::event_button3()) && !Fl::pushed()) {
-			Fl::pushed(this);
+		if (ts.selecting() && ts.from_tileset() && !Fl::event_button1()) {
+			ts.finish_selecting();
+			mw->update_selection_controls();
 		}
 		return 1;
 	case FL_LEAVE:
-		if (ts.selecting() && pushed_in_tileset) {
-			ts.continue_selecting(NULL);
-		}
-		redraw();
-		return 1;
 	case FL_MOVE:
 		return 1;
 	case FL_PUSH:
 		pushed_in_tileset = true;
-		// Don't change the value on right-click
+		_target_id = id;
+		if (id < 0) { return 1; }
+		// Don't change the selection on right-click
 		if (Fl::event_button() == FL_RIGHT_MOUSE) {
 			return 1;
 		}
-		if (Fl::event_inside(this)) {
-			new_value = 1;
-		}
-		else {
-			clear_changed();
-			new_value = _old_value;
-		}
-		if (new_value != _value) {
-			_value = new_value;
-			set_changed();
-			redraw();
-			do_callback();
-		}
+		do_callback();
 		return 1;
 	case FL_RELEASE:
-		if (_value != _old_value) {
-			set_changed();
-			setonly();
-		}
 		if (!ts.selecting()) {
+			if (id < 0) { return 1; }
+			_target_id = id;
 			do_callback();
+			return 1;
 		}
-		if (ts.selecting() && ts.from_tileset()) {
+		if (ts.from_tileset()) {
 			ts.finish_selecting();
 			mw->update_selection_status();
 			mw->update_selection_controls();
+			redraw();
 		}
 		return 1;
 	case FL_DRAG:
-		if (!Fl::event_inside(x(), y(), w(), h())) {
-			Fl::pushed(NULL);
+		if (!Fl::event_button1() || !pushed_in_tileset || _target_id < 0) { return 1; }
+		if (!ts.selecting()) {
+			ts.start_selecting(cell((uint16_t)_target_id), true);
 		}
-		if (Fl::event_button1() && !ts.selecting() && pushed_in_tileset) {
-			ts.start_selecting(this);
-			mw->redraw_overlay();
+		if (id < 0) {
+			ts.continue_selecting();
+		}
+		else {
+			ts.continue_selecting(cell((uint16_t)id));
 		}
+		mw->update_selection_status();
+		mw->redraw_overlay();
 		return 1;
 	default:
 		return 0;
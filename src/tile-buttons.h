@@ -13,30 +13,37 @@
 
 #include "utils.h"
 #include "config.h"
+#include "tileset.h"
 #include "tile.h"
 
 #define TILE_SIZE_2X (TILE_SIZE * DEFAULT_ZOOM)
 
+#define NUM_GLYPH_BANKS 4
+#define NUM_GLYPH_COLORINGS 4
+#define GLYPHS_PER_ROW 16
+
+#define NUM_ATTRIBUTE_STYLES 3 // solid, plain, bold
+
 class Tileset;
 
 void draw_selection_border(int x, int y, int w, int h, Fl_Color c, bool zoom);
 
-struct Tile_State {
+struct Tile_State : public Tilemap_Entry {
 private:
-	static std::vector<Tileset> *_tilesets;
 	static Fl_PNG_Image *_palette_bgs_image;
+	static Fl_RGB_Image *_glyph_pages[MAX_ZOOM + 1][NUM_GLYPH_BANKS][NUM_GLYPH_COLORINGS];
+	static bool _glyph_rainbow;
+	static Fl_RGB_Image *render_glyph_page(int bank, int coloring, int z);
+	static void clear_glyphs(bool keep_visible);
+	// Indexed by zoom, style, palette, priority, OBP1, and digit offset
+	static Fl_RGB_Image *_attribute_overlays[MAX_ZOOM + 1][NUM_ATTRIBUTE_STYLES][MAX_NUM_PALETTES + 1][2][2][2];
+	static void clear_attribute_overlays(void);
 public:
-	inline static void tilesets(std::vector<Tileset> *ts) { _tilesets = ts; }
 	static void alpha(uchar alfa);
 	static void update_zoom(void);
-public:
-	uint16_t id;
-	bool x_flip, y_flip, priority, obp1;
-	int palette;
 public:
 	inline Tile_State(uint16_t id_ = 0x000, bool x_flip_ = false, bool y_flip_ = false, bool priority_ = false,
-		bool obp1_ = false, int palette_ = -1) : id(id_), x_flip(x_flip_), y_flip(y_flip_), priority(priority_),
-		obp1(obp1_), palette(palette_) {}
+		bool obp1_ = false, int palette_ = -1) : Tilemap_Entry(id_, x_flip_, y_flip_, priority_, obp1_, palette_) {}
 	inline bool same_tiles(const Tile_State &other) const {
 		return id == other.id && x_flip == other.x_flip && y_flip == other.y_flip;
 	}
@@ -48,13 +55,30 @@ public:
 	}
 	inline bool highlighted(void) const { return id == Config::highlight_id(); }
 	void draw(int x, int y, int z, bool tile, bool attr, int style, bool active, bool selected);
-	void print(int x, int y, bool active, bool selected, int palette_ = -1);
+	// Renders the tile at 1x into an RGB buffer with a row stride of ld bytes, without a display
+	void print(const Context &ctx, uchar *rgb, size_t ld, int palette_ = -1) const;
+	// Sources for compositing tiles without drawing them
+	Fl_RGB_Image *tileset_image(const Context &ctx, int &tx, int &ty) const;
+	Fl_RGB_Image *glyph(int z, bool selected, int &gx, int &gy) const;
+	Fl_RGB_Image *attribute_overlay(int z, int style) const;
+	// One color standing in for the whole tile, for overviews
+	Fl_Color average_color(void) const;
 private:
 	void draw_tile(int x, int y, int z, bool active, bool selected);
 	void draw_tile_1x(int x, int y, bool active, bool selected);
+	bool draw_glyph(int x, int y, int z, bool selected) const;
+	void draw_label(int x, int y, int z, bool selected) const;
 	void draw_attributes(int x, int y, int z, int style, bool active);
 };
 
+// Where a tile was picked from in the tileset or tilemap
+struct Tile_Cell {
+	uint16_t id;
+	size_t row, col;
+	inline Tile_Cell(uint16_t id_ = 0x000, size_t row_ = 0, size_t col_ = 0) : id(id_), row(row_), col(col_) {}
+	inline bool same_place(const Tile_Cell &other) const { return row == other.row && col == other.col; }
+};
+
 class Tile_Thing {
 protected:
 	Tile_State _state;
@@ -111,6 +135,7 @@ public:
 	inline size_t row(void) const { return _row; }
 	inline size_t col(void) const { return _col; }
 	inline void coords(size_t row, size_t col) { _row = row; _col = col; }
+	inline Tile_Cell cell(void) const { return Tile_Cell(id(), _row, _col); }
 };
 
 class Tile_Tessera : public Groupable {
@@ -119,23 +144,32 @@ public:
 public:
 	Tile_Tessera(int x = 0, int y = 0, size_t row = 0, size_t col = 0, uint16_t id = 0x000,
 		bool x_flip = false, bool y_flip = false, bool priority = false, bool obp1 = false, int palette = -1);
-	inline void print(int dx, int dy, bool active, bool selected) { _state.print(dx, dy, active, selected, palette()); }
+	inline void print(const Context &ctx, uchar *rgb, size_t ld) const { _state.print(ctx, rgb, ld, palette()); }
 	void draw(void);
 	int handle(int event);
 };
 
-class Tile_Button : public Groupable {
+// The tileset array as one widget, drawing only the tiles inside the clip region instead of one widget per tile
+class Tile_Picker : public Fl_Widget {
 private:
-	char _value, _old_value;
+	int _columns, _first_id, _num_tiles, _selected_id, _target_id;
 public:
-	Tile_Button(int x, int y, size_t row = 0, size_t col = 0, uint16_t id = 0x000);
-	inline char value(void) const { return _value; }
-	int value(char v);
-	inline int set(void) { return value(1); }
-	inline int clear(void) { return value(0); }
-	void setonly(void);
+	Tile_Picker(int x, int y, int columns, int n);
+	inline int columns(void) const { return _columns; }
+	void columns(int c);
+	void tiles(int first, int n);
+	inline int selected(void) const { return _selected_id; }
+	void select(uint16_t id);
+	inline uint16_t target(void) const { return (uint16_t)_target_id; }
+	inline Tile_Cell cell(uint16_t id) const { return Tile_Cell(id, (size_t)(id / _columns), (size_t)(id % _columns)); }
+	inline int tile_x(size_t col) const { return x() + (int)col * TILE_SIZE_2X; }
+	inline int tile_y(size_t row) const { return y() + (int)row * TILE_SIZE_2X; }
+	void damage_tile(uint16_t id);
 	void draw(void);
 	int handle(int event);
+private:
+	int id_at(int ex, int ey) const;
+	void fit(void);
 };
 
 class Palette_Button : public Tile_Thing, public Fl_Radio_Button {
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <set>
+#include <unordered_map>
+
+#include "tile-packer.h"
+
+typedef std::set<Fl_Color> Color_Set;
+
+double luminance(Fl_Color c) {
+	uchar r, g, b;
+	get_rgb(c, r, g, b);
+	return 0.299 * (double)r + 0.587 * (double)g + 0.114 * (double)b;
+}
+
+size_t make_palettes(const Tile *tiles, size_t n, size_t max_colors, size_t max_palettes, bool use_color_zero,
+	Fl_Color color_zero, uint8_t start_index, Palettes &palettes, std::vector<int> &tile_palettes) {
+	// Algorithm ported from superfamiconv
+	// <https://github.com/Optiroc/SuperFamiconv>
+
+	// Get the color set of each tile
+	std::vector<Color_Set> cs_tiles;
+	cs_tiles.reserve(n);
+	size_t qi = 0;
+	for (; qi < n; qi++) {
+		const Tile &tile = tiles[qi];
+		Color_Set s;
+		if (use_color_zero) {
+			s.insert(color_zero);
+		}
+		for (Fl_Color c : tile) {
+			s.insert(c);
+		}
+		if (s.size() > max_colors) {
+			break;
+		}
+		cs_tiles.push_back(s);
+	}
+
+	// A tile with too many colors cannot fit in any palette
+	if (qi < n) { return qi; }
+
+	// Remove duplicate color sets
+	std::vector<Color_Set> cs_uniq(cs_tiles.size());
+	auto cs_uniq_last = std::copy_if(RANGE(cs_tiles), cs_uniq.begin(), [&](const Color_Set &s) {
+		return std::find(RANGE(cs_uniq), s) == cs_uniq.end();
+	});
+	cs_uniq.resize(std::distance(cs_uniq.begin(), cs_uniq_last));
+
+	// Remove color sets that are proper subsets of other color sets
+	std::vector<Color_Set> cs_full(cs_uniq.size());
+	auto cs_full_last = std::copy_if(RANGE(cs_uniq), cs_full.begin(), [&](const Color_Set &s) {
+		return !std::any_of(RANGE(cs_uniq), [&](const Color_Set &c) {
+			return s != c && std::includes(RANGE(c), RANGE(s));
+		});
+	});
+	cs_full.resize(std::distance(cs_full.begin(), cs_full_last));
+
+	// Combine color sets as long as they fit within the color limit
+	std::vector<Color_Set> cs_opt;
+	cs_opt.reserve(cs_full.size());
+	for (Color_Set &s : cs_full) {
+		Color_Set *b = NULL;
+		for (Color_Set &c : cs_opt) {
+			Color_Set d;
+			std::set_difference(RANGE(s), RANGE(c), std::inserter(d, d.begin()));
+			if (c.size() + d.size() <= max_colors) {
+				b = &c;
+			}
+		}
+		if (b) {
+			b->insert(RANGE(s));
+		}
+		else {
+			cs_opt.push_back(s);
+		}
+	}
+
+	// Sort color sets from most to fewest colors
+	std::stable_sort(RANGE(cs_opt), [](const Color_Set &a, const Color_Set &b) {
+		return a.size() > b.size();
+	});
+
+	// Sort each palette from brightest to darkest color, padded with black, keeping color 0 first
+	palettes.reserve(max_palettes);
+	for (Color_Set &s : cs_opt) {
+		Palette palette(RANGE(s));
+		std::sort(RANGE(palette), [use_color_zero, color_zero](Fl_Color a, Fl_Color b) {
+			if (use_color_zero) {
+				if (a == color_zero) { return true; }
+				if (b == color_zero) { return false; }
+			}
+			return luminance(a) > luminance(b);
+		});
+		if (max_palettes == 1) {
+			// Pad the palette to start at the right index
+			if (start_index > 1) {
+				palette.insert(palette.begin(), start_index - 1, BLACK_COLOR);
+			}
+			palette.insert(palette.begin(), color_zero);
+		}
+		if (palette.size() < max_colors) {
+			palette.insert(palette.end(), max_colors - palette.size(), BLACK_COLOR);
+		}
+		palettes.push_back(palette);
+	}
+
+	// Pad the palettes to start at the right index
+	if (max_palettes > 1) {
+		for (uint8_t i = 0; i < start_index; i++) {
+			Palette palette(max_colors, BLACK_COLOR);
+			palette[0] = color_zero;
+			palettes.insert(palettes.begin(), palette);
+		}
+	}
+
+	// Associate tiles with palettes
+	size_t np = palettes.size();
+	for (size_t i = 0; i < n; i++) {
+		int pal = 0;
+		const Color_Set &s = cs_tiles[i];
+		for (size_t j = 0; j < np; j++) {
+			const Color_Set &c = cs_opt[j];
+			if (std::includes(RANGE(c), RANGE(s))) {
+				pal = (int)j;
+				break;
+			}
+		}
+		tile_palettes[i] = start_index + pal;
+	}
+
+	return n;
+}
+
+typedef std::array<Fl_Color, NUM_TILE_PIXELS> Tile_Key;
+
+struct Tile_Key_Hash {
+	size_t operator()(const Tile_Key &k) const {
+		// FNV-1a
+		size_t h = 0xCBF29CE484222325ULL;
+		for (Fl_Color c : k) {
+			h = (h ^ c) * 0x100000001B3ULL;
+		}
+		return h;
+	}
+};
+
+static Tile_Key tile_key(const Tile &tile, bool x_flip, bool y_flip) {
+	Tile_Key k;
+	for (int y = 0; y < TILE_SIZE; y++) {
+		for (int x = 0; x < TILE_SIZE; x++) {
+			k[y * TILE_SIZE + x] = tile[(y_flip ? TILE_SIZE - y - 1 : y) * TILE_SIZE + (x_flip ? TILE_SIZE - x - 1 : x)];
+		}
+	}
+	return k;
+}
+
+bool pack_tiles(const Tile *tiles, size_t n, const std::vector<int> &tile_palettes, Tilemap_Format fmt, bool allow_unique,
+	bool allow_flip, uint16_t start_id, bool use_blank, uint16_t blank_id, Fl_Color blank_color,
+	std::vector<Tilemap_Entry> &entries, std::vector<size_t> &tileset) {
+	size_t mn = (size_t)format_tileset_size(fmt);
+	entries.reserve(n);
+	tileset.reserve(mn);
+	allow_flip &= format_can_flip(fmt);
+	// Look up identical tiles by their pixels instead of comparing against the whole tileset
+	std::unordered_map<Tile_Key, size_t, Tile_Key_Hash> lookup;
+	auto add_tile = [&](size_t j) {
+		lookup.emplace(tile_key(tiles[j], false, false), tileset.size());
+		tileset.push_back(j);
+	};
+	for (size_t i = 0; i < n; i++) {
+		if (use_blank && start_id + tileset.size() == blank_id) {
+			size_t j = 0;
+			for (; j < n; j++) {
+				if (is_blank_tile(tiles[j], blank_color)) { break; }
+			}
+			add_tile(j);
+		}
+		const Tile &tile = tiles[i];
+		if (use_blank && is_blank_tile(tile, blank_color)) {
+			entries.emplace_back(blank_id, false, false, false, false, tile_palettes[i]);
+			continue;
+		}
+		size_t nt = tileset.size(), ti = nt;
+		bool x_flip = false, y_flip = false;
+		if (allow_unique) {
+			// The earliest matching tileset tile wins, unflipped before x, y, then both flipped
+			for (int f = 0; f < (allow_flip ? 4 : 1); f++) {
+				auto it = lookup.find(tile_key(tile, f & 1, f & 2));
+				if (it != lookup.end() && it->second < ti) {
+					ti = it->second;
+					x_flip = f & 1;
+					y_flip = f & 2;
+				}
+			}
+		}
+		if (ti == nt) {
+			if (nt + (size_t)start_id > mn) {
+				return false;
+			}
+			add_tile(i);
+		}
+		uint16_t id = start_id + (uint16_t)ti;
+		entries.emplace_back(id, x_flip, y_flip, false, false, tile_palettes[i]);
+	}
+	return true;
+}
+
+bool Palette_Cache::Key::operator==(const Key &other) const {
+	return n == other.n && max_colors == other.max_colors && max_palettes == other.max_palettes &&
+		num_palettes == other.num_palettes && use_color_zero == other.use_color_zero &&
+		color_zero == other.color_zero && start_index == other.start_index && tile_palettes == other.tile_palettes &&
+		colors == other.colors;
+}
+
+size_t Palette_Cache::make_palettes(const Tile *tiles, size_t n, size_t max_colors, size_t max_palettes,
+	bool use_color_zero, Fl_Color color_zero, uint8_t start_index, Palettes &palettes, std::vector<int> &tile_palettes) {
+	Key key = {n, max_colors, max_palettes, palettes.size(), use_color_zero, use_color_zero ? color_zero : 0,
+		start_index, tile_palettes, {}};
+	key.colors.reserve(n * NUM_TILE_PIXELS);
+	for (size_t i = 0; i < n; i++) {
+		key.colors.insert(key.colors.end(), std::begin(tiles[i]), std::end(tiles[i]));
+	}
+	// FNV-1a of the key, to find its solution without comparing it to every other key
+	uint64_t h = 0xCBF29CE484222325ULL;
+	auto mix = [&h](uint64_t v) { h = (h ^ v) * 0x100000001B3ULL; };
+	mix(n);
+	mix(max_colors);
+	mix(max_palettes);
+	mix(key.num_palettes);
+	mix(use_color_zero ? key.color_zero : 1);
+	mix(start_index);
+	for (int p : tile_palettes) {
+		mix((uint64_t)p);
+	}
+	for (Fl_Color c : key.colors) {
+		mix(c);
+	}
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (auto it = _index.find(h); it != _index.end() && it->second->key == key) {
+			_solutions.splice(_solutions.begin(), _solutions, it->second);
+			palettes = it->second->palettes;
+			tile_palettes = it->second->tile_palettes;
+			return it->second->qi;
+		}
+	}
+	size_t qi = ::make_palettes(tiles, n, max_colors, max_palettes, use_color_zero, color_zero, start_index, palettes,
+		tile_palettes);
+	// The key's colors are most of a solution's size
+	size_t bytes = sizeof(Solution) + key.colors.size() * sizeof(Fl_Color) +
+		(key.tile_palettes.size() + tile_palettes.size()) * sizeof(int);
+	for (const Palette &p : palettes) {
+		bytes += sizeof(Palette) + p.size() * sizeof(Fl_Color);
+	}
+	if (bytes > MAX_PALETTE_CACHE_BYTES) { return qi; }
+	std::lock_guard<std::mutex> lock(_mutex);
+	// Replaces a colliding solution, or the same one if another thread found it meanwhile
+	if (auto it = _index.find(h); it != _index.end()) {
+		_bytes -= it->second->bytes;
+		_solutions.erase(it->second);
+		_index.erase(it);
+	}
+	_solutions.push_front({h, bytes, std::move(key), qi, palettes, tile_palettes});
+	_index[h] = _solutions.begin();
+	_bytes += bytes;
+	while (_bytes > MAX_PALETTE_CACHE_BYTES) {
+		_bytes -= _solutions.back().bytes;
+		_index.erase(_solutions.back().hash);
+		_solutions.pop_back();
+	}
+	return qi;
+}
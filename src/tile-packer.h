@@ -0,0 +1,63 @@
+#ifndef TILE_PACKER_H
+#define TILE_PACKER_H
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "tilemap-format.h"
+#include "tile.h"
+
+#define MAX_PALETTE_CACHE_BYTES 0x4000000 // 64 MiB
+
+// Perceived brightness of a color, from 0 to 255
+double luminance(Fl_Color c);
+
+// Groups the colors of n tiles into as few palettes of max_colors as possible, brightest color first and padded
+// with black, after start_index palettes (or colors, for a single palette) of padding. Assigns each tile in
+// tile_palettes to the first palette holding all its colors. Returns the index of the first tile with more than
+// max_colors colors, or n if they all fit; the caller checks the palette count against the format's limit.
+size_t make_palettes(const Tile *tiles, size_t n, size_t max_colors, size_t max_palettes, bool use_color_zero,
+	Fl_Color color_zero, uint8_t start_index, Palettes &palettes, std::vector<int> &tile_palettes);
+
+// Remembers recent make_palettes results by the tiles' colors and the other arguments, so a long-running server
+// converting the same images again can skip the search; the least recently used results are forgotten once
+// they take more than MAX_PALETTE_CACHE_BYTES
+class Palette_Cache {
+private:
+	// Everything make_palettes reads, compared on a hit so that a hash collision is just a miss
+	struct Key {
+		size_t n, max_colors, max_palettes, num_palettes;
+		bool use_color_zero;
+		Fl_Color color_zero;
+		uint8_t start_index;
+		std::vector<int> tile_palettes;
+		std::vector<Fl_Color> colors;
+		bool operator==(const Key &other) const;
+	};
+	struct Solution {
+		uint64_t hash;
+		size_t bytes;
+		Key key;
+		size_t qi;
+		Palettes palettes;
+		std::vector<int> tile_palettes;
+	};
+	std::mutex _mutex;
+	// Most recently used first
+	std::list<Solution> _solutions;
+	std::unordered_map<uint64_t, std::list<Solution>::iterator> _index;
+	size_t _bytes = 0;
+public:
+	size_t make_palettes(const Tile *tiles, size_t n, size_t max_colors, size_t max_palettes, bool use_color_zero,
+		Fl_Color color_zero, uint8_t start_index, Palettes &palettes, std::vector<int> &tile_palettes);
+};
+
+// Makes a tilemap entry for each of n tiles, adding the tiles to tileset (as indexes into tiles) unless an identical
+// tile, or a flipped one if allowed, is already there. Returns false if the tileset outgrows the format.
+bool pack_tiles(const Tile *tiles, size_t n, const std::vector<int> &tile_palettes, Tilemap_Format fmt, bool allow_unique,
+	bool allow_flip, uint16_t start_id, bool use_blank, uint16_t blank_id, Fl_Color blank_color,
+	std::vector<Tilemap_Entry> &entries, std::vector<size_t> &tileset);
+
+#endif
@@ -1,53 +1,33 @@
 #include "tile-selection.h"
-#include "widgets.h"
 #include "config.h"
 
-void Tile_Selection::draw_selection_border_at(Groupable *t) const {
-	if (!_tile1 || !_tile2) { return; }
-	Workspace *p = (Workspace *)t->parent();
-	if (!p) { return; }
-	int pw = p->w() - (p->has_y_scroll() ? Fl::scrollbar_size() : 0);
-	int ph = p->h() - (p->has_x_scroll() ? Fl::scrollbar_size() : 0);
-	int tx = t == _tile1 ? std::min(_tile1->x(), _tile2->x()) : t->x();
-	int ty = t == _tile1 ? std::min(_tile1->y(), _tile2->y()) : t->y();
-	int tw = t->w() * (int)width(), th = t->h() * (int)height();
+void Tile_Selection::draw_selection_border_at(int x, int y, int s) const {
+	if (!selected_multiple()) { return; }
+	int tw = s * (int)width(), th = s * (int)height();
 	bool zoom = !_from_tileset && Config::zoom() > 5;
-	fl_push_clip(p->x(), p->y(), pw, ph);
-	draw_selection_border(tx, ty, tw, th, FL_WHITE, zoom);
-	fl_pop_clip();
+	draw_selection_border(x, y, tw, th, FL_WHITE, zoom);
 }
 
-void Tile_Selection::select_single(Tile_Button *tb) {
-	_tile1 = tb;
-	_tile2 = NULL;
+void Tile_Selection::select_single(const Tile_Cell &c) {
+	_tile1 = c;
+	_selected = true;
+	_multiple = false;
 	_dragging = false;
 	_from_tileset = true;
-	tb->setonly();
 }
 
-void Tile_Selection::start_selecting(Tile_Tessera *tt) {
-	_tile1 = tt;
-	_tile2 = tt;
+void Tile_Selection::start_selecting(const Tile_Cell &c, bool from_tileset) {
+	_tile1 = c;
+	_tile2 = c;
+	_selected = true;
+	_multiple = true;
 	_dragging = true;
-	_from_tileset = false;
-}
-
-void Tile_Selection::start_selecting(Tile_Button *tb) {
-	_tile1 = tb;
-	_tile2 = tb;
-	_dragging = true;
-	_from_tileset = true;
+	_from_tileset = from_tileset;
 }
 
 void Tile_Selection::finish_selecting() {
 	_dragging = false;
-	if (_tile1 == _tile2) {
-		_tile2 = NULL;
-	}
-	if (_tile1) {
-		_tile1->redraw();
-	}
-	if (_tile2) {
-		_tile2->redraw();
+	if (_multiple && _tile1.same_place(_tile2)) {
+		_multiple = false;
 	}
 }
@@ -1,12 +1,7 @@
 #ifndef TILE_H
 #define TILE_H
 
-#pragma warning(push, 0)
-#include <FL/Fl_RGB_Image.H>
-#pragma warning(pop)
-
-#include "config.h"
-#include "tileset.h"
+#include "core.h"
 
 #define TILE_SIZE 8
 #define NUM_TILE_PIXELS (TILE_SIZE * TILE_SIZE)
@@ -17,7 +12,8 @@
 typedef Fl_Color Tile[NUM_TILE_PIXELS];
 
 bool is_blank_tile(const Tile &tile, Fl_Color blank_color);
-bool are_identical_tiles(const Tile &t1, const Tile &t2, bool allow_flip, bool &x_flip, bool &y_flip);
-Tile *get_image_tiles(Fl_RGB_Image *img, size_t &n, size_t &iw, bool alt_norm, Fl_Color blank_color);
+// Splits w x h pixels of d bytes each, with rows ld bytes apart (or w * d if ld is 0), into tiles
+Tile *get_image_tiles(const uchar *data, size_t w, size_t h, int d, int ld, size_t &n, size_t &iw, bool alt_norm,
+	Fl_Color blank_color);
 
 #endif
@@ -1,13 +1,7 @@
 #include <cstring>
-
-#pragma warning(push, 0)
-#include <FL/filename.H>
-#pragma warning(pop)
+#include <algorithm>
 
 #include "tilemap-format.h"
-#include "tile-buttons.h"
-#include "config.h"
-#include "utils.h"
 
 static const int tileset_sizes[NUM_FORMATS] = {
 	0x100, // PLAIN - 8-bit tile IDs
@@ -134,12 +128,37 @@ const char *format_name(Tilemap_Format fmt) {
 	return format_names[(int)fmt];
 }
 
-int format_max_name_width() {
-	int mw = 0;
-	for (const char *fmt_name : format_names) {
-		mw = std::max(mw, text_width(fmt_name, 6));
+static const char *format_short_names[NUM_FORMATS] = {
+	"plain",         // PLAIN
+	"gbc-attrs",     // GBC_ATTRS
+	"gbc-attrmap",   // GBC_ATTRMAP
+	"gba-4bpp",      // GBA_4BPP
+	"gba-8bpp",      // GBA_8BPP
+	"nds-4bpp",      // NDS_4BPP
+	"nds-8bpp",      // NDS_8BPP
+	"sgb-border",    // SGB_BORDER
+	"snes-attrs",    // SNES_ATTRS
+	"genesis",       // GENESIS
+	"tg16",          // TG16
+	"rby-town-map",  // RBY_TOWN_MAP
+	"gsc-town-map",  // GSC_TOWN_MAP
+	"pc-town-map",   // PC_TOWN_MAP
+	"sw-town-map",   // SW_TOWN_MAP
+	"pokegear-card", // POKEGEAR_CARD
+};
+
+const char *format_short_name(Tilemap_Format fmt) {
+	return format_short_names[(int)fmt];
+}
+
+bool format_from_short_name(const char *name, Tilemap_Format &fmt) {
+	for (int i = 0; i < NUM_FORMATS; i++) {
+		if (!strcmp(name, format_short_names[i])) {
+			fmt = (Tilemap_Format)i;
+			return true;
+		}
 	}
-	return mw;
+	return false;
 }
 
 static const char *format_extensions[NUM_FORMATS] = {
@@ -190,97 +209,326 @@ int format_bytes_per_tile(Tilemap_Format fmt) {
 	}
 }
 
-Tilemap_Format guess_format(const char *filename) {
-	size_t fs = file_size(filename);
-	const char *basename = fl_filename_name(filename);
-	std::string s(basename);
-	char attrmap_name[FL_PATH_MAX] = {};
-	strcpy(attrmap_name, filename);
-	fl_filename_setext(attrmap_name, sizeof(attrmap_name), ATTRMAP_EXT);
+const char *tilemap_error_message(Tilemap_Result result) {
+	switch (result) {
+	case Tilemap_Result::TILEMAP_OK:
+		return "OK.";
+	case Tilemap_Result::TILEMAP_BAD_FILE:
+	case Tilemap_Result::ATTRMAP_BAD_FILE:
+		return "Cannot open file.";
+	case Tilemap_Result::TILEMAP_EMPTY:
+		return "Tilemap is empty.";
+	case Tilemap_Result::TILEMAP_TOO_SHORT_FF:
+		return "File ends before any $FF.";
+	case Tilemap_Result::TILEMAP_TOO_LONG_FF:
+		return "File continues after $FF.";
+	case Tilemap_Result::TILEMAP_TOO_SHORT_00:
+		return "File ends before any $00.";
+	case Tilemap_Result::TILEMAP_TOO_LONG_00:
+		return "File continues after $00.";
+	case Tilemap_Result::TILEMAP_TOO_SHORT_RLE:
+		return "File ends before RLE value.";
+	case Tilemap_Result::TILEMAP_TOO_SHORT_ATTRS:
+		return "File ends before attribute value.";
+	case Tilemap_Result::TILEMAP_INVALID:
+	case Tilemap_Result::ATTRMAP_INVALID:
+		return "Cannot parse file format.";
+	case Tilemap_Result::TILEMAP_NULL:
+		return "No file chosen.";
+	case Tilemap_Result::ATTRMAP_TOO_SHORT:
+		return "Attrmap is shorter than tilemap.";
+	case Tilemap_Result::ATTRMAP_TOO_LONG:
+		return "Attrmap is longer than tilemap.";
+	default:
+		return "Unspecified error.";
+	}
+}
+
+Tilemap_Result decode_tilemap(const std::vector<uchar> &tbytes, const std::vector<uchar> &abytes, Tilemap_Format fmt,
+	std::vector<Tilemap_Entry> &tiles, size_t &width) {
+	tiles.clear();
+	width = 0;
+	size_t c = tbytes.size();
+	if (c == 0) { return Tilemap_Result::TILEMAP_EMPTY; }
 
-	if (file_exists(attrmap_name)) {
-		return Tilemap_Format::GBC_ATTRMAP;
+	if (fmt == Tilemap_Format::PLAIN) {
+		tiles.reserve(c);
+		for (size_t i = 0; i < c; i++) {
+			uint16_t b = tbytes[i];
+			tiles.emplace_back(b);
+		}
+	}
+
+	else if (fmt == Tilemap_Format::GBC_ATTRS) {
+		if (c % 2) { return Tilemap_Result::TILEMAP_TOO_SHORT_ATTRS; }
+		tiles.reserve(c / 2);
+		for (size_t i = 0; i < c; i += 2) {
+			uint16_t v = tbytes[i];
+			uchar a = tbytes[i+1];
+			if (!!(a & 0x08)) { v |= 0x100; }
+			bool x_flip = !!(a & 0x20), y_flip = !!(a & 0x40), priority = !!(a & 0x80), obp1 = !!(a & 0x10);
+			int palette = a & 0x07;
+			tiles.emplace_back(v, x_flip, y_flip, priority, obp1, palette);
+		}
 	}
-	if (starts_with_ignore_case(s, "sgb") || fs == SGB_WIDTH * SGB_HEIGHT * 2 ||
-		fs == SGB_WIDTH * SGB_HEIGHT * 2 - GAME_BOY_WIDTH * GAME_BOY_HEIGHT * 2) {
-		return Tilemap_Format::SGB_BORDER;
+
+	else if (fmt == Tilemap_Format::GBC_ATTRMAP) {
+		size_t ac = abytes.size();
+		if (ac != c) { return ac < c ? Tilemap_Result::ATTRMAP_TOO_SHORT : Tilemap_Result::ATTRMAP_TOO_LONG; }
+		tiles.reserve(c);
+		for (size_t i = 0; i < c; i++) {
+			uint16_t v = tbytes[i];
+			uchar a = abytes[i];
+			if (!!(a & 0x08)) { v |= 0x100; }
+			bool x_flip = !!(a & 0x20), y_flip = !!(a & 0x40), priority = !!(a & 0x80), obp1 = !!(a & 0x10);
+			int palette = a & 0x07;
+			tiles.emplace_back(v, x_flip, y_flip, priority, obp1, palette);
+		}
 	}
-	if (ends_with_ignore_case(s, ".tilemap.rle")) {
-		return Tilemap_Format::POKEGEAR_CARD;
+
+	else if (fmt == Tilemap_Format::GBA_4BPP) {
+		if (c % 2) { return Tilemap_Result::TILEMAP_TOO_SHORT_ATTRS; }
+		tiles.reserve(c / 2);
+		for (size_t i = 0; i < c; i += 2) {
+			uint16_t v = tbytes[i];
+			uchar a = tbytes[i+1];
+			v = v | ((a & 0x03) << 8);
+			bool x_flip = !!(a & 0x04), y_flip = !!(a & 0x08);
+			int palette = HI_NYB(a);
+			tiles.emplace_back(v, x_flip, y_flip, false, false, palette);
+		}
 	}
-	if (ends_with_ignore_case(s, ".rle")) {
-		return Tilemap_Format::RBY_TOWN_MAP;
+
+	else if (fmt == Tilemap_Format::GBA_8BPP) {
+		if (c % 2) { return Tilemap_Result::TILEMAP_TOO_SHORT_ATTRS; }
+		tiles.reserve(c / 2);
+		for (size_t i = 0; i < c; i += 2) {
+			uint16_t v = tbytes[i];
+			uchar a = tbytes[i+1];
+			v = v | ((a & 0x03) << 8);
+			bool x_flip = !!(a & 0x04), y_flip = !!(a & 0x08);
+			tiles.emplace_back(v, x_flip, y_flip, false, false, 0);
+		}
+	}
+
+	else if (fmt == Tilemap_Format::NDS_4BPP) {
+		if (c % 2) { return Tilemap_Result::TILEMAP_TOO_SHORT_ATTRS; }
+		tiles.reserve((c - NDS_HEADER_SIZE) / 2);
+		for (size_t i = NDS_HEADER_SIZE; i < c; i += 2) {
+			uint16_t v = tbytes[i];
+			uchar a = tbytes[i+1];
+			v = v | ((a & 0x03) << 8);
+			bool x_flip = !!(a & 0x04), y_flip = !!(a & 0x08);
+			int palette = HI_NYB(a);
+			tiles.emplace_back(v, x_flip, y_flip, false, false, palette);
+		}
+		width = NDS_WIDTH;
+	}
+
+	else if (fmt == Tilemap_Format::NDS_8BPP) {
+		if (c % 2) { return Tilemap_Result::TILEMAP_TOO_SHORT_ATTRS; }
+		tiles.reserve((c - NDS_HEADER_SIZE) / 2);
+		for (size_t i = NDS_HEADER_SIZE; i < c; i += 2) {
+			uint16_t v = tbytes[i];
+			uchar a = tbytes[i+1];
+			v = v | ((a & 0x03) << 8);
+			bool x_flip = !!(a & 0x04), y_flip = !!(a & 0x08);
+			tiles.emplace_back(v, x_flip, y_flip, false, false, 0);
+		}
+		width = NDS_WIDTH;
+	}
+
+	else if (fmt == Tilemap_Format::SGB_BORDER) {
+		if (c % 2) { return Tilemap_Result::TILEMAP_TOO_SHORT_ATTRS; }
+		tiles.reserve(c / 2);
+		for (size_t i = 0; i < c; i += 2) {
+			uint16_t v = tbytes[i];
+			uchar a = tbytes[i+1];
+			bool x_flip = !!(a & 0x40), y_flip = !!(a & 0x80);
+			int palette = (a & 0x0C) >> 2;
+			tiles.emplace_back(v, x_flip, y_flip, false, false, palette);
+		}
+		width = SGB_WIDTH;
+	}
+
+	else if (fmt == Tilemap_Format::SNES_ATTRS) {
+		if (c % 2) { return Tilemap_Result::TILEMAP_TOO_SHORT_ATTRS; }
+		tiles.reserve(c / 2);
+		for (size_t i = 0; i < c; i += 2) {
+			uint16_t v = tbytes[i];
+			uchar a = tbytes[i+1];
+			v = v | ((a & 0x03) << 8);
+			bool x_flip = !!(a & 0x40), y_flip = !!(a & 0x80), priority = !!(a & 0x20);
+			int palette = (a & 0x1C) >> 2;
+			tiles.emplace_back(v, x_flip, y_flip, priority, false, palette);
+		}
+	}
+
+	else if (fmt == Tilemap_Format::TG16) {
+		if (c % 2) { return Tilemap_Result::TILEMAP_TOO_SHORT_ATTRS; }
+		tiles.reserve(c / 2);
+		for (size_t i = 0; i < c; i += 2) {
+			uint16_t v = tbytes[i];
+			uchar a = tbytes[i+1];
+			v = v | ((a & 0x07) << 8);
+			int palette = HI_NYB(a);
+			tiles.emplace_back(v, false, false, false, false, palette);
+		}
 	}
-	if (s == "johto.bin" || s == "kanto.bin" ||
-		fs == GAME_BOY_WIDTH * GAME_BOY_HEIGHT + 1) {
-		return Tilemap_Format::GSC_TOWN_MAP;
+
+	else if (fmt == Tilemap_Format::GENESIS) {
+		if (c % 2) { return Tilemap_Result::TILEMAP_TOO_SHORT_ATTRS; }
+		tiles.reserve(c / 2);
+		for (size_t i = 0; i < c; i += 2) {
+			uchar a = tbytes[i];
+			uint16_t v = tbytes[i+1];
+			v = v | ((a & 0x07) << 8);
+			bool x_flip = !!(a & 0x08), y_flip = !!(a & 0x10), priority = !!(a & 0x80);
+			int palette = (a & 0x60) >> 5;
+			tiles.emplace_back(v, x_flip, y_flip, priority, false, palette);
+		}
 	}
-	if (ends_with_ignore_case(s, ".rcsn") || ends_with_ignore_case(s, ".nscr") || fs == 0x624 || fs == 0x824) {
-		return Tilemap_Format::NDS_4BPP;
+
+	else if (fmt == Tilemap_Format::RBY_TOWN_MAP) {
+		tiles.reserve(c);
+		for (size_t i = 0; i < c - 1; i++) {
+			uchar b = tbytes[i];
+			if (b == 0x00) {
+				return Tilemap_Result::TILEMAP_TOO_LONG_00;
+			}
+			uint16_t v = HI_NYB(b), r = LO_NYB(b);
+			for (uint16_t j = 0; j < r; j++) {
+				tiles.emplace_back(v);
+			}
+		}
+		if (tbytes[c-1] != 0x00) {
+			return Tilemap_Result::TILEMAP_TOO_SHORT_00;
+		}
+		width = GAME_BOY_WIDTH;
 	}
-	if (ends_with_ignore_case(s, ".kmp") || fs % 2 ||
-		fs > GAME_BOY_VRAM_SIZE * GAME_BOY_VRAM_SIZE * 2) {
-		return Tilemap_Format::PLAIN;
+
+	else if (fmt == Tilemap_Format::GSC_TOWN_MAP) {
+		tiles.reserve(c);
+		for (size_t i = 0; i < c - 1; i++) {
+			uint16_t b = tbytes[i];
+			if (b == 0xFF) {
+				return Tilemap_Result::TILEMAP_TOO_LONG_FF;
+			}
+			tiles.emplace_back(b);
+		}
+		if (tbytes[c-1] != 0xFF) {
+			return Tilemap_Result::TILEMAP_TOO_SHORT_FF;
+		}
+		width = GAME_BOY_WIDTH;
 	}
-	if (fs == GBA_WIDTH * GBA_HEIGHT * 2 ||
-		fs == GAME_BOY_VRAM_SIZE * GBA_HEIGHT * 2) {
-		return Tilemap_Format::GBA_4BPP;
+
+	else if (fmt == Tilemap_Format::PC_TOWN_MAP) {
+		tiles.reserve(c);
+		for (size_t i = 0; i < c - 1; i++) {
+			uchar b = tbytes[i];
+			if (b == 0xFF) {
+				return Tilemap_Result::TILEMAP_TOO_LONG_FF;
+			}
+			bool x_flip = !!(b & 0x40), y_flip = !!(b & 0x80);
+			uint16_t v = b & 0x3F;
+			tiles.emplace_back(v, x_flip, y_flip);
+		}
+		if (tbytes[c-1] != 0xFF) {
+			return Tilemap_Result::TILEMAP_TOO_SHORT_FF;
+		}
+		width = GAME_BOY_WIDTH;
 	}
-	if (fs >= GAME_BOY_WIDTH * GAME_BOY_HEIGHT * 2 &&
-		fs < GAME_BOY_VRAM_SIZE * GBA_HEIGHT * 2) {
-		return Tilemap_Format::GBC_ATTRS;
+
+	else if (fmt == Tilemap_Format::SW_TOWN_MAP) {
+		tiles.reserve(c);
+		if (!(c % 2)) { return Tilemap_Result::TILEMAP_TOO_SHORT_00; }
+		for (size_t i = 0; i < c - 1; i += 2) {
+			uint16_t v = tbytes[i];
+			if (v == 0x00) {
+				return Tilemap_Result::TILEMAP_TOO_LONG_00;
+			}
+			uint16_t r = tbytes[i+1];
+			if (r == 0x00) {
+				return Tilemap_Result::TILEMAP_TOO_LONG_00;
+			}
+			for (uint16_t j = 0; j < r; j++) {
+				tiles.emplace_back(v);
+			}
+		}
+		if (tbytes[c-1] != 0x00) {
+			return Tilemap_Result::TILEMAP_TOO_SHORT_00;
+		}
+		width = GAME_BOY_WIDTH;
 	}
-	Tilemap_Format fmt = Config::format();
-	if (fmt == Tilemap_Format::SGB_BORDER || fmt == Tilemap_Format::GBC_ATTRS || fmt == Tilemap_Format::GBA_4BPP ||
-		fmt == Tilemap_Format::GBA_8BPP || fmt == Tilemap_Format::NDS_4BPP || fmt == Tilemap_Format::NDS_8BPP ||
-		fmt == Tilemap_Format::SNES_ATTRS || fmt == Tilemap_Format::GENESIS || fmt == Tilemap_Format::TG16) {
-		return fmt;
+
+	else if (fmt == Tilemap_Format::POKEGEAR_CARD) {
+		tiles.reserve(c);
+		if (!(c % 2)) { return Tilemap_Result::TILEMAP_TOO_SHORT_FF; }
+		for (size_t i = 0; i < c - 1; i += 2) {
+			uint16_t v = tbytes[i];
+			if (v == 0xFF) {
+				return Tilemap_Result::TILEMAP_TOO_LONG_FF;
+			}
+			uint16_t r = tbytes[i+1];
+			if (r == 0xFF) {
+				return Tilemap_Result::TILEMAP_TOO_LONG_FF;
+			}
+			for (uint16_t j = 0; j < r; j++) {
+				tiles.emplace_back(v);
+			}
+		}
+		if (tbytes[c-1] != 0xFF) {
+			return Tilemap_Result::TILEMAP_TOO_SHORT_FF;
+		}
+		width = GAME_BOY_WIDTH;
 	}
-	return Tilemap_Format::PLAIN;
+
+	if (tiles.empty()) { return Tilemap_Result::TILEMAP_EMPTY; }
+	return Tilemap_Result::TILEMAP_OK;
 }
 
-std::vector<uchar> make_tilemap_bytes(const std::vector<Tile_Tessera *> &tiles, Tilemap_Format fmt, size_t width, size_t height) {
+std::vector<uchar> make_tilemap_bytes(const std::vector<Tilemap_Entry> &tiles, Tilemap_Format fmt, size_t width, size_t height) {
 	std::vector<uchar> bytes;
 	size_t n = tiles.size();
 
 	if (fmt == Tilemap_Format::PLAIN || fmt == Tilemap_Format::GSC_TOWN_MAP || fmt == Tilemap_Format::PC_TOWN_MAP) {
 		bytes.reserve(n + 1);
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)tt->id();
-			if (tt->x_flip()) { v |= 0x40; }
-			if (tt->y_flip()) { v |= 0x80; }
+		for (const Tilemap_Entry &tt : tiles) {
+			uchar v = (uchar)tt.id;
+			if (tt.x_flip) { v |= 0x40; }
+			if (tt.y_flip) { v |= 0x80; }
 			bytes.push_back(v);
 		}
 	}
 	else if (fmt == Tilemap_Format::GBC_ATTRS) {
 		bytes.reserve(n * 2);
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)(tt->id() & 0xFF);
+		for (const Tilemap_Entry &tt : tiles) {
+			uchar v = (uchar)(tt.id & 0xFF);
 			bytes.push_back(v);
 			uchar a = 0;
-			if (tt->id() & 0x100) { a |= 0x08; }
-			if (tt->obp1())     { a |= 0x10; }
-			if (tt->priority()) { a |= 0x80; }
-			if (tt->x_flip())   { a |= 0x20; }
-			if (tt->y_flip())   { a |= 0x40; }
-			if (tt->palette() > -1) { a |= tt->palette() & 0x07; }
+			if (tt.id & 0x100) { a |= 0x08; }
+			if (tt.obp1)     { a |= 0x10; }
+			if (tt.priority) { a |= 0x80; }
+			if (tt.x_flip)   { a |= 0x20; }
+			if (tt.y_flip)   { a |= 0x40; }
+			if (tt.palette > -1) { a |= tt.palette & 0x07; }
 			bytes.push_back(a);
 		}
 	}
 	else if (fmt == Tilemap_Format::GBC_ATTRMAP) {
 		bytes.reserve(n * 2);
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)(tt->id() & 0xFF);
+		for (const Tilemap_Entry &tt : tiles) {
+			uchar v = (uchar)(tt.id & 0xFF);
 			bytes.push_back(v);
 		}
-		for (Tile_Tessera *tt : tiles) {
+		for (const Tilemap_Entry &tt : tiles) {
 			uchar a = 0;
-			if (tt->id() & 0x100) { a |= 0x08; }
-			if (tt->obp1())     { a |= 0x10; }
-			if (tt->priority()) { a |= 0x80; }
-			if (tt->x_flip())   { a |= 0x20; }
-			if (tt->y_flip())   { a |= 0x40; }
-			if (tt->palette() > -1) { a |= tt->palette() & 0x07; }
+			if (tt.id & 0x100) { a |= 0x08; }
+			if (tt.obp1)     { a |= 0x10; }
+			if (tt.priority) { a |= 0x80; }
+			if (tt.x_flip)   { a |= 0x20; }
+			if (tt.y_flip)   { a |= 0x40; }
+			if (tt.palette > -1) { a |= tt.palette & 0x07; }
 			bytes.push_back(a);
 		}
 	}
@@ -309,70 +557,70 @@ std::vector<uchar> make_tilemap_bytes(const std::vector<Tile_Tessera *> &tiles,
 			};
 			bytes.insert(bytes.begin(), RANGE(header));
 		}
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)(tt->id() & 0xFF);
+		for (const Tilemap_Entry &tt : tiles) {
+			uchar v = (uchar)(tt.id & 0xFF);
 			bytes.push_back(v);
-			uchar a = (tt->id() >> 8) & 0x03;
-			if (tt->x_flip()) { a |= 0x04; }
-			if (tt->y_flip()) { a |= 0x08; }
-			if (tt->palette() > -1) { a |= (tt->palette() << 4) & 0xF0; }
+			uchar a = (tt.id >> 8) & 0x03;
+			if (tt.x_flip) { a |= 0x04; }
+			if (tt.y_flip) { a |= 0x08; }
+			if (tt.palette > -1) { a |= (tt.palette << 4) & 0xF0; }
 			bytes.push_back(a);
 		}
 	}
 	else if (fmt == Tilemap_Format::GENESIS) {
 		bytes.reserve(n * 2);
-		for (Tile_Tessera *tt : tiles) {
-			uchar a = (tt->id() >> 8) & 0x07;
-			if (tt->priority()) { a |= 0x80; }
-			if (tt->x_flip())   { a |= 0x08; }
-			if (tt->y_flip())   { a |= 0x10; }
-			if (tt->palette() > -1) { a |= (tt->palette() << 5) & 0x60; }
+		for (const Tilemap_Entry &tt : tiles) {
+			uchar a = (tt.id >> 8) & 0x07;
+			if (tt.priority) { a |= 0x80; }
+			if (tt.x_flip)   { a |= 0x08; }
+			if (tt.y_flip)   { a |= 0x10; }
+			if (tt.palette > -1) { a |= (tt.palette << 5) & 0x60; }
 			bytes.push_back(a);
-			uchar v = (uchar)(tt->id() & 0xFF);
+			uchar v = (uchar)(tt.id & 0xFF);
 			bytes.push_back(v);
 		}
 	}
 	else if (fmt == Tilemap_Format::TG16) {
 		bytes.reserve(n * 2);
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)(tt->id() & 0xFF);
+		for (const Tilemap_Entry &tt : tiles) {
+			uchar v = (uchar)(tt.id & 0xFF);
 			bytes.push_back(v);
-			uchar a = (tt->id() >> 8) & 0x07;
-			if (tt->palette() > -1) { a |= (tt->palette() << 4) & 0xF0; }
+			uchar a = (tt.id >> 8) & 0x07;
+			if (tt.palette > -1) { a |= (tt.palette << 4) & 0xF0; }
 			bytes.push_back(a);
 		}
 	}
 	else if (fmt == Tilemap_Format::SGB_BORDER) {
 		bytes.reserve(n * 2);
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)(tt->id() & 0xFF);
+		for (const Tilemap_Entry &tt : tiles) {
+			uchar v = (uchar)(tt.id & 0xFF);
 			bytes.push_back(v);
 			uchar a = 0x10;
-			if (tt->x_flip()) { a |= 0x40; }
-			if (tt->y_flip()) { a |= 0x80; }
-			if (tt->palette() > -1) { a |= (tt->palette() << 2) & 0x0C; }
+			if (tt.x_flip) { a |= 0x40; }
+			if (tt.y_flip) { a |= 0x80; }
+			if (tt.palette > -1) { a |= (tt.palette << 2) & 0x0C; }
 			bytes.push_back(a);
 		}
 	}
 	else if (fmt == Tilemap_Format::SNES_ATTRS) {
 		bytes.reserve(n * 2);
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)(tt->id() & 0xFF);
+		for (const Tilemap_Entry &tt : tiles) {
+			uchar v = (uchar)(tt.id & 0xFF);
 			bytes.push_back(v);
-			uchar a = (tt->id() >> 8) & 0x03;
-			if (tt->priority()) { a |= 0x20; }
-			if (tt->x_flip())   { a |= 0x40; }
-			if (tt->y_flip())   { a |= 0x80; }
-			if (tt->palette() > -1) { a |= (tt->palette() << 2) & 0x1C; }
+			uchar a = (tt.id >> 8) & 0x03;
+			if (tt.priority) { a |= 0x20; }
+			if (tt.x_flip)   { a |= 0x40; }
+			if (tt.y_flip)   { a |= 0x80; }
+			if (tt.palette > -1) { a |= (tt.palette << 2) & 0x1C; }
 			bytes.push_back(a);
 		}
 	}
 	else if (fmt == Tilemap_Format::RBY_TOWN_MAP) {
 		bytes.reserve(n);
 		for (size_t i = 0; i < n;) {
-			Tile_Tessera *tt = tiles[i++];
-			uchar v = (uchar)tt->id(), r = 1;
-			while (i < n && (uchar)tiles[i]->id() == v) {
+			const Tilemap_Entry &tt = tiles[i++];
+			uchar v = (uchar)tt.id, r = 1;
+			while (i < n && (uchar)tiles[i].id == v) {
 				i++;
 				if (++r == 0x0F) { break; } // maximum nybble
 			}
@@ -383,9 +631,9 @@ std::vector<uchar> make_tilemap_bytes(const std::vector<Tile_Tessera *> &tiles,
 	else if (fmt == Tilemap_Format::POKEGEAR_CARD || fmt == Tilemap_Format::SW_TOWN_MAP) {
 		bytes.reserve(n + 1);
 		for (size_t i = 0; i < n;) {
-			Tile_Tessera *tt = tiles[i++];
-			uchar v = (uchar)tt->id(), r = 1;
-			while (i < n && (uchar)tiles[i]->id() == v) {
+			const Tilemap_Entry &tt = tiles[i++];
+			uchar v = (uchar)tt.id, r = 1;
+			while (i < n && (uchar)tiles[i].id == v) {
 				i++;
 				if (++r == 0xFF) { break; } // maximum byte
 			}
@@ -403,3 +651,25 @@ std::vector<uchar> make_tilemap_bytes(const std::vector<Tile_Tessera *> &tiles,
 
 	return bytes;
 }
+
+bool write_tilemap_bytes(const char *tf, const char *af, const std::vector<uchar> &bytes, Tilemap_Format fmt) {
+	FILE *file = open_file(tf, "wb");
+	if (!file) { return false; }
+
+	if (fmt == Tilemap_Format::GBC_ATTRMAP) {
+		FILE *attr_file = open_file(af, "wb");
+		if (!attr_file) { fclose(file); return false; }
+
+		size_t nb = bytes.size() / 2;
+		fwrite(bytes.data(), 1, nb, file);
+		fwrite(bytes.data() + nb, 1, nb, attr_file);
+
+		fclose(attr_file);
+	}
+	else {
+		fwrite(bytes.data(), 1, bytes.size(), file);
+	}
+
+	fclose(file);
+	return true;
+}
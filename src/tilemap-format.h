@@ -3,9 +3,7 @@
 
 #include <vector>
 
-#pragma warning(push, 0)
-#include <FL/fl_types.h>
-#pragma warning(pop)
+#include "core.h"
 
 #define GAME_BOY_WIDTH 20
 #define GAME_BOY_HEIGHT 18
@@ -83,14 +81,33 @@ int format_palettes_size(Tilemap_Format fmt);
 int format_palette_size(Tilemap_Format fmt);
 int format_color_depth(Tilemap_Format fmt);
 const char *format_name(Tilemap_Format fmt);
+const char *format_short_name(Tilemap_Format fmt);
+bool format_from_short_name(const char *name, Tilemap_Format &fmt);
 const char *format_extension(Tilemap_Format fmt);
-int format_max_name_width(void);
 int format_bytes_per_tile(Tilemap_Format fmt);
 
-Tilemap_Format guess_format(const char *filename);
-
-class Tile_Tessera;
-
-std::vector<uchar> make_tilemap_bytes(const std::vector<Tile_Tessera *> &tiles, Tilemap_Format fmt, size_t width, size_t height);
+enum class Tilemap_Result { TILEMAP_OK, TILEMAP_BAD_FILE, TILEMAP_EMPTY, TILEMAP_TOO_SHORT_FF, TILEMAP_TOO_LONG_FF,
+	TILEMAP_TOO_SHORT_00, TILEMAP_TOO_LONG_00, TILEMAP_TOO_SHORT_RLE, TILEMAP_TOO_SHORT_ATTRS, TILEMAP_INVALID,
+	TILEMAP_NULL, ATTRMAP_BAD_FILE, ATTRMAP_TOO_SHORT, ATTRMAP_TOO_LONG, ATTRMAP_INVALID };
+
+const char *tilemap_error_message(Tilemap_Result result);
+
+// One tilemap cell as a file stores it
+struct Tilemap_Entry {
+	uint16_t id;
+	bool x_flip, y_flip, priority, obp1;
+	int palette;
+	inline Tilemap_Entry(uint16_t id_ = 0x000, bool x_flip_ = false, bool y_flip_ = false, bool priority_ = false,
+		bool obp1_ = false, int palette_ = -1) : id(id_), x_flip(x_flip_), y_flip(y_flip_), priority(priority_),
+		obp1(obp1_), palette(palette_) {}
+};
+
+// Parses tilemap (and attrmap) bytes; width is set for formats with a fixed width, and 0 otherwise
+Tilemap_Result decode_tilemap(const std::vector<uchar> &tbytes, const std::vector<uchar> &abytes, Tilemap_Format fmt,
+	std::vector<Tilemap_Entry> &tiles, size_t &width);
+// Serializes cells; a GBC_ATTRMAP's attrmap bytes follow its tilemap bytes
+std::vector<uchar> make_tilemap_bytes(const std::vector<Tilemap_Entry> &tiles, Tilemap_Format fmt, size_t width, size_t height);
+// Writes serialized cells to a tilemap file, and a GBC_ATTRMAP's attrmap bytes to their own file
+bool write_tilemap_bytes(const char *tf, const char *af, const std::vector<uchar> &bytes, Tilemap_Format fmt);
 
 #endif
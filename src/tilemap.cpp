@@ -1,5 +1,6 @@
 #include <cstdio>
 #include <cctype>
+#include <cstring>
 
 #pragma warning(push, 0)
 #include <FL/filename.H>
@@ -10,7 +11,47 @@
 #include "config.h"
 #include "version.h"
 
-Tilemap::Tilemap() : _tiles(), _width(0), _result(Result::TILEMAP_NULL), _modified(false), _history(), _future() {}
+static const std::vector<size_t> no_cells;
+
+const std::vector<size_t> &Cell_Index::cells(size_t key) const {
+	return key < _groups.size() ? _groups[key] : no_cells;
+}
+
+void Cell_Index::clear() {
+	_groups.clear();
+	_keys.clear();
+	_slots.clear();
+}
+
+void Cell_Index::reset(size_t n) {
+	clear();
+	_keys.assign(n, SIZE_MAX);
+	_slots.assign(n, 0);
+}
+
+void Cell_Index::place(size_t i, size_t key) {
+	if (i >= _keys.size()) {
+		_keys.resize(i + 1, SIZE_MAX);
+		_slots.resize(i + 1, 0);
+	}
+	size_t old = _keys[i];
+	if (old == key) { return; }
+	if (old != SIZE_MAX) {
+		// Fill the gap with the group's last cell
+		std::vector<size_t> &group = _groups[old];
+		size_t last = group.back();
+		group[_slots[i]] = last;
+		_slots[last] = _slots[i];
+		group.pop_back();
+	}
+	if (key >= _groups.size()) { _groups.resize(key + 1); }
+	_keys[i] = key;
+	_slots[i] = _groups[key].size();
+	_groups[key].push_back(i);
+}
+
+Tilemap::Tilemap(const Context &ctx) : _context(&ctx), _tiles(), _width(0), _result(Result::TILEMAP_NULL), _modified(false),
+	_revision(0), _history(), _future(), _id_index(), _attribute_index() {}
 
 Tilemap::~Tilemap() {
 	clear();
@@ -18,6 +59,7 @@ Tilemap::~Tilemap() {
 
 void Tilemap::width(size_t w) {
 	_width = w;
+	_revision++;
 	size_t n = size();
 	for (size_t i = 0; i < n; i++) {
 		Tile_Tessera *tt = _tiles[i];
@@ -53,7 +95,7 @@ void Tilemap::resize(size_t w, size_t h, int px, int py) {
 		}
 	}
 
-	if (format_can_edit_palettes(Config::format())) {
+	if (format_can_edit_palettes(_context->format)) {
 		for (Tile_Tessera *tt : tiles) {
 			if (tt->palette() == -1) {
 				tt->palette(0);
@@ -64,6 +106,7 @@ void Tilemap::resize(size_t w, size_t h, int px, int py) {
 	clear();
 	_tiles.swap(tiles);
 	width(w);
+	reindex();
 	_modified = true;
 }
 
@@ -82,6 +125,7 @@ void Tilemap::shift(int dx, int dy) {
 	}
 
 	_tiles.swap(tiles);
+	reindex();
 	_modified = true;
 }
 
@@ -102,6 +146,7 @@ void Tilemap::transpose() {
 	clear();
 	_tiles.swap(tiles);
 	width(h);
+	reindex();
 	_modified = true;
 }
 
@@ -110,12 +155,62 @@ void Tilemap::clear() {
 	_width = 0;
 	_result = Result::TILEMAP_NULL;
 	_modified = false;
+	_revision++;
 	_history.clear();
 	_future.clear();
+	_id_index.clear();
+	_attribute_index.clear();
+}
+
+void Tilemap::free_tiles() {
+	for (Tile_Tessera *tt : _tiles) {
+		delete tt;
+	}
+	clear();
+}
+
+void Tilemap::replace(Tilemap &other) {
+	_tiles.swap(other._tiles);
+	_width = other._width;
+	_result = other._result;
+	_modified = other._modified;
+	_revision++;
+	_history.clear();
+	_future.clear();
+	std::swap(_id_index, other._id_index);
+	std::swap(_attribute_index, other._attribute_index);
+	other.clear();
+}
+
+void Tilemap::reindex(size_t i) {
+	if (i >= _tiles.size()) { return; }
+	_revision++;
+	const Tile_Tessera *tt = _tiles[i];
+	_id_index.place(i, tt->id());
+	_attribute_index.place(i, attribute_key(tt->state()));
+}
+
+void Tilemap::reindex(const Tile_Rect &r) {
+	if (r.empty()) { return; }
+	size_t right = std::min(r.right, _width);
+	for (size_t y = r.top; y < r.bottom; y++) {
+		for (size_t x = r.left; x < right; x++) {
+			reindex(y * _width + x);
+		}
+	}
+}
+
+void Tilemap::reindex() {
+	size_t n = size();
+	_id_index.reset(n);
+	_attribute_index.reset(n);
+	for (size_t i = 0; i < n; i++) {
+		reindex(i);
+	}
 }
 
 void Tilemap::reposition_tiles(int x, int y) {
-	int s = TILE_SIZE * Config::zoom();
+	int s = TILE_SIZE * _context->zoom;
 	for (Tile_Tessera *tt : _tiles) {
 		int tx = x + (int)tt->col() * s, ty = y + (int)tt->row() * s;
 		tt->resize(tx, ty, s, s);
@@ -134,8 +229,8 @@ void Tilemap::remember() {
 	_history.push_back(ts);
 }
 
-void Tilemap::undo() {
-	if (_history.empty()) { return; }
+Tile_Rect Tilemap::undo() {
+	if (_history.empty()) { return Tile_Rect(); }
 	while (_future.size() >= MAX_HISTORY_SIZE) { _future.pop_front(); }
 
 	size_t n = size();
@@ -145,15 +240,22 @@ void Tilemap::undo() {
 	}
 	_future.push_back(ts);
 
+	Tile_Rect changed;
 	const Tilemap_State &prev = _history.back();
 	for (size_t i = 0; i < n; i++) {
-		_tiles[i]->state(prev.states[i]);
+		const Tile_State &ps = prev.states[i];
+		if (!ps.same_tiles(ts.states[i]) || !ps.same_attributes(ts.states[i])) {
+			_tiles[i]->state(ps);
+			reindex(i);
+			changed.add(i % _width, i / _width);
+		}
 	}
 	_history.pop_back();
+	return changed;
 }
 
-void Tilemap::redo() {
-	if (_future.empty()) { return; }
+Tile_Rect Tilemap::redo() {
+	if (_future.empty()) { return Tile_Rect(); }
 	while (_history.size() >= MAX_HISTORY_SIZE) { _history.pop_front(); }
 
 	size_t n = size();
@@ -163,14 +265,21 @@ void Tilemap::redo() {
 	}
 	_history.push_back(ts);
 
+	Tile_Rect changed;
 	const Tilemap_State &next = _future.back();
 	for (size_t i = 0; i < n; i++) {
-		_tiles[i]->state(next.states[i]);
+		const Tile_State &ns = next.states[i];
+		if (!ns.same_tiles(ts.states[i]) || !ns.same_attributes(ts.states[i])) {
+			_tiles[i]->state(ns);
+			reindex(i);
+			changed.add(i % _width, i / _width);
+		}
 	}
 	_future.pop_back();
+	return changed;
 }
 
-bool Tilemap::can_format_as(Tilemap_Format fmt) {
+bool Tilemap::can_format_as(Tilemap_Format fmt) const {
 	int n = format_tileset_size(fmt), m = format_palettes_size(fmt);
 	bool can_flip = format_can_flip(fmt), has_priority = format_has_priority(fmt), has_obp1 = format_has_obp1(fmt);
 	return std::all_of(RANGE(_tiles), [&](const Tile_Tessera *tt) {
@@ -205,6 +314,7 @@ void Tilemap::limit_to_format(Tilemap_Format fmt) {
 			tt->obp1(false);
 		}
 	}
+	reindex();
 	_modified = true;
 }
 
@@ -215,276 +325,45 @@ void Tilemap::new_tiles(size_t w, size_t h) {
 	for (size_t i = 0; i < n; i++) {
 		_tiles.emplace_back(new Tile_Tessera());
 	}
-	if (format_can_edit_palettes(Config::format())) {
+	if (format_can_edit_palettes(_context->format)) {
 		for (Tile_Tessera *tt : _tiles) {
 			tt->palette(0);
 		}
 	}
 	_width = w;
+	reindex();
 	_modified = true;
 }
 
 Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std::vector<uchar> &abytes) {
-	size_t c = tbytes.size();
-	if (c == 0) { return (_result = Result::TILEMAP_EMPTY); }
-
-	std::vector<Tile_Tessera *> tiles;
+	std::vector<Tilemap_Entry> entries;
 	size_t width = 0;
-	Tilemap_Format fmt = Config::format();
-
-	if (fmt == Tilemap_Format::PLAIN) {
-		tiles.reserve(c);
-		for (size_t i = 0; i < c; i++) {
-			uint16_t b = tbytes[i];
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, b));
-		}
-	}
-
-	else if (fmt == Tilemap_Format::GBC_ATTRS) {
-		if (c % 2) { return (_result = Result::TILEMAP_TOO_SHORT_ATTRS); }
-		tiles.reserve(c / 2);
-		for (size_t i = 0; i < c; i += 2) {
-			uint16_t v = tbytes[i];
-			uchar a = tbytes[i+1];
-			if (!!(a & 0x08)) { v |= 0x100; }
-			bool x_flip = !!(a & 0x20), y_flip = !!(a & 0x40), priority = !!(a & 0x80), obp1 = !!(a & 0x10);
-			int palette = a & 0x07;
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, priority, obp1, palette));
-		}
-	}
-
-	else if (fmt == Tilemap_Format::GBC_ATTRMAP) {
-		size_t ac = abytes.size();
-		if (ac != c) { return (_result = ac < c ? Result::ATTRMAP_TOO_SHORT : Result::ATTRMAP_TOO_LONG); }
-		tiles.reserve(c);
-		for (size_t i = 0; i < c; i++) {
-			uint16_t v = tbytes[i];
-			uchar a = abytes[i];
-			if (!!(a & 0x08)) { v |= 0x100; }
-			bool x_flip = !!(a & 0x20), y_flip = !!(a & 0x40), priority = !!(a & 0x80), obp1 = !!(a & 0x10);
-			int palette = a & 0x07;
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, priority, obp1, palette));
-		}
-	}
+	Result result = decode_tilemap(tbytes, abytes, _context->format, entries, width);
+	if (result != Result::TILEMAP_OK) { return (_result = result); }
 
-	else if (fmt == Tilemap_Format::GBA_4BPP) {
-		if (c % 2) { return (_result = Result::TILEMAP_TOO_SHORT_ATTRS); }
-		tiles.reserve(c / 2);
-		for (size_t i = 0; i < c; i += 2) {
-			uint16_t v = tbytes[i];
-			uchar a = tbytes[i+1];
-			v = v | ((a & 0x03) << 8);
-			bool x_flip = !!(a & 0x04), y_flip = !!(a & 0x08);
-			int palette = HI_NYB(a);
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, false, false, palette));
-		}
-	}
-
-	else if (fmt == Tilemap_Format::GBA_8BPP) {
-		if (c % 2) { return (_result = Result::TILEMAP_TOO_SHORT_ATTRS); }
-		tiles.reserve(c / 2);
-		for (size_t i = 0; i < c; i += 2) {
-			uint16_t v = tbytes[i];
-			uchar a = tbytes[i+1];
-			v = v | ((a & 0x03) << 8);
-			bool x_flip = !!(a & 0x04), y_flip = !!(a & 0x08);
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, false, false, 0));
-		}
-	}
-
-	else if (fmt == Tilemap_Format::NDS_4BPP) {
-		if (c % 2) { return (_result = Result::TILEMAP_TOO_SHORT_ATTRS); }
-		tiles.reserve((c - NDS_HEADER_SIZE) / 2);
-		for (size_t i = NDS_HEADER_SIZE; i < c; i += 2) {
-			uint16_t v = tbytes[i];
-			uchar a = tbytes[i+1];
-			v = v | ((a & 0x03) << 8);
-			bool x_flip = !!(a & 0x04), y_flip = !!(a & 0x08);
-			int palette = HI_NYB(a);
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, false, false, palette));
-		}
-		width = NDS_WIDTH;
-	}
-
-	else if (fmt == Tilemap_Format::NDS_8BPP) {
-		if (c % 2) { return (_result = Result::TILEMAP_TOO_SHORT_ATTRS); }
-		tiles.reserve((c - NDS_HEADER_SIZE) / 2);
-		for (size_t i = NDS_HEADER_SIZE; i < c; i += 2) {
-			uint16_t v = tbytes[i];
-			uchar a = tbytes[i+1];
-			v = v | ((a & 0x03) << 8);
-			bool x_flip = !!(a & 0x04), y_flip = !!(a & 0x08);
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, false, false, 0));
-		}
-		width = NDS_WIDTH;
-	}
-
-	else if (fmt == Tilemap_Format::SGB_BORDER) {
-		if (c % 2) { return (_result = Result::TILEMAP_TOO_SHORT_ATTRS); }
-		tiles.reserve(c / 2);
-		for (size_t i = 0; i < c; i += 2) {
-			uint16_t v = tbytes[i];
-			uchar a = tbytes[i+1];
-			bool x_flip = !!(a & 0x40), y_flip = !!(a & 0x80);
-			int palette = (a & 0x0C) >> 2;
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, false, false, palette));
-		}
-		width = SGB_WIDTH;
-	}
-
-	else if (fmt == Tilemap_Format::SNES_ATTRS) {
-		if (c % 2) { return (_result = Result::TILEMAP_TOO_SHORT_ATTRS); }
-		tiles.reserve(c / 2);
-		for (size_t i = 0; i < c; i += 2) {
-			uint16_t v = tbytes[i];
-			uchar a = tbytes[i+1];
-			v = v | ((a & 0x03) << 8);
-			bool x_flip = !!(a & 0x40), y_flip = !!(a & 0x80), priority = !!(a & 0x20);
-			int palette = (a & 0x1C) >> 2;
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, priority, false, palette));
-		}
-	}
-
-	else if (fmt == Tilemap_Format::TG16) {
-		if (c % 2) { return (_result = Result::TILEMAP_TOO_SHORT_ATTRS); }
-		tiles.reserve(c / 2);
-		for (size_t i = 0; i < c; i += 2) {
-			uint16_t v = tbytes[i];
-			uchar a = tbytes[i+1];
-			v = v | ((a & 0x07) << 8);
-			int palette = HI_NYB(a);
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, false, false, false, false, palette));
-		}
-	}
-
-	else if (fmt == Tilemap_Format::GENESIS) {
-		if (c % 2) { return (_result = Result::TILEMAP_TOO_SHORT_ATTRS); }
-		tiles.reserve(c / 2);
-		for (size_t i = 0; i < c; i += 2) {
-			uchar a = tbytes[i];
-			uint16_t v = tbytes[i+1];
-			v = v | ((a & 0x07) << 8);
-			bool x_flip = !!(a & 0x08), y_flip = !!(a & 0x10), priority = !!(a & 0x80);
-			int palette = (a & 0x60) >> 5;
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, priority, false, palette));
-		}
-	}
-
-	else if (fmt == Tilemap_Format::RBY_TOWN_MAP) {
-		tiles.reserve(c);
-		for (size_t i = 0; i < c - 1; i++) {
-			uchar b = tbytes[i];
-			if (b == 0x00) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
-				return (_result = Result::TILEMAP_TOO_LONG_00);
-			}
-			uint16_t v = HI_NYB(b), r = LO_NYB(b);
-			for (uint16_t j = 0; j < r; j++) {
-				tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v));
-			}
-		}
-		if (tbytes[c-1] != 0x00) {
-			for (Tile_Tessera *tt : tiles) { delete tt; }
-			return (_result = Result::TILEMAP_TOO_SHORT_00);
-		}
-		width = GAME_BOY_WIDTH;
-	}
-
-	else if (fmt == Tilemap_Format::GSC_TOWN_MAP) {
-		tiles.reserve(c);
-		for (size_t i = 0; i < c - 1; i++) {
-			uint16_t b = tbytes[i];
-			if (b == 0xFF) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
-				return (_result = Result::TILEMAP_TOO_LONG_FF);
-			}
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, b));
-		}
-		if (tbytes[c-1] != 0xFF) {
-			for (Tile_Tessera *tt : tiles) { delete tt; }
-			return (_result = Result::TILEMAP_TOO_SHORT_FF);
-		}
-		width = GAME_BOY_WIDTH;
-	}
-
-	else if (fmt == Tilemap_Format::PC_TOWN_MAP) {
-		tiles.reserve(c);
-		for (size_t i = 0; i < c - 1; i++) {
-			uchar b = tbytes[i];
-			if (b == 0xFF) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
-				return (_result = Result::TILEMAP_TOO_LONG_FF);
-			}
-			bool x_flip = !!(b & 0x40), y_flip = !!(b & 0x80);
-			uint16_t v = b & 0x3F;
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip));
-		}
-		if (tbytes[c-1] != 0xFF) {
-			for (Tile_Tessera *tt : tiles) { delete tt; }
-			return (_result = Result::TILEMAP_TOO_SHORT_FF);
-		}
-		width = GAME_BOY_WIDTH;
-	}
-
-	else if (fmt == Tilemap_Format::SW_TOWN_MAP) {
-		tiles.reserve(c);
-		if (!(c % 2)) { return (_result = Result::TILEMAP_TOO_SHORT_00); }
-		for (size_t i = 0; i < c - 1; i += 2) {
-			uint16_t v = tbytes[i];
-			if (v == 0x00) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
-				return (_result = Result::TILEMAP_TOO_LONG_00);
-			}
-			uint16_t r = tbytes[i+1];
-			if (r == 0x00) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
-				return (_result = Result::TILEMAP_TOO_LONG_00);
-			}
-			for (uint16_t j = 0; j < r; j++) {
-				tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v));
-			}
-		}
-		if (tbytes[c-1] != 0x00) {
-			for (Tile_Tessera *tt : tiles) { delete tt; }
-			return (_result = Result::TILEMAP_TOO_SHORT_00);
-		}
-		width = GAME_BOY_WIDTH;
-	}
-
-	else if (fmt == Tilemap_Format::POKEGEAR_CARD) {
-		tiles.reserve(c);
-		if (!(c % 2)) { return (_result = Result::TILEMAP_TOO_SHORT_FF); }
-		for (size_t i = 0; i < c - 1; i += 2) {
-			uint16_t v = tbytes[i];
-			if (v == 0xFF) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
-				return (_result = Result::TILEMAP_TOO_LONG_FF);
-			}
-			uint16_t r = tbytes[i+1];
-			if (r == 0xFF) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
-				return (_result = Result::TILEMAP_TOO_LONG_FF);
-			}
-			for (uint16_t j = 0; j < r; j++) {
-				tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v));
-			}
-		}
-		if (tbytes[c-1] != 0xFF) {
-			for (Tile_Tessera *tt : tiles) { delete tt; }
-			return (_result = Result::TILEMAP_TOO_SHORT_FF);
-		}
-		width = GAME_BOY_WIDTH;
+	std::vector<Tile_Tessera *> tiles;
+	tiles.reserve(entries.size());
+	for (const Tilemap_Entry &e : entries) {
+		tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, e.id, e.x_flip, e.y_flip, e.priority, e.obp1, e.palette));
 	}
 
-	if (tiles.empty()) { return (_result = Result::TILEMAP_EMPTY); }
-
 	_tiles.swap(tiles);
 	if (width > 0) { _width = width; }
 	else { guess_width(); }
+	reindex();
 
 	return (_result = Result::TILEMAP_OK);
 }
 
+std::vector<Tilemap_Entry> Tilemap::entries() const {
+	std::vector<Tilemap_Entry> entries;
+	entries.reserve(_tiles.size());
+	for (const Tile_Tessera *tt : _tiles) {
+		entries.push_back(tt->state());
+	}
+	return entries;
+}
+
 static bool read_file_bytes(const char *f, std::vector<uchar> &bytes) {
 	FILE *file = fl_fopen(f, "rb");
 	if (!file) { return false; }
@@ -505,34 +384,15 @@ Tilemap::Result Tilemap::read_tiles(const char *tf, const char *af) {
 }
 
 bool Tilemap::write_tiles(const char *tf, const char *af, Tilemap_Format fmt) {
-	FILE *file = fl_fopen(tf, "wb");
-	if (!file) { return false; }
-
-	std::vector<uchar> bytes = make_tilemap_bytes(_tiles, fmt, width(), height());
-	if (fmt == Tilemap_Format::GBC_ATTRMAP) {
-		FILE *attr_file = fl_fopen(af, "wb");
-		if (!attr_file) { fclose(file); return false; }
-
-		size_t nb = bytes.size() / 2;
-		fwrite(bytes.data(), 1, nb, file);
-		fwrite(bytes.data() + nb, 1, nb, attr_file);
-
-		fclose(attr_file);
-	}
-	else {
-		fwrite(bytes.data(), 1, bytes.size(), file);
-	}
-
-	fclose(file);
-	return true;
+	return write_tilemap_bytes(tf, af, make_tilemap_bytes(entries(), fmt, width(), height()), fmt);
 }
 
 bool Tilemap::export_tiles(const char *f) const {
 	FILE *file = fl_fopen(f, "wb");
 	if (!file) { return false; }
 
-	Tilemap_Format fmt = Config::format();
-	std::vector<uchar> bytes = make_tilemap_bytes(_tiles, fmt, width(), height());
+	Tilemap_Format fmt = _context->format;
+	std::vector<uchar> bytes = make_tilemap_bytes(entries(), fmt, width(), height());
 	if (ends_with_ignore_case(f, ".csv")) {
 		export_csv_tiles(file, bytes, fmt);
 	}
@@ -648,13 +508,24 @@ void Tilemap::export_csv_tiles(FILE *file, const std::vector<uchar> &bytes, Tile
 	}
 }
 
-void Tilemap::print_tilemap() const {
-	for (Tile_Tessera *tt : _tiles) {
-		int dx = (int)tt->col() * TILE_SIZE, dy = (int)tt->row() * TILE_SIZE;
-		tt->print(dx, dy, true, false);
+void Tilemap::print_row(size_t row, uchar *rgb) const {
+	size_t ld = _width * TILE_SIZE * NUM_CHANNELS;
+	// Past the end of a non-rectangular tilemap is left white
+	memset(rgb, 0xFF, ld * TILE_SIZE);
+	for (size_t col = 0, i = row * _width; col < _width && i < size(); col++, i++) {
+		_tiles[i]->print(*_context, rgb + col * TILE_SIZE * NUM_CHANNELS, ld);
 	}
 }
 
+static void print_band_cb(size_t y, size_t, uchar *rgb, void *data) {
+	((const Tilemap *)data)->print_row(y / TILE_SIZE, rgb);
+}
+
+Image::Result Tilemap::print_tilemap(const char *f) const {
+	size_t w = _width * TILE_SIZE, h = height() * TILE_SIZE;
+	return Image::write_image(f, w, h, TILE_SIZE, print_band_cb, (void *)this);
+}
+
 static size_t sqrt(size_t n) {
 	for (size_t r = 1; r <= n / 2; r++) {
 		if (r * r == n) { return r; }
@@ -662,6 +533,23 @@ static size_t sqrt(size_t n) {
 	return 0;
 }
 
+Compression_Subject Tilemap::compression_subject(const char *name, Tilemap_Format fmt) const {
+	// RLE formats are measured as RLE; the LZ encoders get the uncompressed tile IDs instead
+	Tilemap_Format plain_fmt = format_bytes_per_tile(fmt) ? fmt : Tilemap_Format::PLAIN;
+	Compression_Subject subject = {name, make_tilemap_bytes(entries(), plain_fmt, width(), height()), {}};
+	std::pair<Tilemap_Format, Encoding> rle_formats[] = {
+		{Tilemap_Format::RBY_TOWN_MAP, Encoding::RBY_RLE},
+		{Tilemap_Format::POKEGEAR_CARD, Encoding::POKEGEAR_RLE},
+		{Tilemap_Format::SW_TOWN_MAP, Encoding::SW_RLE},
+	};
+	for (const auto &[rle_fmt, enc] : rle_formats) {
+		if (can_format_as(rle_fmt)) {
+			subject.rle.emplace_back(enc, make_tilemap_bytes(entries(), rle_fmt, width(), height()));
+		}
+	}
+	return subject;
+}
+
 void Tilemap::guess_width() {
 	size_t n = size();
 #define N_FITS_SIZE(w, h) n % (w) == 0 && n / (w) <= (h)
@@ -693,37 +581,50 @@ void Tilemap::guess_width() {
 #undef N_FITS_SIZE
 }
 
-const char *Tilemap::error_message(Result result) {
-	switch (result) {
-	case Result::TILEMAP_OK:
-		return "OK.";
-	case Result::TILEMAP_BAD_FILE:
-	case Result::ATTRMAP_BAD_FILE:
-		return "Cannot open file.";
-	case Result::TILEMAP_EMPTY:
-		return "Tilemap is empty.";
-	case Result::TILEMAP_TOO_SHORT_FF:
-		return "File ends before any $FF.";
-	case Result::TILEMAP_TOO_LONG_FF:
-		return "File continues after $FF.";
-	case Result::TILEMAP_TOO_SHORT_00:
-		return "File ends before any $00.";
-	case Result::TILEMAP_TOO_LONG_00:
-		return "File continues after $00.";
-	case Result::TILEMAP_TOO_SHORT_RLE:
-		return "File ends before RLE value.";
-	case Result::TILEMAP_TOO_SHORT_ATTRS:
-		return "File ends before attribute value.";
-	case Result::TILEMAP_INVALID:
-	case Result::ATTRMAP_INVALID:
-		return "Cannot parse file format.";
-	case Result::TILEMAP_NULL:
-		return "No file chosen.";
-	case Result::ATTRMAP_TOO_SHORT:
-		return "Attrmap is shorter than tilemap.";
-	case Result::ATTRMAP_TOO_LONG:
-		return "Attrmap is longer than tilemap.";
-	default:
-		return "Unspecified error.";
+Tilemap_Format guess_format(const char *filename, Tilemap_Format fmt) {
+	size_t fs = file_size(filename);
+	const char *basename = fl_filename_name(filename);
+	std::string s(basename);
+	char attrmap_name[FL_PATH_MAX] = {};
+	strcpy(attrmap_name, filename);
+	fl_filename_setext(attrmap_name, sizeof(attrmap_name), ATTRMAP_EXT);
+
+	if (file_exists(attrmap_name)) {
+		return Tilemap_Format::GBC_ATTRMAP;
+	}
+	if (starts_with_ignore_case(s, "sgb") || fs == SGB_WIDTH * SGB_HEIGHT * 2 ||
+		fs == SGB_WIDTH * SGB_HEIGHT * 2 - GAME_BOY_WIDTH * GAME_BOY_HEIGHT * 2) {
+		return Tilemap_Format::SGB_BORDER;
+	}
+	if (ends_with_ignore_case(s, ".tilemap.rle")) {
+		return Tilemap_Format::POKEGEAR_CARD;
+	}
+	if (ends_with_ignore_case(s, ".rle")) {
+		return Tilemap_Format::RBY_TOWN_MAP;
+	}
+	if (s == "johto.bin" || s == "kanto.bin" ||
+		fs == GAME_BOY_WIDTH * GAME_BOY_HEIGHT + 1) {
+		return Tilemap_Format::GSC_TOWN_MAP;
+	}
+	if (ends_with_ignore_case(s, ".rcsn") || ends_with_ignore_case(s, ".nscr") || fs == 0x624 || fs == 0x824) {
+		return Tilemap_Format::NDS_4BPP;
+	}
+	if (ends_with_ignore_case(s, ".kmp") || fs % 2 ||
+		fs > GAME_BOY_VRAM_SIZE * GAME_BOY_VRAM_SIZE * 2) {
+		return Tilemap_Format::PLAIN;
+	}
+	if (fs == GBA_WIDTH * GBA_HEIGHT * 2 ||
+		fs == GAME_BOY_VRAM_SIZE * GBA_HEIGHT * 2) {
+		return Tilemap_Format::GBA_4BPP;
+	}
+	if (fs >= GAME_BOY_WIDTH * GAME_BOY_HEIGHT * 2 &&
+		fs < GAME_BOY_VRAM_SIZE * GBA_HEIGHT * 2) {
+		return Tilemap_Format::GBC_ATTRS;
+	}
+	if (fmt == Tilemap_Format::SGB_BORDER || fmt == Tilemap_Format::GBC_ATTRS || fmt == Tilemap_Format::GBA_4BPP ||
+		fmt == Tilemap_Format::GBA_8BPP || fmt == Tilemap_Format::NDS_4BPP || fmt == Tilemap_Format::NDS_8BPP ||
+		fmt == Tilemap_Format::SNES_ATTRS || fmt == Tilemap_Format::GENESIS || fmt == Tilemap_Format::TG16) {
+		return fmt;
 	}
+	return Tilemap_Format::PLAIN;
 }
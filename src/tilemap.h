@@ -8,9 +8,22 @@
 #include "config.h"
 #include "utils.h"
 #include "tile-buttons.h"
+#include "image.h"
+#include "compression-advisor.h"
 
 #define MAX_HISTORY_SIZE 100
 
+// A rectangle of tilemap cells; right and bottom are exclusive
+struct Tile_Rect {
+	size_t left, top, right, bottom;
+	inline Tile_Rect() : left(SIZE_MAX), top(SIZE_MAX), right(0), bottom(0) {}
+	inline Tile_Rect(size_t l, size_t t, size_t r, size_t b) : left(l), top(t), right(r), bottom(b) {}
+	inline bool empty(void) const { return left >= right || top >= bottom; }
+	inline void add(size_t x, size_t y) {
+		left = std::min(left, x); top = std::min(top, y); right = std::max(right, x + 1); bottom = std::max(bottom, y + 1);
+	}
+};
+
 struct Tilemap_State {
 	std::vector<Tile_State> states;
 	Tilemap_State() : states() {}
@@ -18,20 +31,36 @@ struct Tilemap_State {
 	inline const Tile_State &state(size_t i) const { return states[i]; }
 };
 
+// Groups tilemap cells by a small key, like their tile ID, and moves a cell between groups in constant time
+class Cell_Index {
+private:
+	std::vector<std::vector<size_t>> _groups;
+	std::vector<size_t> _keys, _slots;
+public:
+	inline Cell_Index() : _groups(), _keys(), _slots() {}
+	inline size_t count(size_t key) const { return key < _groups.size() ? _groups[key].size() : 0; }
+	const std::vector<size_t> &cells(size_t key) const;
+	void clear(void);
+	void reset(size_t n);
+	void place(size_t i, size_t key);
+};
+
 class Tilemap {
 public:
-	enum class Result { TILEMAP_OK, TILEMAP_BAD_FILE, TILEMAP_EMPTY, TILEMAP_TOO_SHORT_FF, TILEMAP_TOO_LONG_FF,
-		TILEMAP_TOO_SHORT_00, TILEMAP_TOO_LONG_00, TILEMAP_TOO_SHORT_RLE, TILEMAP_TOO_SHORT_ATTRS, TILEMAP_INVALID,
-		TILEMAP_NULL, ATTRMAP_BAD_FILE, ATTRMAP_TOO_SHORT, ATTRMAP_TOO_LONG, ATTRMAP_INVALID };
+	typedef Tilemap_Result Result;
 private:
+	const Context *_context;
 	std::vector<Tile_Tessera *> _tiles;
 	size_t _width;
 	Result _result;
 	bool _modified;
+	size_t _revision;
 	std::deque<Tilemap_State> _history, _future;
+	Cell_Index _id_index, _attribute_index;
 public:
-	Tilemap();
+	Tilemap(const Context &ctx = Config::context());
 	~Tilemap();
+	inline const Context &context(void) const { return *_context; }
 	inline size_t size(void) const { return _tiles.size(); }
 	inline size_t width(void) const { return _width; }
 	void width(size_t w);
@@ -39,6 +68,7 @@ public:
 	void shift(int dx, int dy);
 	void transpose(void);
 	inline bool is_rectangular(void) const { return size() % _width == 0; }
+	inline Tile_Rect bounds(void) const { return Tile_Rect(0, 0, _width, height()); }
 	inline size_t height(void) const { return _width ? (size() + _width - 1) / _width : 0; }
 	inline Tile_Tessera *tile(size_t x, size_t y) const { return tile(y * _width + x); }
 	inline Tile_Tessera *tile(size_t i) const { return i < _tiles.size() ? _tiles[i] : NULL; }
@@ -46,30 +76,56 @@ public:
 	inline Result result(void) const { return _result; }
 	inline bool modified(void) const { return _modified; }
 	inline void modified(bool m) { _modified = m; }
+	// Changes whenever the cells or the width change, so derived data can tell when it is out of date
+	inline size_t revision(void) const { return _revision; }
 	inline bool can_undo(void) const { return !_history.empty(); }
 	inline bool can_redo(void) const { return !_future.empty(); }
 	inline const Tilemap_State &last_state(void) const { return _history.back(); }
 	void clear();
+	// Deletes the cells and clears; for tilemaps whose cells were never added to a window, which would own them
+	void free_tiles(void);
+	// Takes another tilemap's cells, leaving it empty; this one's history is cleared
+	void replace(Tilemap &other);
 	void reposition_tiles(int x, int y);
 	void remember(void);
-	void undo(void);
-	void redo(void);
-	bool can_format_as(Tilemap_Format fmt);
+	Tile_Rect undo(void);
+	Tile_Rect redo(void);
+	bool can_format_as(Tilemap_Format fmt) const;
 	void limit_to_format(Tilemap_Format fmt);
 	void new_tiles(size_t w, size_t h);
 	Result read_tiles(const char *tf, const char *af);
 	bool write_tiles(const char *tf, const char *af, Tilemap_Format fmt);
 	Result import_tiles(const char *tf, const char *af);
 	bool export_tiles(const char *f) const;
-	void print_tilemap(void) const;
+	// Renders one row of tiles at 1x into an RGB buffer TILE_SIZE pixels tall and width() tiles wide
+	void print_row(size_t row, uchar *rgb) const;
+	// Streams the whole tilemap at 1x to a PNG or BMP file, one row of tiles at a time
+	Image::Result print_tilemap(const char *f) const;
+	Compression_Subject compression_subject(const char *name, Tilemap_Format fmt) const;
 	void guess_width(void);
+	// Which cells use a tile ID or attribute combination; call reindex after changing cells' states
+	inline size_t count(uint16_t id) const { return _id_index.count(id); }
+	inline const std::vector<size_t> &cells_with_id(uint16_t id) const { return _id_index.cells(id); }
+	inline const std::vector<size_t> &cells_with_attributes(const Tile_State &ts) const {
+		return _attribute_index.cells(attribute_key(ts));
+	}
+	void reindex(size_t i);
+	void reindex(const Tile_Rect &r);
+	void reindex(void);
 private:
+	inline static size_t attribute_key(const Tile_State &ts) {
+		return (size_t)(ts.palette + 1) * 4 + (ts.priority ? 2 : 0) + (ts.obp1 ? 1 : 0);
+	}
 	Result make_tiles(const std::vector<uchar> &tbytes, const std::vector<uchar> &abytes);
+	std::vector<Tilemap_Entry> entries(void) const;
 	void export_c_tiles(FILE *file, const std::vector<uchar> &bytes, Tilemap_Format fmt, const char *f) const;
 	void export_asm_tiles(FILE *file, const std::vector<uchar> &bytes, Tilemap_Format fmt, const char *f) const;
 	void export_csv_tiles(FILE *file, const std::vector<uchar> &bytes, Tilemap_Format fmt) const;
 public:
-	static const char *error_message(Result result);
+	inline static const char *error_message(Result result) { return tilemap_error_message(result); }
 };
 
+// Guesses a format from the file's name and size, keeping fmt for files that would fit it
+Tilemap_Format guess_format(const char *filename, Tilemap_Format fmt);
+
 #endif
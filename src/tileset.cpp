@@ -1,27 +1,40 @@
-#include <array>
 #include <vector>
 
 #pragma warning(push, 0)
+#include <FL/Fl.H>
 #include <FL/fl_types.h>
 #include <FL/fl_utf8.h>
 #include <FL/Fl_PNG_Image.H>
 #include <FL/Fl_GIF_Image.H>
 #include <FL/Fl_BMP_Image.H>
-#include <FL/Fl_Image_Surface.H>
 #include <FL/fl_draw.H>
 #pragma warning(pop)
 
 #include "utils.h"
+#include "lz.h"
 #include "tileset.h"
+#include "image.h"
 #include "tile-buttons.h"
 #include "config.h"
+#include "draw-stats.h"
 
-Tileset::Tileset(int start_id, int offset, int length) : _1x_image(NULL), _2x_image(NULL), _zoomed_image(NULL),
-	_num_tiles(0), _start_id(start_id), _offset(offset), _length(length), _result(Result::TILESET_NULL) {}
+Tileset::Tileset(int start_id, int offset, int length, Tile_Layout layout) : _1x_image(NULL), _2x_image(NULL),
+	_zoomed_image(NULL), _num_tiles(0), _start_id(start_id), _offset(offset), _length(length), _layout(layout),
+	_result(Result::TILESET_NULL), _modified(0), _file_size(0), _data(), _bytes_per_tile(0) {}
 
 Tileset::~Tileset() {}
 
 void Tileset::clear() {
+	clear_graphics();
+	_start_id = 0x000;
+	_offset = 0;
+	_length = 0;
+	_result = Result::TILESET_NULL;
+	_modified = 0;
+	_file_size = 0;
+}
+
+void Tileset::clear_graphics() {
 	delete _1x_image;
 	_1x_image = NULL;
 	delete _2x_image;
@@ -29,15 +42,12 @@ void Tileset::clear() {
 	delete _zoomed_image;
 	_zoomed_image = NULL;
 	_num_tiles = 0;
-	_start_id = 0x000;
-	_offset = 0;
-	_length = 0;
-	_result = Result::TILESET_NULL;
+	_data.clear();
+	_bytes_per_tile = 0;
 }
 
-void Tileset::update_zoom() {
+void Tileset::update_zoom(int z) {
 	if (!_1x_image) { return; }
-	int z = Config::zoom();
 	_zoomed_image = (Fl_RGB_Image *)_1x_image->copy(_1x_image->w() * z, _1x_image->h() * z);
 }
 
@@ -62,6 +72,7 @@ bool Tileset::draw_tile(const Tile_State *ts, int x, int y, int z, bool active)
 		int tx = index % wt * TILE_SIZE_2X, ty = index / wt * TILE_SIZE_2X;
 		if (!ts->x_flip && !ts->y_flip) {
 			_2x_image->draw(x, y, TILE_SIZE_2X, TILE_SIZE_2X, tx, ty);
+			Draw_Stats::tile_blitted(false);
 		}
 		else {
 			const uchar *data = (const uchar *)_2x_image->data()[0];
@@ -71,6 +82,7 @@ bool Tileset::draw_tile(const Tile_State *ts, int x, int y, int z, bool active)
 			int td = ts->x_flip ? -d : d;
 			int tld = ts->y_flip ? -ld : ld;
 			fl_draw_image(data, x, y, TILE_SIZE_2X, TILE_SIZE_2X, td, tld);
+			Draw_Stats::tile_blitted(true);
 		}
 	}
 	else {
@@ -78,6 +90,7 @@ bool Tileset::draw_tile(const Tile_State *ts, int x, int y, int z, bool active)
 		int tx = index % wt * s, ty = index / wt * s;
 		if (!ts->x_flip && !ts->y_flip) {
 			_zoomed_image->draw(x, y, s, s, tx, ty);
+			Draw_Stats::tile_blitted(false);
 		}
 		else {
 			const uchar *data = (const uchar *)_zoomed_image->data()[0];
@@ -87,11 +100,24 @@ bool Tileset::draw_tile(const Tile_State *ts, int x, int y, int z, bool active)
 			int td = ts->x_flip ? -d : d;
 			int tld = ts->y_flip ? -ld : ld;
 			fl_draw_image(data, x, y, s, s, td, tld);
+			Draw_Stats::tile_blitted(true);
 		}
 	}
 	return true;
 }
 
+Fl_RGB_Image *Tileset::tile_image(const Tile_State *ts, int &tx, int &ty) const {
+	int index = (int)ts->id - _start_id + _offset;
+	int limit = (int)_num_tiles;
+	if (_length > 0) { limit = std::min(limit, _length + _offset); }
+	if (index < _offset || index >= limit || !_1x_image) { return NULL; }
+
+	int wt = _1x_image->w() / TILE_SIZE;
+	tx = index % wt * TILE_SIZE;
+	ty = index / wt * TILE_SIZE;
+	return _1x_image;
+}
+
 bool Tileset::print_tile(const Tile_State *ts, int x, int y, bool active) const {
 	int index = (int)ts->id - _start_id + _offset;
 	int limit = (int)_num_tiles;
@@ -121,123 +147,157 @@ bool Tileset::print_tile(const Tile_State *ts, int x, int y, bool active) const
 	return true;
 }
 
-Tileset::Result Tileset::read_tiles(const char *f) {
+Tileset::Result Tileset::read_tiles(const char *f, const Context &ctx) {
+	_modified = file_modified(f);
+	_file_size = ::file_size(f);
 	std::string s(f);
-	if (ends_with_ignore_case(s, ".png")) { return read_png_graphics(f); }
-	if (ends_with_ignore_case(s, ".gif")) { return read_gif_graphics(f); }
-	if (ends_with_ignore_case(s, ".bmp")) { return read_bmp_graphics(f); }
-	if (ends_with_ignore_case(s, ".1bpp")) { return read_1bpp_graphics(f); }
-	if (ends_with_ignore_case(s, ".2bpp")) { return read_2bpp_graphics(f); }
-	if (ends_with_ignore_case(s, ".4bpp")) { return read_4bpp_graphics(f); }
-	if (ends_with_ignore_case(s, ".8bpp")) { return read_8bpp_graphics(f); }
-	if (ends_with_ignore_case(s, ".1bpp.lz")) { return read_1bpp_lz_graphics(f); }
-	if (ends_with_ignore_case(s, ".2bpp.lz")) { return read_2bpp_lz_graphics(f); }
-	if (ends_with_ignore_case(s, ".rgcn")) { return read_rgcn_graphics(f); }
-	if (ends_with_ignore_case(s, ".ncgr")) { return read_rgcn_graphics(f); }
-	if (ends_with_ignore_case(s, ".rmp")) { return read_rts_graphics(f, true); }
-	if (ends_with_ignore_case(s, ".rts")) { return read_rts_graphics(f, false); }
-	return (_result = Result::TILESET_BAD_EXT);
-}
-
-Tileset::Result Tileset::read_png_graphics(const char *f) {
-	Fl_PNG_Image *png = new Fl_PNG_Image(f);
-	return postprocess_graphics(png);
-}
-
-Tileset::Result Tileset::read_gif_graphics(const char *f) {
-	Fl_GIF_Image gif(f);
-	if (gif.fail()) { return (_result = Result::TILESET_BAD_FILE); }
-	Fl_RGB_Image *img = new Fl_RGB_Image(&gif, FL_WHITE);
-	return postprocess_graphics(img);
+	if (ends_with_ignore_case(s, ".png")) { return read_png_graphics(f, ctx); }
+	if (ends_with_ignore_case(s, ".gif")) { return read_gif_graphics(f, ctx); }
+	if (ends_with_ignore_case(s, ".bmp")) { return read_bmp_graphics(f, ctx); }
+	if (ends_with_ignore_case(s, ".rmp")) { return read_rts_graphics(f, true, ctx); }
+	if (ends_with_ignore_case(s, ".rts")) { return read_rts_graphics(f, false, ctx); }
+	std::vector<uchar> data;
+	size_t bytes_per_tile = 0;
+	if ((_result = read_tile_data(f, data, bytes_per_tile)) != Result::TILESET_OK) {
+		return _result;
+	}
+	return parse_tile_data(data, bytes_per_tile, ctx);
 }
 
-Tileset::Result Tileset::read_bmp_graphics(const char *f) {
-	Fl_BMP_Image *bmp = new Fl_BMP_Image(f);
-	return postprocess_graphics(bmp);
+Tileset::Result Tileset::reload_tiles(const char *f, const Context &ctx) {
+	int64_t modified = file_modified(f);
+	size_t size = ::file_size(f);
+	if (_result == Result::TILESET_OK && modified == _modified && size == _file_size) {
+		return _result;
+	}
+	// Only tile data can be compared tile by tile; images and other formats are read again in full
+	if (_result != Result::TILESET_OK || _data.empty()) {
+		clear_graphics();
+		return read_tiles(f, ctx);
+	}
+	std::vector<uchar> data;
+	size_t bytes_per_tile = 0;
+	if ((_result = read_tile_data(f, data, bytes_per_tile)) != Result::TILESET_OK) {
+		clear_graphics();
+		return _result;
+	}
+	_modified = modified;
+	_file_size = size;
+	if (bytes_per_tile == _bytes_per_tile && data.size() == _data.size()) {
+		patch_tile_data(data);
+		_data.swap(data);
+		return _result;
+	}
+	clear_graphics();
+	return parse_tile_data(data, bytes_per_tile, ctx);
 }
 
-Tileset::Result Tileset::read_1bpp_graphics(const char *f) {
-	FILE *file = fl_fopen(f, "rb");
-	if (!file) { return (_result = Result::TILESET_BAD_FILE); }
-
-	size_t n = file_size(file);
-	if (n % BYTES_PER_1BPP_TILE) { fclose(file); return (_result = Result::TILESET_BAD_DIMS); }
-
-	std::vector<uchar> data(n);
-	size_t r = fread(data.data(), 1, n, file);
-	fclose(file);
-	if (r != n) { return (_result = Result::TILESET_BAD_FILE); }
+static Tileset::Result read_raw_data(const char *f, std::vector<uchar> &data, size_t bytes_per_tile);
+static Tileset::Result decompress_lz_file(const char *f, std::vector<uchar> &data, bool gba);
+static Tileset::Result read_rgcn_data(const char *f, std::vector<uchar> &data, size_t &bytes_per_tile);
 
-	return parse_1bpp_data(data);
+Tileset::Result Tileset::read_tile_data(const char *f, std::vector<uchar> &data, size_t &bytes_per_tile) {
+	std::string s(f);
+	Result result = Result::TILESET_BAD_EXT;
+	if (ends_with_ignore_case(s, ".1bpp")) {
+		bytes_per_tile = BYTES_PER_1BPP_TILE;
+		result = read_raw_data(f, data, bytes_per_tile);
+	}
+	else if (ends_with_ignore_case(s, ".2bpp")) {
+		bytes_per_tile = BYTES_PER_2BPP_TILE;
+		result = read_raw_data(f, data, bytes_per_tile);
+	}
+	else if (ends_with_ignore_case(s, ".4bpp")) {
+		bytes_per_tile = BYTES_PER_4BPP_TILE;
+		result = read_raw_data(f, data, bytes_per_tile);
+	}
+	else if (ends_with_ignore_case(s, ".8bpp")) {
+		bytes_per_tile = BYTES_PER_8BPP_TILE;
+		result = read_raw_data(f, data, bytes_per_tile);
+	}
+	else if (ends_with_ignore_case(s, ".1bpp.lz")) {
+		bytes_per_tile = BYTES_PER_1BPP_TILE;
+		result = decompress_lz_file(f, data, false);
+	}
+	else if (ends_with_ignore_case(s, ".2bpp.lz")) {
+		bytes_per_tile = BYTES_PER_2BPP_TILE;
+		result = decompress_lz_file(f, data, false);
+	}
+	else if (ends_with_ignore_case(s, ".4bpp.lz")) {
+		bytes_per_tile = BYTES_PER_4BPP_TILE;
+		result = decompress_lz_file(f, data, true);
+		if (result == Result::TILESET_OK && data.size() % bytes_per_tile) { result = Result::TILESET_BAD_DIMS; }
+	}
+	else if (ends_with_ignore_case(s, ".8bpp.lz")) {
+		bytes_per_tile = BYTES_PER_8BPP_TILE;
+		result = decompress_lz_file(f, data, true);
+		if (result == Result::TILESET_OK && data.size() % bytes_per_tile) { result = Result::TILESET_BAD_DIMS; }
+	}
+	else if (ends_with_ignore_case(s, ".rgcn") || ends_with_ignore_case(s, ".ncgr")) {
+		result = read_rgcn_data(f, data, bytes_per_tile);
+	}
+	return result;
 }
 
-Tileset::Result Tileset::read_2bpp_graphics(const char *f) {
-	FILE *file = fl_fopen(f, "rb");
-	if (!file) { return (_result = Result::TILESET_BAD_FILE); }
-
-	size_t n = file_size(file);
-	if (n % BYTES_PER_2BPP_TILE) { fclose(file); return (_result = Result::TILESET_BAD_DIMS); }
+Tileset::Result Tileset::read_png_graphics(const char *f, const Context &ctx) {
+	Fl_PNG_Image *png = new Fl_PNG_Image(f);
+	return postprocess_graphics(png, ctx);
+}
 
-	std::vector<uchar> data(n);
-	size_t r = fread(data.data(), 1, n, file);
-	fclose(file);
-	if (r != n) { return (_result = Result::TILESET_BAD_FILE); }
+Tileset::Result Tileset::read_gif_graphics(const char *f, const Context &ctx) {
+	Fl_GIF_Image gif(f);
+	if (gif.fail()) { return (_result = Result::TILESET_BAD_FILE); }
+	Fl_RGB_Image *img = new Fl_RGB_Image(&gif, FL_WHITE);
+	return postprocess_graphics(img, ctx);
+}
 
-	return parse_2bpp_data(data);
+Tileset::Result Tileset::read_bmp_graphics(const char *f, const Context &ctx) {
+	Fl_BMP_Image *bmp = new Fl_BMP_Image(f);
+	return postprocess_graphics(bmp, ctx);
 }
 
-Tileset::Result Tileset::read_4bpp_graphics(const char *f) {
+static Tileset::Result read_raw_data(const char *f, std::vector<uchar> &data, size_t bytes_per_tile) {
 	FILE *file = fl_fopen(f, "rb");
-	if (!file) { return (_result = Result::TILESET_BAD_FILE); }
+	if (!file) { return Tileset::Result::TILESET_BAD_FILE; }
 
 	size_t n = file_size(file);
-	if (n % BYTES_PER_4BPP_TILE) { fclose(file); return (_result = Result::TILESET_BAD_DIMS); }
+	if (n % bytes_per_tile) { fclose(file); return Tileset::Result::TILESET_BAD_DIMS; }
 
-	std::vector<uchar> data(n);
+	data.resize(n);
 	size_t r = fread(data.data(), 1, n, file);
 	fclose(file);
-	if (r != n) { return (_result = Result::TILESET_BAD_FILE); }
+	if (r != n) { return Tileset::Result::TILESET_BAD_FILE; }
 
-	return parse_4bpp_data(data);
+	return Tileset::Result::TILESET_OK;
 }
 
-Tileset::Result Tileset::read_8bpp_graphics(const char *f) {
-	FILE *file = fl_fopen(f, "rb");
-	if (!file) { return (_result = Result::TILESET_BAD_FILE); }
+enum class Hue { WHITE, DARK, LIGHT, BLACK };
 
-	size_t n = file_size(file);
-	if (n % BYTES_PER_8BPP_TILE) { fclose(file); return (_result = Result::TILESET_BAD_DIMS); }
+static Fl_Color hue_colors[NUM_HUES] = {fl_rgb_color(0xFF), fl_rgb_color(0x55), fl_rgb_color(0xAA), fl_rgb_color(0x00)};
 
-	std::vector<uchar> data(n);
-	size_t r = fread(data.data(), 1, n, file);
-	fclose(file);
-	if (r != n) { return (_result = Result::TILESET_BAD_FILE); }
+static Fl_Color bpp4_colors[16] = {
+	fl_rgb_color(0xFF), fl_rgb_color(0xEE), fl_rgb_color(0xDD), fl_rgb_color(0xCC),
+	fl_rgb_color(0xBB), fl_rgb_color(0xAA), fl_rgb_color(0x99), fl_rgb_color(0x88),
+	fl_rgb_color(0x77), fl_rgb_color(0x66), fl_rgb_color(0x55), fl_rgb_color(0x44),
+	fl_rgb_color(0x33), fl_rgb_color(0x22), fl_rgb_color(0x11), fl_rgb_color(0x00)
+};
 
-	return parse_8bpp_data(data);
+// Tiles are decoded into a column of pixels directly, since drawing them to an image surface would need a display
+static uchar *new_tile_column(size_t n) {
+	return new uchar[n * NUM_TILE_PIXELS * NUM_CHANNELS]();
 }
 
-static Tileset::Result decompress_lz_data(const char *f, std::vector<uchar> &data);
-
-Tileset::Result Tileset::read_1bpp_lz_graphics(const char *f) {
-	std::vector<uchar> data(MAX_NUM_TILES * BYTES_PER_1BPP_TILE);
-	if (decompress_lz_data(f, data) != Result::TILESET_OK) {
-		return _result;
-	}
-	return parse_1bpp_data(data);
+static inline void put_pixel(uchar *pixels, int x, int y, Fl_Color c) {
+	uchar *p = pixels + ((size_t)y * TILE_SIZE + x) * NUM_CHANNELS;
+	Fl::get_color(c, p[0], p[1], p[2]);
 }
 
-Tileset::Result Tileset::read_2bpp_lz_graphics(const char *f) {
-	std::vector<uchar> data(MAX_NUM_TILES * BYTES_PER_2BPP_TILE);
-	if (decompress_lz_data(f, data) != Result::TILESET_OK) {
-		return _result;
-	}
-	return parse_2bpp_data(data);
+static Fl_RGB_Image *tile_column_image(uchar *pixels, size_t n) {
+	Fl_RGB_Image *img = new Fl_RGB_Image(pixels, TILE_SIZE, (int)n * TILE_SIZE, NUM_CHANNELS);
+	img->alloc_array = 1;
+	return img;
 }
 
-enum class Hue { WHITE, DARK, LIGHT, BLACK };
-
-static Fl_Color hue_colors[NUM_HUES] = {fl_rgb_color(0xFF), fl_rgb_color(0x55), fl_rgb_color(0xAA), fl_rgb_color(0x00)};
-
 static void convert_1bpp_row(uchar b, Hue *row) {
 	// %ABCD_EFGH -> %A %B %C %D %E %F %G %H
 	for (int i = 0; i < TILE_SIZE; i++) {
@@ -254,135 +314,207 @@ static void convert_2bpp_row(uchar b1, uchar b2, Hue *row) {
 	}
 }
 
-Tileset::Result Tileset::parse_1bpp_data(const std::vector<uchar> &data) {
-	_num_tiles = data.size() / BYTES_PER_1BPP_TILE;
+static const char *tile_layout_names[NUM_TILE_LAYOUTS] = {
+	"Linear (GBA, NDS)",                   // LINEAR
+	"Planar (SNES, TG16)",                 // PLANAR
+	"Linear, high nybble first (Genesis)", // LINEAR_HI_FIRST
+};
 
-	int limit = (int)_num_tiles - _offset;
-	if (_length > 0) { limit = std::min(limit, _length + _offset); }
-	if (_start_id + limit > MAX_NUM_TILES) { return (_result = Result::TILESET_TOO_LARGE); }
+static const char *tile_layout_short_names[NUM_TILE_LAYOUTS] = {
+	"linear",    // LINEAR
+	"planar",    // PLANAR
+	"linear-hi", // LINEAR_HI_FIRST
+};
 
-	Fl_Image_Surface *surface = new Fl_Image_Surface(TILE_SIZE, (int)_num_tiles * TILE_SIZE);
-	surface->set_current();
+const char *tile_layout_name(Tile_Layout layout) {
+	return tile_layout_names[(int)layout];
+}
 
-	Hue row[TILE_SIZE] = {};
-	for (size_t i = 0; i < _num_tiles; i++) {
-		for (size_t j = 0; j < TILE_SIZE; j++) {
-			uchar b = data[i * BYTES_PER_1BPP_TILE + j];
-			convert_1bpp_row(b, row);
-			for (int k = 0; k < TILE_SIZE; k++) {
-				Hue hue = row[k];
-				fl_color(hue_colors[(int)hue]);
-				fl_point(k, (int)(i * TILE_SIZE + j));
+const char *tile_layout_short_name(Tile_Layout layout) {
+	return tile_layout_short_names[(int)layout];
+}
+
+Tile_Layout format_tile_layout(Tilemap_Format fmt) {
+	switch (fmt) {
+	case Tilemap_Format::SGB_BORDER:
+	case Tilemap_Format::SNES_ATTRS:
+	case Tilemap_Format::TG16:
+		return Tile_Layout::PLANAR;
+	case Tilemap_Format::GENESIS:
+		return Tile_Layout::LINEAR_HI_FIRST;
+	default:
+		return Tile_Layout::LINEAR;
+	}
+}
+
+static void decode_tile_row(const uchar *tile, int bpp, Tile_Layout layout, int y, uchar *row) {
+	if (layout == Tile_Layout::PLANAR) {
+		// Bitplanes are interleaved in pairs, row by row <https://sneslab.net/wiki/Graphics_Format>
+		std::fill_n(row, TILE_SIZE, (uchar)0);
+		for (int p = 0; p < bpp; p++) {
+			uchar b = bpp == 1 ? tile[y] : tile[p / 2 * 16 + y * 2 + p % 2];
+			for (int x = 0; x < TILE_SIZE; x++) {
+				row[x] |= (b >> (TILE_SIZE - x - 1) & 1) << p;
 			}
 		}
 	}
+	else if (bpp == 8) {
+		std::copy_n(tile + y * TILE_SIZE, TILE_SIZE, row);
+	}
+	else {
+		// One nybble per pixel; GBA and NDS store the left pixel in the low nybble, Genesis in the high one
+		bool hi_first = layout == Tile_Layout::LINEAR_HI_FIRST;
+		for (int x = 0; x < TILE_SIZE; x += 2) {
+			uchar b = tile[y * TILE_SIZE / 2 + x / 2];
+			row[x] = hi_first ? HI_NYB(b) : LO_NYB(b);
+			row[x+1] = hi_first ? LO_NYB(b) : HI_NYB(b);
+		}
+	}
+}
 
-	Fl_RGB_Image *img = surface->image();
-	delete surface;
-	Fl_Display_Device::display_device()->set_current();
-
-	return postprocess_graphics(img);
+static void encode_tile_row(uchar *tile, int bpp, Tile_Layout layout, int y, const uchar *row) {
+	if (layout == Tile_Layout::PLANAR) {
+		for (int p = 0; p < bpp; p++) {
+			uchar b = 0;
+			for (int x = 0; x < TILE_SIZE; x++) {
+				b |= (row[x] >> p & 1) << (TILE_SIZE - x - 1);
+			}
+			(bpp == 1 ? tile[y] : tile[p / 2 * 16 + y * 2 + p % 2]) = b;
+		}
+	}
+	else if (bpp == 8) {
+		std::copy_n(row, TILE_SIZE, tile + y * TILE_SIZE);
+	}
+	else {
+		bool hi_first = layout == Tile_Layout::LINEAR_HI_FIRST;
+		for (int x = 0; x < TILE_SIZE; x += 2) {
+			uchar l = row[x] & 0x0F, r = row[x+1] & 0x0F;
+			tile[y * TILE_SIZE / 2 + x / 2] = hi_first ? (uchar)(l << 4 | r) : (uchar)(r << 4 | l);
+		}
+	}
 }
 
-Tileset::Result Tileset::parse_2bpp_data(const std::vector<uchar> &data) {
-	_num_tiles = data.size() / BYTES_PER_2BPP_TILE;
+// Decodes tile i of the data into its place in a column of pixels
+static void decode_tile(const uchar *data, size_t i, int bpp, Tile_Layout layout, uchar *pixels) {
+	const uchar *tile = data + i * BYTES_PER_1BPP_TILE * bpp;
+	Hue hues[TILE_SIZE] = {};
+	uchar row[TILE_SIZE] = {};
+	for (int j = 0; j < TILE_SIZE; j++) {
+		int py = (int)(i * TILE_SIZE + j);
+		if (bpp == 1) { convert_1bpp_row(tile[j], hues); }
+		else if (bpp == 2) { convert_2bpp_row(tile[j * 2], tile[j * 2 + 1], hues); }
+		else { decode_tile_row(tile, bpp, layout, j, row); }
+		for (int k = 0; k < TILE_SIZE; k++) {
+			uchar b = row[k];
+			Fl_Color c = bpp < 4 ? hue_colors[(int)hues[k]] : bpp == 4 ? bpp4_colors[b] : fl_rgb_color(0xFF-b, 0xFF-b, 0xFF-b);
+			put_pixel(pixels, k, py, c);
+		}
+	}
+}
 
-	int limit = (int)_num_tiles - _offset;
-	if (_length > 0) { limit = std::min(limit, _length + _offset); }
-	if (_start_id + limit > MAX_NUM_TILES) { return (_result = Result::TILESET_TOO_LARGE); }
+int Tileset::tile_data_bpp(const char *f) {
+	std::string s(f);
+	if (ends_with_ignore_case(s, ".lz")) { s.erase(s.size() - 3); }
+	if (ends_with_ignore_case(s, ".1bpp")) { return 1; }
+	if (ends_with_ignore_case(s, ".2bpp")) { return 2; }
+	if (ends_with_ignore_case(s, ".4bpp")) { return 4; }
+	if (ends_with_ignore_case(s, ".8bpp")) { return 8; }
+	return 0;
+}
 
-	Fl_Image_Surface *surface = new Fl_Image_Surface(TILE_SIZE, (int)_num_tiles * TILE_SIZE);
-	surface->set_current();
+Tileset::Result Tileset::write_tile_data(const char *f, const std::vector<uchar> &pixels, Tile_Layout layout) {
+	int bpp = tile_data_bpp(f);
+	if (!bpp) { return Result::TILESET_BAD_EXT; }
+	if (pixels.size() % NUM_TILE_PIXELS) { return Result::TILESET_BAD_DIMS; }
+	if (std::any_of(RANGE(pixels), [bpp](uchar c) { return bpp < 8 && c >> bpp; })) {
+		return Result::TILESET_TOO_MANY_COLORS;
+	}
 
-	Hue row[TILE_SIZE] = {};
-	for (size_t i = 0; i < _num_tiles; i++) {
-		for (size_t j = 0; j < TILE_SIZE; j++) {
-			uchar b1 = data[i * BYTES_PER_2BPP_TILE + j * 2];
-			uchar b2 = data[i * BYTES_PER_2BPP_TILE + j * 2 + 1];
-			convert_2bpp_row(b1, b2, row);
-			for (int k = 0; k < TILE_SIZE; k++) {
-				Hue hue = row[k];
-				fl_color(hue_colors[(int)hue]);
-				fl_point(k, (int)(i * TILE_SIZE + j));
-			}
+	if (bpp < 4) { layout = Tile_Layout::PLANAR; }
+	size_t n = pixels.size() / NUM_TILE_PIXELS, bytes_per_tile = BYTES_PER_1BPP_TILE * bpp;
+	std::vector<uchar> data(n * bytes_per_tile);
+	for (size_t i = 0; i < n; i++) {
+		for (int y = 0; y < TILE_SIZE; y++) {
+			encode_tile_row(data.data() + i * bytes_per_tile, bpp, layout, y, pixels.data() + i * NUM_TILE_PIXELS + y * TILE_SIZE);
 		}
 	}
 
-	Fl_RGB_Image *img = surface->image();
-	delete surface;
-	Fl_Display_Device::display_device()->set_current();
+	// Compress the same way read_tile_data decompresses
+	if (ends_with_ignore_case(f, ".lz")) {
+		std::vector<uchar> lz_data;
+		Lz::Result r = bpp < 4 ? Lz::compress_crystal(data, lz_data) : Lz::compress_gba(data, lz_data);
+		if (r != Lz::Result::LZ_OK) { return Result::TILESET_TOO_LARGE; }
+		data.swap(lz_data);
+	}
 
-	return postprocess_graphics(img);
+	FILE *file = fl_fopen(f, "wb");
+	if (!file) { return Result::TILESET_BAD_FILE; }
+	size_t w = fwrite(data.data(), 1, data.size(), file);
+	fclose(file);
+	return w == data.size() ? Result::TILESET_OK : Result::TILESET_BAD_FILE;
 }
 
-static Fl_Color bpp4_colors[16] = {
-	fl_rgb_color(0xFF), fl_rgb_color(0xEE), fl_rgb_color(0xDD), fl_rgb_color(0xCC),
-	fl_rgb_color(0xBB), fl_rgb_color(0xAA), fl_rgb_color(0x99), fl_rgb_color(0x88),
-	fl_rgb_color(0x77), fl_rgb_color(0x66), fl_rgb_color(0x55), fl_rgb_color(0x44),
-	fl_rgb_color(0x33), fl_rgb_color(0x22), fl_rgb_color(0x11), fl_rgb_color(0x00)
-};
+Tileset::Result Tileset::parse_tile_data(std::vector<uchar> &data, size_t bytes_per_tile, const Context &ctx) {
+	int bpp = (int)(bytes_per_tile / BYTES_PER_1BPP_TILE);
+	if (bytes_per_tile % BYTES_PER_1BPP_TILE || (bpp != 1 && bpp != 2 && bpp != 4 && bpp != 8)) {
+		return (_result = Result::TILESET_BAD_FILE);
+	}
 
-Tileset::Result Tileset::parse_4bpp_data(const std::vector<uchar> &data) {
-	_num_tiles = data.size() / BYTES_PER_4BPP_TILE;
+	_num_tiles = data.size() / bytes_per_tile;
 
 	int limit = (int)_num_tiles - _offset;
 	if (_length > 0) { limit = std::min(limit, _length + _offset); }
 	if (_start_id + limit > MAX_NUM_TILES) { return (_result = Result::TILESET_TOO_LARGE); }
 
-	Fl_Image_Surface *surface = new Fl_Image_Surface(TILE_SIZE, (int)_num_tiles * TILE_SIZE);
-	surface->set_current();
+	uchar *pixels = new_tile_column(_num_tiles);
 
 	for (size_t i = 0; i < _num_tiles; i++) {
-		for (size_t j = 0; j < TILE_SIZE; j++) {
-			int py = (int)(i * TILE_SIZE + j);
-			for (int k = 0; k < TILE_SIZE / 2; k++) {
-				uchar b = data[i * BYTES_PER_4BPP_TILE + j * TILE_SIZE / 2 + k];
-				fl_color(bpp4_colors[LO_NYB(b)]);
-				fl_point(k * 2, py);
-				fl_color(bpp4_colors[HI_NYB(b)]);
-				fl_point(k * 2 + 1, py);
-			}
-		}
+		decode_tile(data.data(), i, bpp, _layout, pixels);
 	}
 
-	Fl_RGB_Image *img = surface->image();
-	delete surface;
-	Fl_Display_Device::display_device()->set_current();
-
-	return postprocess_graphics(img);
+	// Keep the data so a reload can tell which tiles changed
+	if (postprocess_graphics(tile_column_image(pixels, _num_tiles), ctx) == Result::TILESET_OK) {
+		_data.swap(data);
+		_bytes_per_tile = bytes_per_tile;
+	}
+	return _result;
 }
 
-Tileset::Result Tileset::parse_8bpp_data(const std::vector<uchar> &data) {
-	_num_tiles = data.size() / BYTES_PER_8BPP_TILE;
-
-	int limit = (int)_num_tiles - _offset;
-	if (_length > 0) { limit = std::min(limit, _length + _offset); }
-	if (_start_id + limit > MAX_NUM_TILES) { return (_result = Result::TILESET_TOO_LARGE); }
-
-	Fl_Image_Surface *surface = new Fl_Image_Surface(TILE_SIZE, (int)_num_tiles * TILE_SIZE);
-	surface->set_current();
-
-	for (size_t i = 0; i < _num_tiles; i++) {
-		for (size_t j = 0; j < TILE_SIZE; j++) {
-			int py = (int)(i * TILE_SIZE + j);
-			for (int k = 0; k < TILE_SIZE; k++) {
-				uchar b = data[i * BYTES_PER_8BPP_TILE + j * TILE_SIZE + k];
-				fl_color(0xFF-b, 0xFF-b, 0xFF-b);
-				fl_point(k, py);
-			}
+// Scales tile i of a column the same way Fl_RGB_Image::copy does at a whole-number zoom
+static void scale_tile(const Fl_RGB_Image *src, Fl_RGB_Image *dst, size_t i) {
+	int z = dst->w() / src->w(), d = src->d(), s = TILE_SIZE * z;
+	int sld = src->ld() ? src->ld() : src->w() * d, dld = dst->ld() ? dst->ld() : dst->w() * d;
+	const uchar *sp = (const uchar *)src->data()[0] + i * TILE_SIZE * sld;
+	uchar *dp = (uchar *)dst->data()[0] + i * s * dld;
+	for (int y = 0; y < s; y++) {
+		for (int x = 0; x < s; x++) {
+			std::copy_n(sp + y / z * sld + x / z * d, d, dp + y * dld + x * d);
 		}
 	}
+}
 
-	Fl_RGB_Image *img = surface->image();
-	delete surface;
-	Fl_Display_Device::display_device()->set_current();
-
-	return postprocess_graphics(img);
+void Tileset::patch_tile_data(const std::vector<uchar> &data) {
+	int bpp = (int)(_bytes_per_tile / BYTES_PER_1BPP_TILE);
+	uchar *pixels = (uchar *)_1x_image->data()[0];
+	bool changed = false;
+	for (size_t i = 0; i < _num_tiles; i++) {
+		const uchar *tile = data.data() + i * _bytes_per_tile;
+		if (std::equal(tile, tile + _bytes_per_tile, _data.data() + i * _bytes_per_tile)) { continue; }
+		decode_tile(data.data(), i, bpp, _layout, pixels);
+		scale_tile(_1x_image, _2x_image, i);
+		scale_tile(_1x_image, _zoomed_image, i);
+		changed = true;
+	}
+	if (changed) {
+		_1x_image->uncache();
+		_2x_image->uncache();
+		_zoomed_image->uncache();
+	}
 }
 
-Tileset::Result Tileset::read_rgcn_graphics(const char *f) {
+static Tileset::Result read_rgcn_data(const char *f, std::vector<uchar> &data, size_t &bytes_per_tile) {
 	FILE *file = fl_fopen(f, "rb");
-	if (!file) { return (_result = Result::TILESET_BAD_FILE); }
+	if (!file) { return Tileset::Result::TILESET_BAD_FILE; }
 
 	// <https://www.romhacking.net/documents/%5B469%5Dnds_formats.htm#NCGR>
 	// <https://github.com/pleonex/tinke/blob/master/Plugins/Images/Images/NCGR.cs>
@@ -399,21 +531,21 @@ Tileset::Result Tileset::read_rgcn_graphics(const char *f) {
 	else if (depth == 2) { bpp = BYTES_PER_2BPP_TILE; }
 	else if (depth == 3) { bpp = BYTES_PER_4BPP_TILE; }
 	else if (depth == 4) { bpp = BYTES_PER_8BPP_TILE; }
-	else { fclose(file); return (_result = Result::TILESET_BAD_FILE); }
+	else { fclose(file); return Tileset::Result::TILESET_BAD_FILE; }
 
 	fseek(file, 3 + 4 + 4 + 4 + 4, SEEK_CUR); // skip padding, tile form flag, tile data size, padding
 
 	size_t n = tw * th * bpp;
-	std::vector<uchar> data(n);
+	data.resize(n);
 	size_t r = fread(data.data(), 1, n, file);
 	fclose(file);
-	if (r != n) { return (_result = Result::TILESET_BAD_FILE); }
+	if (r != n) { return Tileset::Result::TILESET_BAD_FILE; }
 
-	return bpp == BYTES_PER_2BPP_TILE ? parse_2bpp_data(data) : bpp == BYTES_PER_4BPP_TILE ? parse_4bpp_data(data) :
-		bpp == BYTES_PER_8BPP_TILE ? parse_8bpp_data(data) : parse_1bpp_data(data);
+	bytes_per_tile = bpp;
+	return Tileset::Result::TILESET_OK;
 }
 
-Tileset::Result Tileset::read_rts_graphics(const char *f, bool skip_rmp) {
+Tileset::Result Tileset::read_rts_graphics(const char *f, bool skip_rmp, const Context &ctx) {
 	FILE *file = fl_fopen(f, "rb");
 	if (!file) { return (_result = Result::TILESET_BAD_FILE); }
 
@@ -451,16 +583,16 @@ Tileset::Result Tileset::read_rts_graphics(const char *f, bool skip_rmp) {
 	Fl_RGB_Image *img = new Fl_RGB_Image(bytes, TILE_SIZE, nt * TILE_SIZE, 4);
 	img->alloc_array = 1;
 
-	return postprocess_graphics(img);
+	return postprocess_graphics(img, ctx);
 }
 
-Tileset::Result Tileset::postprocess_graphics(Fl_RGB_Image *img) {
+Tileset::Result Tileset::postprocess_graphics(Fl_RGB_Image *img, const Context &ctx) {
 	if (!img || img->fail()) { return (_result = Result::TILESET_BAD_FILE); }
 
 	_1x_image = img;
 	_2x_image = (Fl_RGB_Image *)img->copy(img->w() * DEFAULT_ZOOM, img->h() * DEFAULT_ZOOM);
 	if (!_2x_image || _2x_image->fail()) { clear(); return (_result = Result::TILESET_BAD_FILE); }
-	update_zoom();
+	update_zoom(ctx.zoom);
 	if (!_zoomed_image || _zoomed_image->fail()) { clear(); return (_result = Result::TILESET_BAD_FILE); }
 
 	int w = _1x_image->w(), h = _1x_image->h();
@@ -493,6 +625,8 @@ const char *Tileset::error_message(Result result) {
 		return "Too many pixels.";
 	case Result::TILESET_BAD_CMD:
 		return "Invalid LZ command.";
+	case Result::TILESET_TOO_MANY_COLORS:
+		return "Too many colors for the bit depth.";
 	case Result::TILESET_NULL:
 		return "No graphics file chosen.";
 	default:
@@ -500,39 +634,7 @@ const char *Tileset::error_message(Result result) {
 	}
 }
 
-// A rundown of Pokemon Crystal's LZ compression scheme:
-enum class Lz_Command {
-	// Control commands occupy bits 5-7.
-	// Bits 0-4 serve as the first parameter n for each command.
-	LZ_LITERAL,   // n values for n bytes
-	LZ_ITERATE,   // one value for n bytes
-	LZ_ALTERNATE, // alternate two values for n bytes
-	LZ_BLANK,     // zero for n bytes
-	// Repeater commands repeat any data that was just decompressed.
-	// They take an additional signed parameter s to mark a relative starting point.
-	// These wrap around (positive from the start, negative from the current position).
-	LZ_REPEAT,    // n bytes starting from s
-	LZ_FLIP,      // n bytes in reverse bit order starting from s
-	LZ_REVERSE,   // n bytes backwards starting from s
-	// The long command is used when 5 bits aren't enough. Bits 2-4 contain a new control code.
-	// Bits 0-1 are appended to a new byte as 8-9, allowing a 10-bit parameter.
-	LZ_LONG       // n is now 10 bits for a new control code
-};
-
-// If 0xff is encountered instead of a command, decompression ends.
-#define LZ_END 0xff
-
-static auto bit_flipped = ([]() constexpr {
-	std::array<uchar, 256> a{};
-	for (size_t i = 0; i < a.size(); i++) {
-		for (size_t b = 0; b < 8; b++) {
-			a[i] += ((i >> b) & 1) << (7 - b);
-		}
-	}
-	return a;
-})();
-
-static Tileset::Result decompress_lz_data(const char *f, std::vector<uchar> &data) {
+static Tileset::Result decompress_lz_file(const char *f, std::vector<uchar> &data, bool gba) {
 	FILE *file = fl_fopen(f, "rb");
 	if (!file) { return Tileset::Result::TILESET_BAD_FILE; }
 
@@ -542,84 +644,18 @@ static Tileset::Result decompress_lz_data(const char *f, std::vector<uchar> &dat
 	fclose(file);
 	if (r != n) { return Tileset::Result::TILESET_BAD_FILE; }
 
-	size_t len = 0;
-	for (size_t address = 0, lim = data.size();;) {
-		uchar q[2];
-		int offset;
-		uchar b = lz_data[address++];
-		if (b == LZ_END) { break; }
-		if (len >= lim) { return Tileset::Result::TILESET_TOO_LARGE; }
-		Lz_Command cmd = (Lz_Command)((b & 0xe0) >> 5);
-		int length = 0;
-		if (cmd == Lz_Command::LZ_LONG) {
-			cmd = (Lz_Command)((b & 0x1c) >> 2);
-			length = (int)(b & 0x03) * 0x100;
-			b = lz_data[address++];
-			length += (int)b + 1;
-		}
-		else {
-			length = (int)(b & 0x1f) + 1;
-		}
-		switch (cmd) {
-		case Lz_Command::LZ_LITERAL:
-			// Copy data directly.
-			for (int i = 0; i < length; i++) {
-				data[len++] = lz_data[address++];
-			}
-			break;
-		case Lz_Command::LZ_ITERATE:
-			// Write one byte repeatedly.
-			b = lz_data[address++];
-			for (int i = 0; i < length; i++) {
-				data[len++] = b;
-			}
-			break;
-		case Lz_Command::LZ_ALTERNATE:
-			// Write alternating bytes.
-			q[0] = lz_data[address++];
-			q[1] = lz_data[address++];
-			// Copy data directly.
-			for (int i = 0; i < length; i++) {
-				data[len++] = q[i & 1];
-			}
-			break;
-		case Lz_Command::LZ_BLANK:
-			// Write zeros.
-			for (int i = 0; i < length; i++) {
-				data[len++] = 0;
-			}
-			break;
-		case Lz_Command::LZ_REPEAT:
-			// Repeat bytes from output.
-			b = lz_data[address++];
-			offset = b >= 0x80 ? (int)len - (int)(b & 0x7f) - 1 : (int)b * 0x100 + lz_data[address++];
-			for (int i = 0; i < length; i++) {
-				data[len++] = data[offset + i];
-			}
-			break;
-		case Lz_Command::LZ_FLIP:
-			// Repeat flipped bytes from output.
-			b = lz_data[address++];
-			offset = b >= 0x80 ? (int)len - (int)(b & 0x7f) - 1 : (int)b * 0x100 + lz_data[address++];
-			for (int i = 0; i < length; i++) {
-				b = data[offset + i];
-				data[len++] = bit_flipped[b];
-			}
-			break;
-		case Lz_Command::LZ_REVERSE:
-			// Repeat reversed bytes from output.
-			b = lz_data[address++];
-			offset = b >= 0x80 ? (int)len - (int)(b & 0x7f) - 1 : (int)b * 0x100 + lz_data[address++];
-			for (int i = 0; i < length; i++) {
-				data[len++] = data[offset - i];
-			}
-			break;
-		case Lz_Command::LZ_LONG:
-		default:
-			return Tileset::Result::TILESET_BAD_CMD;
-		}
+	switch (gba ? Lz::decompress_gba(lz_data, data) : Lz::decompress_crystal(lz_data, data)) {
+	case Lz::Result::LZ_OK:
+		return Tileset::Result::TILESET_OK;
+	case Lz::Result::LZ_TRUNCATED:
+		return Tileset::Result::TILESET_TOO_SHORT;
+	case Lz::Result::LZ_TOO_LARGE:
+		return Tileset::Result::TILESET_TOO_LARGE;
+	case Lz::Result::LZ_BAD_CMD:
+	case Lz::Result::LZ_BAD_OFFSET:
+		return Tileset::Result::TILESET_BAD_CMD;
+	case Lz::Result::LZ_BAD_HEADER:
+	default:
+		return Tileset::Result::TILESET_BAD_FILE;
 	}
-
-	data.resize(len);
-	return Tileset::Result::TILESET_OK;
 }
@@ -8,6 +8,7 @@
 #pragma warning(pop)
 
 #include "utils.h"
+#include "tilemap-format.h"
 #include "tile.h"
 
 #define NUM_HUES 4
@@ -23,48 +24,70 @@
 #define MAX_NUM_TILES 0x800 // max(tileset_sizes) in tilemap-format.cpp
 
 struct Tile_State;
+struct Context;
+
+// How .4bpp and .8bpp tile data orders its pixels; .1bpp and .2bpp tiles are planar on every console
+enum class Tile_Layout { LINEAR, PLANAR, LINEAR_HI_FIRST };
+
+#define NUM_TILE_LAYOUTS 3
+
+const char *tile_layout_name(Tile_Layout layout);
+const char *tile_layout_short_name(Tile_Layout layout);
+// The layout the format's console uses: planar for SGB, SNES, and TG16, linear with the left pixel in the
+// high nybble for Genesis, and linear with it in the low nybble otherwise
+Tile_Layout format_tile_layout(Tilemap_Format fmt);
 
 class Tileset {
 public:
 	enum class Result { TILESET_OK, TILESET_BAD_FILE, TILESET_BAD_EXT, TILESET_BAD_DIMS,
-		TILESET_TOO_SHORT, TILESET_TOO_LARGE, TILESET_BAD_CMD, TILESET_NULL };
+		TILESET_TOO_SHORT, TILESET_TOO_LARGE, TILESET_BAD_CMD, TILESET_TOO_MANY_COLORS, TILESET_NULL };
 private:
 	Fl_RGB_Image *_1x_image, *_2x_image, *_zoomed_image;
 	size_t _num_tiles;
 	int _start_id, _offset, _length;
+	Tile_Layout _layout;
 	Result _result;
+	// What the tiles were read from, so reloading can skip unchanged files and patch changed tiles
+	int64_t _modified;
+	size_t _file_size;
+	std::vector<uchar> _data;
+	size_t _bytes_per_tile;
 public:
-	Tileset(int start_id, int offset, int length);
+	Tileset(int start_id, int offset, int length, Tile_Layout layout = Tile_Layout::LINEAR);
 	~Tileset();
 	inline size_t num_tiles(void) const { return _num_tiles; }
 	inline int start_id(void) const { return _start_id; }
 	inline int offset(void) const { return _offset; }
 	inline int length(void) const { return _length; }
+	inline Tile_Layout layout(void) const { return _layout; }
 	inline Result result(void) const { return _result; }
+	// The raw tile data and the file's signature, for tilesets read from tile data files
+	inline const std::vector<uchar> &data(void) const { return _data; }
+	inline int64_t modified(void) const { return _modified; }
+	inline size_t file_size(void) const { return _file_size; }
 	void clear(void);
-	void update_zoom(void);
+	void update_zoom(int z);
 	void shift(int dn);
 	bool draw_tile(const Tile_State *ts, int x, int y, int z, bool active) const;
 	bool print_tile(const Tile_State *ts, int x, int y, bool active) const;
-	Result read_tiles(const char *f);
+	Fl_RGB_Image *tile_image(const Tile_State *ts, int &tx, int &ty) const;
+	// Decodes 4bpp and 8bpp tiles in this tileset's layout, and scales the tiles to the context's zoom
+	Result read_tiles(const char *f, const Context &ctx);
+	// Rereads the tiles if the file changed, only decoding again the tiles whose data changed
+	Result reload_tiles(const char *f, const Context &ctx);
 private:
-	Result read_png_graphics(const char *f);
-	Result read_gif_graphics(const char *f);
-	Result read_bmp_graphics(const char *f);
-	Result read_1bpp_graphics(const char *f);
-	Result read_2bpp_graphics(const char *f);
-	Result read_4bpp_graphics(const char *f);
-	Result read_8bpp_graphics(const char *f);
-	Result read_1bpp_lz_graphics(const char *f);
-	Result read_2bpp_lz_graphics(const char *f);
-	Result read_rgcn_graphics(const char *f);
-	Result read_rts_graphics(const char *f, bool skip_rmp);
-	Result parse_1bpp_data(const std::vector<uchar> &data);
-	Result parse_2bpp_data(const std::vector<uchar> &data);
-	Result parse_4bpp_data(const std::vector<uchar> &data);
-	Result parse_8bpp_data(const std::vector<uchar> &data);
-	Result postprocess_graphics(Fl_RGB_Image *img);
+	void clear_graphics(void);
+	Result read_png_graphics(const char *f, const Context &ctx);
+	Result read_gif_graphics(const char *f, const Context &ctx);
+	Result read_bmp_graphics(const char *f, const Context &ctx);
+	Result read_rts_graphics(const char *f, bool skip_rmp, const Context &ctx);
+	Result parse_tile_data(std::vector<uchar> &data, size_t bytes_per_tile, const Context &ctx);
+	Result postprocess_graphics(Fl_RGB_Image *img, const Context &ctx);
+	void patch_tile_data(const std::vector<uchar> &data);
 public:
+	static Result read_tile_data(const char *f, std::vector<uchar> &data, size_t &bytes_per_tile);
+	static int tile_data_bpp(const char *f);
+	static Result write_tile_data(const char *f, const std::vector<uchar> &pixels, Tile_Layout layout);
 	static const char *error_message(Result result);
 };
 
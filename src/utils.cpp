@@ -12,22 +12,6 @@
 
 #include "utils.h"
 
-static bool cmp_ignore_case(const char &a, const char &b) {
-	return tolower(a) == tolower(b);
-}
-
-bool starts_with_ignore_case(std::string_view s, std::string_view p) {
-	if (s.size() < p.size()) { return false; }
-	std::string_view ss = s.substr(0, p.size());
-	return std::equal(RANGE(ss), RANGE(p), cmp_ignore_case);
-}
-
-bool ends_with_ignore_case(std::string_view s, std::string_view p) {
-	if (s.size() < p.size()) { return false; }
-	std::string_view ss = s.substr(s.size() - p.size());
-	return std::equal(RANGE(ss), RANGE(p), cmp_ignore_case);
-}
-
 void add_dot_ext(const char *f, const char *ext, char *s) {
 	strcpy(s, f);
 	const char *e = fl_filename_ext(s);
@@ -52,6 +36,19 @@ size_t file_size(const char *f) {
 	return r ? 0 : (size_t)s.st_size;
 }
 
+int64_t file_modified(const char *f) {
+	struct stat s;
+	if (fl_stat(f, &s)) { return 0; }
+	// Nanoseconds where available, so two saves in the same second still differ
+#if defined(__linux__)
+	return (int64_t)s.st_mtim.tv_sec * 1000000000 + s.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+	return (int64_t)s.st_mtimespec.tv_sec * 1000000000 + s.st_mtimespec.tv_nsec;
+#else
+	return (int64_t)s.st_mtime * 1000000000;
+#endif
+}
+
 size_t file_size(FILE *f) {
 #ifdef __CYGWIN__
 #define stat64 stat
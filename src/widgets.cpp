@@ -536,6 +536,12 @@ Workspace::Workspace(int x, int y, int w, int h, const char *l) : OS_Scroll(x, y
 	color(FL_INACTIVE_COLOR);
 }
 
+void Workspace::scroll_clamped(int x, int y) {
+	int max_x = std::max(_content_w - w() + (has_y_scroll() ? Fl::scrollbar_size() : 0) + Fl::box_dw(box()), 0);
+	int max_y = std::max(_content_h - h() + (has_x_scroll() ? Fl::scrollbar_size() : 0) + Fl::box_dh(box()), 0);
+	scroll_to(std::clamp(x, 0, max_x), std::clamp(y, 0, max_y));
+}
+
 int Workspace::handle(int event) {
 	if (Droppable::handle(event)) {
 		return 1;
@@ -555,10 +561,7 @@ int Workspace::handle(int event) {
 		return 1;
 	case FL_DRAG:
 		int dx = Fl::event_x(), dy = Fl::event_y();
-		int nx = _ox + (_cx - dx), ny = _oy + (_cy - dy);
-		int max_x = std::max(_content_w - w() + (has_y_scroll() ? Fl::scrollbar_size() : 0) + Fl::box_dw(box()), 0);
-		int max_y = std::max(_content_h - h() + (has_x_scroll() ? Fl::scrollbar_size() : 0) + Fl::box_dh(box()), 0);
-		scroll_to(std::clamp(nx, 0, max_x), std::clamp(ny, 0, max_y));
+		scroll_clamped(_ox + (_cx - dx), _oy + (_cy - dy));
 		return 1;
 	}
 	return Fl_Scroll::handle(event);
@@ -213,6 +213,7 @@ public:
 	inline void contents(int w, int h) { _content_w = w; _content_h = h; }
 	inline bool has_x_scroll(void) const { return !!hscrollbar.visible(); }
 	inline bool has_y_scroll(void) const { return !!scrollbar.visible(); }
+	void scroll_clamped(int x, int y);
 	int handle(int event);
 };
 